@@ -1,5 +1,7 @@
 # Core
 
+option(LUASTG_RENDERER_INDEX32 "Use 32-bit indices in the renderer, lifts the 65536 vertices limit per draw" ON)
+
 add_library(Core STATIC)
 
 luastg_target_common_options(Core)
@@ -8,6 +10,10 @@ target_compile_definitions(Core PRIVATE
     LUASTG_CORE_USING_IMGUI
     MA_USE_STDINT
 )
+target_compile_definitions(Core PUBLIC
+    $<$<NOT:$<CONFIG:Release,MinSizeRel>>:LUASTG_RENDERER_STATISTICS> # per-frame renderer counters
+    $<$<BOOL:${LUASTG_RENDERER_INDEX32}>:LUASTG_RENDERER_INDEX32>
+)
 target_include_directories(Core PUBLIC
     .
     ${CMAKE_BINARY_DIR}/include/minizip
@@ -35,16 +41,36 @@ set(Core_SRC
     Core/Graphics/Window_SDL.hpp
     Core/Graphics/Window_SDL.cpp
     Core/Graphics/Format.hpp
+    Core/Graphics/TextureImage.hpp
+    Core/Graphics/TextureImage.cpp
     Core/Graphics/Device.hpp
     Core/Graphics/Device_OpenGL.hpp
     Core/Graphics/Device_OpenGL.cpp
+    Core/Graphics/Device_Null.hpp
+    Core/Graphics/Device_Null.cpp
     Core/Graphics/SwapChain.hpp
     Core/Graphics/SwapChain_OpenGL.hpp
     Core/Graphics/SwapChain_OpenGL.cpp
+    Core/Graphics/SwapChain_Null.hpp
+    Core/Graphics/SwapChain_Null.cpp
     Core/Graphics/Renderer.hpp
+    Core/Graphics/DrawBatch.hpp
+    Core/Graphics/DrawBatch.cpp
     Core/Graphics/Renderer_OpenGL.hpp
     Core/Graphics/Renderer_OpenGL.cpp
     Core/Graphics/Renderer_Shader_OpenGL.cpp
+    Core/Graphics/GpuTimer_OpenGL.hpp
+    Core/Graphics/GpuTimer_OpenGL.cpp
+    Core/Graphics/ProgramCache_OpenGL.hpp
+    Core/Graphics/ProgramCache_OpenGL.cpp
+    Core/Graphics/ImageSaveQueue_OpenGL.hpp
+    Core/Graphics/ImageSaveQueue_OpenGL.cpp
+    Core/Graphics/FrameCapture_OpenGL.hpp
+    Core/Graphics/FrameCapture_OpenGL.cpp
+    Core/Graphics/TextureLoadQueue_OpenGL.hpp
+    Core/Graphics/TextureLoadQueue_OpenGL.cpp
+    Core/Graphics/Renderer_Null.hpp
+    Core/Graphics/Renderer_Null.cpp
     Core/Graphics/Model_OpenGL.hpp
     Core/Graphics/Model_OpenGL.cpp
     Core/Graphics/Model_Shader_OpenGL.cpp
@@ -84,6 +110,7 @@ target_link_libraries(Core PUBLIC
     implot
     # util
     # utility
+    xxhash
     PlatformAPI
     # gfx
     libqoi
@@ -8,8 +8,36 @@
 
 namespace Core
 {
+    enum class FramePacingMode
+    {
+        Sleep, // sleep until the next frame, wake up is as precise as the OS scheduler
+        Hybrid, // sleep until shortly before the next frame, then spin the rest
+    };
+
+    // Frame times of the recent frames, bucketed
+    struct FrameTimeHistogram
+    {
+        static constexpr size_t bucket_count = 501; // the last bucket holds everything slower
+        static constexpr double bucket_width = 0.0001; // seconds
+
+        uint32_t bucket[bucket_count]{};
+        uint32_t total{};
+    };
+
+    struct FrameTimeStatistics
+    {
+        double p50{}; // seconds
+        double p99{};
+        double max{};
+        double spin_budget{}; // Hybrid pacing only, time spent spinning before each frame
+    };
+
     struct IFrameRateController
     {
+        virtual FramePacingMode getFramePacingMode() = 0;
+        virtual void setFramePacingMode(FramePacingMode mode) = 0;
+        virtual FrameTimeHistogram const& getFrameTimeHistogram() = 0;
+        virtual FrameTimeStatistics getFrameTimeStatistics() = 0;
         virtual double update() = 0;
         virtual uint32_t getTargetFPS() = 0;
         virtual void setTargetFPS(uint32_t target_FPS) = 0;
@@ -36,6 +64,7 @@ namespace Core
         double update_time{};
         double render_time{};
         double present_time{};
+        double present_overlap_time{}; // pipelined present running alongside the next frame
     };
 
     struct FrameRenderStatistics
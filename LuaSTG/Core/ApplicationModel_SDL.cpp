@@ -1,12 +1,15 @@
 ﻿#include "Core/ApplicationModel_SDL.hpp"
 #include "Core/ApplicationModel.hpp"
+#include "Core/InitializeConfigure.hpp"
 // #include "Core/i18n.hpp"
 // #include "Platform/WindowsVersion.hpp"
 // #include "Platform/DetectCPU.hpp"
 #include "TracyOpenGL.hpp"
 #include "SDL.h"
 #include "spdlog/spdlog.h"
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <limits>
 #include <thread>
 
@@ -20,6 +23,50 @@ namespace Core
 	{
 		return fps_[(fps_index_ + std::size(fps_) - 1 - idx) % std::size(fps_)];
 	}
+	void FrameRateController::recordFrameTime(double s)
+	{
+		auto const to_bucket = [](double t) -> size_t
+		{
+			return std::min((size_t)(t / FrameTimeHistogram::bucket_width), FrameTimeHistogram::bucket_count - 1);
+		};
+		if (histogram_.total == std::size(frame_time_))
+		{
+			histogram_.bucket[to_bucket(frame_time_[frame_time_index_])] -= 1;
+		}
+		else
+		{
+			histogram_.total += 1;
+		}
+		frame_time_[frame_time_index_] = (float)s;
+		frame_time_index_ = (frame_time_index_ + 1) % std::size(frame_time_);
+		histogram_.bucket[to_bucket(s)] += 1;
+	}
+	void FrameRateController::waitUntil(TimePoint target)
+	{
+		TimePoint curr = Clock::now();
+		TimePoint const wake = target - std::chrono::duration_cast<Clock::duration>(Duration(spin_budget_));
+		if (wake > curr)
+		{
+			std::this_thread::sleep_for(wake - curr);
+			curr = Clock::now();
+
+			// Grow the budget right away when the OS oversleeps it, shrink it slowly otherwise
+			double const oversleep = Duration(curr - wake).count() * 1.25;
+			if (oversleep > spin_budget_)
+			{
+				spin_budget_ = oversleep;
+			}
+			else
+			{
+				spin_budget_ = spin_budget_ * 0.99 + oversleep * 0.01;
+			}
+			spin_budget_ = std::clamp(spin_budget_, min_spin_budget, max_spin_budget);
+		}
+		while (curr < target)
+		{
+			curr = Clock::now();
+		}
+	}
 
 	double FrameRateController::udateData(TimePoint curr)
 	{
@@ -28,6 +75,7 @@ namespace Core
 		double const s = 1.0 / fps;
 		total_frame_ += 1;
 		total_time_ += s;
+		recordFrameTime(s);
 		fps_[fps_index_] = fps;
 		fps_index_ = (fps_index_ + 1) % std::size(fps_);
 		last_ = curr;
@@ -92,6 +140,12 @@ namespace Core
 		// 	return indexFPS(0);
 		// }
 
+		if (pacing_mode_ == FramePacingMode::Hybrid)
+		{
+			waitUntil(last_ + std::chrono::duration_cast<Clock::duration>(Duration(wait_)));
+			return udateData(Clock::now());
+		}
+
 		// i can't be assed to make a proper solution for
 		// platform framerate discrepancies
 		// so this'll have to do.
@@ -117,6 +171,46 @@ namespace Core
 		return udateData(curr_);
 	}
 
+	FramePacingMode FrameRateController::getFramePacingMode()
+	{
+		return pacing_mode_;
+	}
+	void FrameRateController::setFramePacingMode(FramePacingMode mode)
+	{
+		pacing_mode_ = mode;
+	}
+	FrameTimeStatistics FrameRateController::getFrameTimeStatistics()
+	{
+		FrameTimeStatistics statistics;
+		if (histogram_.total == 0)
+		{
+			return statistics;
+		}
+		// Upper edge of the bucket holding the percentile
+		auto const percentile = [this](double p) -> double
+		{
+			uint32_t const rank = (uint32_t)std::ceil(p * (double)histogram_.total);
+			uint32_t count = 0;
+			for (size_t i = 0; i < FrameTimeHistogram::bucket_count; i += 1)
+			{
+				count += histogram_.bucket[i];
+				if (count >= rank)
+				{
+					return (double)(i + 1) * FrameTimeHistogram::bucket_width;
+				}
+			}
+			return (double)FrameTimeHistogram::bucket_count * FrameTimeHistogram::bucket_width;
+		};
+		statistics.p50 = percentile(0.50);
+		statistics.p99 = percentile(0.99);
+		for (uint32_t i = 0; i < histogram_.total; i += 1)
+		{
+			statistics.max = std::max(statistics.max, (double)frame_time_[i]);
+		}
+		statistics.spin_budget = (pacing_mode_ == FramePacingMode::Hybrid) ? spin_budget_ : 0.0;
+		return statistics;
+	}
+
 	uint32_t FrameRateController::getTargetFPS()
 	{
 		return (uint32_t)target_fps_;
@@ -264,8 +358,6 @@ namespace Core
 		size_t const i = (m_framestate_index + 1) % 2;
 		FrameStatistics& d = m_framestate[i];
 		ScopeTimer gt(d.total_time);
-		// size_t const next_frame_query_index = (m_frame_query_index + 1) % m_frame_query_list.size();
-		// FrameQuery& frame_query = m_frame_query_list[next_frame_query_index];
 		
 		bool update_result = false;
 
@@ -285,11 +377,11 @@ namespace Core
 			ZoneScopedN("OnRender");
 			TracyGpuZone("OnRender");
 			ScopeTimer t(d.render_time);
-			// frame_query.begin();
+			m_renderer->beginGpuFrame();
 			m_swapchain->applyRenderAttachment();
 			m_swapchain->clearRenderAttachment();
 			render_result = m_listener->onRender();
-			// frame_query.end();
+			m_renderer->endGpuFrame();
 		}
 
 		// Present
@@ -301,6 +393,7 @@ namespace Core
 			m_swapchain->present();
 			TracyGpuCollect;
 		}
+		d.present_overlap_time = m_swapchain->getPresentOverlapTime();
 
 		// Wait for next frame
 		{
@@ -311,7 +404,6 @@ namespace Core
 		}
 
 		m_framestate_index = i;
-		// m_frame_query_index = next_frame_query_index;
 		FrameMark;
 	}
 
@@ -321,10 +413,8 @@ namespace Core
 	}
 	FrameRenderStatistics ApplicationModel_SDL::getFrameRenderStatistics()
 	{
-		// FrameQuery& frame_query = m_frame_query_list[m_frame_query_index];
 		FrameRenderStatistics statistics{};
-		// statistics.render_time = frame_query.getTime();
-		statistics.render_time = m_framestate[m_framestate_index].render_time;
+		statistics.render_time = m_renderer->getGpuFrameTime();
 		return statistics;
 	}
 
@@ -338,6 +428,38 @@ namespace Core
 		return runSingleThread();
 	}
 
+	void ApplicationModel_SDL::createOpenGLComponents()
+	{
+		Graphics::Device_OpenGL* p_device = nullptr;
+		if (!Graphics::Device_OpenGL::create(&p_device))
+			throw std::runtime_error("Graphics::Device_OpenGL::create");
+		m_device.attach(p_device);
+		Graphics::SwapChain_OpenGL* p_swapchain = nullptr;
+		if (!Graphics::SwapChain_OpenGL::create(*m_window, p_device, &p_swapchain))
+			throw std::runtime_error("Graphics::SwapChain_OpenGL::create");
+		m_swapchain.attach(p_swapchain);
+		Graphics::Renderer_OpenGL* p_renderer = nullptr;
+		if (!Graphics::Renderer_OpenGL::create(p_device, &p_renderer))
+			throw std::runtime_error("Graphics::Renderer_OpenGL::create");
+		m_renderer.attach(p_renderer);
+	}
+	void ApplicationModel_SDL::createNullComponents()
+	{
+		// CPU-side rendering work only, for benchmarking on machines without a GPU
+		Graphics::Device_Null* p_device = nullptr;
+		if (!Graphics::Device_Null::create(&p_device))
+			throw std::runtime_error("Graphics::Device_Null::create");
+		m_device.attach(p_device);
+		Graphics::SwapChain_Null* p_swapchain = nullptr;
+		if (!Graphics::SwapChain_Null::create(*m_window, p_device, &p_swapchain))
+			throw std::runtime_error("Graphics::SwapChain_Null::create");
+		m_swapchain.attach(p_swapchain);
+		Graphics::Renderer_Null* p_renderer = nullptr;
+		if (!Graphics::Renderer_Null::create(p_device, &p_renderer))
+			throw std::runtime_error("Graphics::Renderer_Null::create");
+		m_renderer.attach(p_renderer);
+	}
+
 	ApplicationModel_SDL::ApplicationModel_SDL(IApplicationEventListener* p_listener)
 		: m_listener(p_listener)
 	{
@@ -357,18 +479,16 @@ namespace Core
 		if (!Graphics::Window_SDL::create(~m_window))
 			throw std::runtime_error("Graphics::Window_SDL::create");
 		m_window->implSetApplicationModel(this);
-		if (!Graphics::Device_OpenGL::create(~m_device))
-			throw std::runtime_error("Graphics::Device_OpenGL::create");
-		if (!Graphics::SwapChain_OpenGL::create(*m_window, *m_device, ~m_swapchain))
-			throw std::runtime_error("Graphics::SwapChain_OpenGL::create");
-		if (!Graphics::Renderer_OpenGL::create(*m_device, ~m_renderer))
-			throw std::runtime_error("Graphics::Renderer_OpenGL::create");
+		InitializeConfigure config;
+		config.loadFromFile("config.json");
+		if (config.target_graphics_device == "null")
+			createNullComponents();
+		else
+			createOpenGLComponents();
+		if (config.frame_pacing_hybrid_enable)
+			m_frame_rate_controller.setFramePacingMode(FramePacingMode::Hybrid);
 		if (!Audio::Device_SDL::create(~m_audiosys))
 			throw std::runtime_error("Audio::Device_SDL::create");
-		// m_frame_query_list.reserve(2);
-		// for (int i = 0; i < 2; i += 1) {
-		// 	m_frame_query_list.emplace_back(m_device.get());
-		// }
 	}
 	ApplicationModel_SDL::~ApplicationModel_SDL()
 	{
@@ -5,6 +5,9 @@
 #include "Core/Graphics/Device_OpenGL.hpp"
 #include "Core/Graphics/SwapChain_OpenGL.hpp"
 #include "Core/Graphics/Renderer_OpenGL.hpp"
+#include "Core/Graphics/Device_Null.hpp"
+#include "Core/Graphics/SwapChain_Null.hpp"
+#include "Core/Graphics/Renderer_Null.hpp"
 #include "Core/Audio/Device_SDL.hpp"
 #include <chrono>
 
@@ -15,12 +18,20 @@ namespace Core
 	{
 	private:
 		using Duration = std::chrono::duration<double>;
-		using Clock = std::chrono::high_resolution_clock;
+		using Clock = std::chrono::steady_clock;
 		using TimePoint = std::chrono::time_point<Clock>;
+	private:
+		static constexpr double min_spin_budget = 0.0002;
+		static constexpr double max_spin_budget = 0.004;
 	private:
 		// int64_t freq_{};
 		TimePoint last_{};
 		double wait_{};
+		FramePacingMode pacing_mode_{ FramePacingMode::Sleep }; // hybrid spins, opt in from config.json or Lua
+		double spin_budget_{ 0.001 }; // follows the observed oversleep
+		float frame_time_[1024]{}; // feeds the histogram
+		size_t frame_time_index_{};
+		FrameTimeHistogram histogram_;
 		// int64_t _2ms_{};
 		uint64_t total_frame_{};
 		double total_time_{};
@@ -32,11 +43,17 @@ namespace Core
 		size_t fps_index_{};
 	private:
 		double indexFPS(size_t idx);
+		void recordFrameTime(double s);
+		void waitUntil(TimePoint target);
 	public:
 		double udateData(TimePoint curr);
 		bool arrive();
 		double update();
 	public:
+		FramePacingMode getFramePacingMode();
+		void setFramePacingMode(FramePacingMode mode);
+		FrameTimeHistogram const& getFrameTimeHistogram() { return histogram_; }
+		FrameTimeStatistics getFrameTimeStatistics();
 		uint32_t getTargetFPS();
 		void setTargetFPS(uint32_t target_FPS);
 		double getFPS();
@@ -61,9 +78,9 @@ namespace Core
 
 		// Work thread exclusive
 
-		ScopeObject<Graphics::Device_OpenGL> m_device;
-		ScopeObject<Graphics::SwapChain_OpenGL> m_swapchain;
-		ScopeObject<Graphics::Renderer_OpenGL> m_renderer;
+		ScopeObject<Graphics::IDevice> m_device;
+		ScopeObject<Graphics::ISwapChain> m_swapchain;
+		ScopeObject<Graphics::IRenderer> m_renderer;
 		ScopeObject<Audio::Device_SDL> m_audiosys;
 		FrameRateController m_frame_rate_controller;
 		IApplicationEventListener* m_listener{ nullptr };
@@ -71,6 +88,8 @@ namespace Core
 		FrameStatistics m_framestate[2]{};
 
 		bool runSingleThread();
+		void createOpenGLComponents();
+		void createNullComponents();
 
 	public:
 		// Internal Public
@@ -1,5 +1,6 @@
 ﻿#pragma once
 #include "Core/Type.hpp"
+#include "Core/Graphics/Format.hpp"
 #include <limits>
 #include <optional>
 
@@ -80,6 +81,12 @@ namespace Core::Graphics
         {}
     };
 
+    struct ImageSaveResult
+    {
+        uint64_t id{};
+        bool success{};
+    };
+
     struct ITexture2D : public IObject
     {
         virtual void* getNativeHandle() = 0;
@@ -89,11 +96,18 @@ namespace Core::Graphics
         virtual void setPremultipliedAlpha(bool v) = 0;
         virtual Vector2U getSize() = 0;
         virtual bool setSize(Vector2U size) = 0;
+        virtual Format getFormat() = 0;
+        // Approximate adapter memory of all mip levels
+        virtual size_t getMemoryUsage() = 0;
 
         virtual bool uploadPixelData(RectU rc, void const* data, uint32_t pitch) = 0;
+        // Copy a region of another texture into this (dynamic) texture on the GPU
+        virtual bool copyPixelData(ITexture2D* p_source, RectU src, Vector2U dst) = 0;
         virtual void setPixelData(IData* p_data) = 0;
 
         virtual bool saveToFile(StringView path) = 0;
+        // Returns right away, the result shows up in IDevice::popAsyncSaveResult with the same id
+        virtual bool saveToFileAsync(StringView path, uint64_t* p_id) = 0;
 
         virtual void setSamplerState(SamplerState sampler) = 0;
         virtual std::optional<SamplerState> getSamplerState() = 0;
@@ -130,10 +144,23 @@ namespace Core::Graphics
         virtual bool createTextureFromFile(StringView path, bool mipmap, ITexture2D** pp_texutre) = 0;
         virtual bool createTextureFromMemory(void const* data, size_t size, bool mipmap, ITexture2D** pp_texutre) = 0;
         virtual bool createTexture(Vector2U size, ITexture2D** pp_texutre) = 0;
+        // Dynamic texture in an uncompressed format, R8G8B8A8_UNORM or R8_UNORM
+        virtual bool createTexture(Vector2U size, Format format, ITexture2D** pp_texutre) = 0;
+        // The file is read right away and decoded on worker threads, the texture is created by
+        // updateAsyncTextureLoad and handed out by popAsyncTextureLoadResult with the same id
+        virtual bool createTextureFromFileAsync(StringView path, bool mipmap, uint64_t* p_id) = 0;
+        // Creates textures from decoded images for at most budget seconds (at least one), call once per frame
+        virtual void updateAsyncTextureLoad(double budget) = 0;
+        // *pp_texture is nullptr when the file couldn't be decoded
+        virtual bool popAsyncTextureLoadResult(uint64_t* p_id, ITexture2D** pp_texture) = 0;
 
         virtual bool createRenderTarget(Vector2U size, IRenderTarget** pp_rt) = 0;
         virtual bool createDepthStencilBuffer(Vector2U size, IDepthStencilBuffer** pp_ds) = 0;
 
+        // Moves finished asynchronous saves along, call once per frame
+        virtual void updateAsyncSave() = 0;
+        virtual bool popAsyncSaveResult(ImageSaveResult* p_result) = 0;
+
         static bool create(IDevice** p_device);
     };
 }
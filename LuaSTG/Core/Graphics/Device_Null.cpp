@@ -0,0 +1,394 @@
+﻿#include "Core/Graphics/Device_Null.hpp"
+#include "Core/FileManager.hpp"
+#include "Core/Object.hpp"
+#include "Core/Type.hpp"
+#include "Core/Graphics/TextureImage.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "spdlog/spdlog.h"
+#include "stb_image.h"
+
+namespace Core::Graphics
+{
+	Device_Null::Device_Null()
+	{
+		spdlog::info("[core] created Null Device, nothing will be submitted to the GPU");
+	}
+	Device_Null::~Device_Null()
+	{
+		assert(m_eventobj.size() == 0);
+		assert(m_eventobj_late.size() == 0);
+	}
+
+	void Device_Null::dispatchEvent(EventType t)
+	{
+		// callback
+		m_is_dispatch_event = true;
+		switch (t)
+		{
+		case EventType::DeviceCreate:
+			for (auto& v : m_eventobj)
+			{
+				if (v) v->onDeviceCreate();
+			}
+			break;
+		case EventType::DeviceDestroy:
+			for (auto& v : m_eventobj)
+			{
+				if (v) v->onDeviceDestroy();
+			}
+			break;
+		}
+		m_is_dispatch_event = false;
+		// Dealing with delayed objects
+		removeEventListener(nullptr);
+		for (auto& v : m_eventobj_late)
+		{
+			m_eventobj.emplace_back(v);
+		}
+		m_eventobj_late.clear();
+	}
+
+	void Device_Null::addEventListener(IDeviceEventListener* e)
+	{
+		removeEventListener(e);
+		if (m_is_dispatch_event)
+		{
+			m_eventobj_late.emplace_back(e);
+		}
+		else
+		{
+			m_eventobj.emplace_back(e);
+		}
+	}
+	void Device_Null::removeEventListener(IDeviceEventListener* e)
+	{
+		if (m_is_dispatch_event)
+		{
+			for (auto& v : m_eventobj)
+			{
+				if (v == e)
+				{
+					v = nullptr; // doesn't break traversal
+				}
+			}
+		}
+		else
+		{
+			for (auto it = m_eventobj.begin(); it != m_eventobj.end();)
+			{
+				if (*it == e)
+					it = m_eventobj.erase(it);
+				else
+					it++;
+			}
+		}
+	}
+
+	bool Device_Null::recreate()
+	{
+		dispatchEvent(EventType::DeviceDestroy);
+		dispatchEvent(EventType::DeviceCreate);
+		return true;
+	}
+
+	bool Device_Null::createTextureFromFile(StringView path, bool mipmap, ITexture2D** pp_texture)
+	{
+		std::ignore = mipmap;
+		try
+		{
+			*pp_texture = new Texture2D_Null(this, path);
+			return true;
+		}
+		catch (...)
+		{
+			*pp_texture = nullptr;
+			return false;
+		}
+	}
+	bool Device_Null::createTextureFromFileAsync(StringView path, bool mipmap, uint64_t* p_id)
+	{
+		// Only the image header is read, there is nothing worth moving to another thread
+		ScopeObject<ITexture2D> texture;
+		if (!createTextureFromFile(path, mipmap, ~texture))
+		{
+			return false;
+		}
+		*p_id = m_next_texture_load_id++;
+		m_texture_load_results.emplace_back(*p_id, texture);
+		return true;
+	}
+	bool Device_Null::popAsyncTextureLoadResult(uint64_t* p_id, ITexture2D** pp_texture)
+	{
+		if (m_texture_load_results.empty())
+		{
+			return false;
+		}
+		auto& result = m_texture_load_results.front();
+		*p_id = result.first;
+		*pp_texture = result.second.get();
+		(*pp_texture)->retain();
+		m_texture_load_results.pop_front();
+		return true;
+	}
+	bool Device_Null::createTextureFromMemory(void const* data, size_t size, bool mipmap, ITexture2D** pp_texture)
+	{
+		std::ignore = mipmap;
+		try
+		{
+			*pp_texture = new Texture2D_Null(this, data, size);
+			return true;
+		}
+		catch (...)
+		{
+			*pp_texture = nullptr;
+			return false;
+		}
+	}
+	bool Device_Null::createTexture(Vector2U size, ITexture2D** pp_texture)
+	{
+		try
+		{
+			*pp_texture = new Texture2D_Null(this, size, false);
+			return true;
+		}
+		catch (...)
+		{
+			*pp_texture = nullptr;
+			return false;
+		}
+	}
+	bool Device_Null::createTexture(Vector2U size, Format format, ITexture2D** pp_texture)
+	{
+		try
+		{
+			*pp_texture = new Texture2D_Null(this, size, format);
+			return true;
+		}
+		catch (...)
+		{
+			*pp_texture = nullptr;
+			return false;
+		}
+	}
+
+	bool Device_Null::createRenderTarget(Vector2U size, IRenderTarget** pp_rt)
+	{
+		try
+		{
+			*pp_rt = new RenderTarget_Null(this, size);
+			return true;
+		}
+		catch (...)
+		{
+			*pp_rt = nullptr;
+			return false;
+		}
+	}
+	bool Device_Null::createDepthStencilBuffer(Vector2U size, IDepthStencilBuffer** pp_ds)
+	{
+		try
+		{
+			*pp_ds = new DepthStencilBuffer_Null(this, size);
+			return true;
+		}
+		catch (...)
+		{
+			*pp_ds = nullptr;
+			return false;
+		}
+	}
+
+	bool Device_Null::create(Device_Null** p_device)
+	{
+		try
+		{
+			*p_device = new Device_Null();
+			return true;
+		}
+		catch (...)
+		{
+			*p_device = nullptr;
+			return false;
+		}
+	}
+}
+
+namespace Core::Graphics
+{
+	// Texture2D
+
+	bool Texture2D_Null::readImageSize(uint8_t const* data, size_t size)
+	{
+		// Only the header is parsed, there is nowhere to upload the pixels to
+		if (isTextureContainer(data, size))
+		{
+			TextureImage image;
+			if (!parseTextureContainer(data, size, image))
+			{
+				return false;
+			}
+			m_size = image.size;
+			m_format = image.format;
+			m_memory_usage = 0;
+			for (auto const& level : image.levels)
+			{
+				m_memory_usage += level.size_in_bytes;
+			}
+			return true;
+		}
+		if (size >= 14 && data[0] == 'q' && data[1] == 'o' && data[2] == 'i' && data[3] == 'f')
+		{
+			auto const read_u32_be = [](uint8_t const* p) -> uint32_t
+			{
+				return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+			};
+			m_size.x = read_u32_be(data + 4);
+			m_size.y = read_u32_be(data + 8);
+			m_memory_usage = getLevelSizeInBytes(m_format, m_size);
+			return m_size.x > 0 && m_size.y > 0;
+		}
+		Vector2I image_size;
+		int channels = 0;
+		if (!stbi_info_from_memory(data, (int)size, &image_size.x, &image_size.y, &channels))
+		{
+			return false;
+		}
+		// image size will never be negative
+		m_size.x = image_size.x;
+		m_size.y = image_size.y;
+		m_memory_usage = getLevelSizeInBytes(m_format, m_size);
+		return true;
+	}
+
+	bool Texture2D_Null::setSize(Vector2U size)
+	{
+		if (!(m_dynamic || m_isrt))
+		{
+			spdlog::error("[core] Cannot modify size of static texture");
+			return false;
+		}
+		m_size = size;
+		m_memory_usage = getLevelSizeInBytes(m_format, m_size);
+		return true;
+	}
+
+	bool Texture2D_Null::uploadPixelData(RectU rc, void const* data, uint32_t pitch)
+	{
+		std::ignore = data;
+		std::ignore = pitch;
+		if (!m_dynamic)
+		{
+			return false;
+		}
+		return rc.b.x <= m_size.x && rc.b.y <= m_size.y;
+	}
+
+	bool Texture2D_Null::copyPixelData(ITexture2D* p_source, RectU src, Vector2U dst)
+	{
+		if (!m_dynamic || !p_source)
+		{
+			return false;
+		}
+		if (dst.x + src.width() > m_size.x || dst.y + src.height() > m_size.y)
+		{
+			spdlog::error("[core] Texture copy destination out of range");
+			return false;
+		}
+		return true;
+	}
+
+	bool Texture2D_Null::saveToFile(StringView path)
+	{
+		spdlog::error("[core] Cannot save texture to '{}', the null device has no pixel data", path);
+		return false;
+	}
+	bool Texture2D_Null::saveToFileAsync(StringView path, uint64_t* p_id)
+	{
+		std::ignore = p_id;
+		return saveToFile(path);
+	}
+
+	Texture2D_Null::Texture2D_Null(Device_Null* device, StringView path)
+		: m_device(device)
+	{
+		if (path.empty())
+			throw std::runtime_error("Texture2D::Texture2D(1)");
+		std::vector<uint8_t> src;
+		if (!GFileManager().loadEx(path, src))
+		{
+			spdlog::error("[core] Unable to load file '{}'", path);
+			throw std::runtime_error("Texture2D::Texture2D(2)");
+		}
+		if (!readImageSize(src.data(), src.size()))
+		{
+			spdlog::error("[core] Unable to parse file '{}'", path);
+			throw std::runtime_error("Texture2D::Texture2D(2)");
+		}
+	}
+	Texture2D_Null::Texture2D_Null(Device_Null* device, void const* data, size_t size)
+		: m_device(device)
+	{
+		if (!readImageSize(static_cast<uint8_t const*>(data), size))
+		{
+			spdlog::error("[core] Unable to parse binary data");
+			throw std::runtime_error("Texture2D::Texture2D(2)");
+		}
+	}
+	Texture2D_Null::Texture2D_Null(Device_Null* device, Vector2U size, bool rendertarget)
+		: m_device(device)
+		, m_size(size)
+		, m_dynamic(true)
+		, m_premul(rendertarget)
+		, m_isrt(rendertarget)
+	{
+		m_memory_usage = getLevelSizeInBytes(m_format, m_size);
+	}
+	Texture2D_Null::Texture2D_Null(Device_Null* device, Vector2U size, Format format)
+		: m_device(device)
+		, m_size(size)
+		, m_format(format)
+		, m_dynamic(true)
+	{
+		if (format != Format::R8G8B8A8_UNORM && format != Format::R8_UNORM)
+			throw std::runtime_error("Texture2D::Texture2D(1)");
+		m_memory_usage = getLevelSizeInBytes(m_format, m_size);
+	}
+	Texture2D_Null::~Texture2D_Null()
+	{
+	}
+
+	// DepthStencilBuffer
+
+	DepthStencilBuffer_Null::DepthStencilBuffer_Null(Device_Null* device, Vector2U size)
+		: m_device(device)
+		, m_size(size)
+	{
+	}
+	DepthStencilBuffer_Null::~DepthStencilBuffer_Null()
+	{
+	}
+
+	// RenderTarget
+
+	bool RenderTarget_Null::setSize(Vector2U size)
+	{
+		if (!m_texture->setSize(size)) return false;
+		return m_depthstencilbuffer->setSize(size);
+	}
+
+	RenderTarget_Null::RenderTarget_Null(Device_Null* device, Vector2U size)
+		: m_device(device)
+	{
+		m_texture.attach(new Texture2D_Null(device, size, true));
+		m_depthstencilbuffer.attach(new DepthStencilBuffer_Null(device, size));
+	}
+	RenderTarget_Null::~RenderTarget_Null()
+	{
+	}
+}
@@ -0,0 +1,141 @@
+﻿#pragma once
+#include "Core/Object.hpp"
+#include "Core/Graphics/Device.hpp"
+#include "Core/Type.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <vector>
+
+namespace Core::Graphics
+{
+	// Device without a GPU behind it, resources only keep the metadata the engine asks for
+	class Device_Null : public Object<IDevice>
+	{
+	private:
+		enum class EventType
+		{
+			DeviceCreate,
+			DeviceDestroy,
+		};
+		bool m_is_dispatch_event{ false };
+		std::vector<IDeviceEventListener*> m_eventobj;
+		std::vector<IDeviceEventListener*> m_eventobj_late;
+		uint64_t m_next_texture_load_id{ 1 };
+		std::deque<std::pair<uint64_t, ScopeObject<ITexture2D>>> m_texture_load_results;
+	private:
+		void dispatchEvent(EventType t);
+	public:
+		void addEventListener(IDeviceEventListener* e);
+		void removeEventListener(IDeviceEventListener* e);
+
+		bool recreate();
+
+		void* getNativeHandle() { return nullptr; }
+		void* getNativeRendererHandle() { return nullptr; }
+
+		bool createTextureFromFile(StringView path, bool mipmap, ITexture2D** pp_texutre);
+		bool createTextureFromMemory(void const* data, size_t size, bool mipmap, ITexture2D** pp_texutre);
+		bool createTexture(Vector2U size, ITexture2D** pp_texutre);
+		bool createTexture(Vector2U size, Format format, ITexture2D** pp_texutre);
+		bool createTextureFromFileAsync(StringView path, bool mipmap, uint64_t* p_id);
+		void updateAsyncTextureLoad(double budget) { std::ignore = budget; }
+		bool popAsyncTextureLoadResult(uint64_t* p_id, ITexture2D** pp_texture);
+
+		bool createRenderTarget(Vector2U size, IRenderTarget** pp_rt);
+		bool createDepthStencilBuffer(Vector2U size, IDepthStencilBuffer** pp_ds);
+
+		void updateAsyncSave() {}
+		bool popAsyncSaveResult(ImageSaveResult* p_result) { std::ignore = p_result; return false; }
+
+	public:
+		Device_Null();
+		~Device_Null();
+
+	public:
+		static bool create(Device_Null** p_device);
+	};
+
+	class Texture2D_Null : public Object<ITexture2D>
+	{
+	private:
+		ScopeObject<Device_Null> m_device;
+		std::optional<SamplerState> m_sampler;
+		ScopeObject<IData> m_data;
+		Vector2U m_size{};
+		Format m_format{ Format::R8G8B8A8_UNORM };
+		size_t m_memory_usage{};
+		bool m_dynamic{ false };
+		bool m_premul{ false };
+		bool m_isrt{ false };
+
+		bool readImageSize(uint8_t const* data, size_t size);
+
+	public:
+		void* getNativeHandle() { return nullptr; }
+
+		bool isDynamic() { return m_dynamic; }
+		bool isPremultipliedAlpha() { return m_premul; }
+		void setPremultipliedAlpha(bool v) { m_premul = v; }
+		Vector2U getSize() { return m_size; }
+		bool setSize(Vector2U size);
+		Format getFormat() { return m_format; }
+		size_t getMemoryUsage() { return m_memory_usage; }
+
+		bool uploadPixelData(RectU rc, void const* data, uint32_t pitch);
+		bool copyPixelData(ITexture2D* p_source, RectU src, Vector2U dst);
+		void setPixelData(IData* p_data) { m_data = p_data; }
+
+		bool saveToFile(StringView path);
+		bool saveToFileAsync(StringView path, uint64_t* p_id);
+
+		void setSamplerState(SamplerState sampler) { m_sampler = sampler; }
+		std::optional<SamplerState> getSamplerState() { return m_sampler; }
+
+	public:
+		Texture2D_Null(Device_Null* device, StringView path);
+		Texture2D_Null(Device_Null* device, void const* data, size_t size);
+		Texture2D_Null(Device_Null* device, Vector2U size, bool rendertarget);
+		Texture2D_Null(Device_Null* device, Vector2U size, Format format);
+		~Texture2D_Null();
+	};
+
+	class DepthStencilBuffer_Null : public Object<IDepthStencilBuffer>
+	{
+	private:
+		ScopeObject<Device_Null> m_device;
+		Vector2U m_size{};
+
+	public:
+		void* getNativeHandle() { return nullptr; }
+
+		bool setSize(Vector2U size) { m_size = size; return true; }
+		Vector2U getSize() { return m_size; }
+
+	public:
+		DepthStencilBuffer_Null(Device_Null* device, Vector2U size);
+		~DepthStencilBuffer_Null();
+	};
+
+	class RenderTarget_Null : public Object<IRenderTarget>
+	{
+	private:
+		ScopeObject<Device_Null> m_device;
+		ScopeObject<Texture2D_Null> m_texture;
+		ScopeObject<DepthStencilBuffer_Null> m_depthstencilbuffer;
+
+	public:
+		bool DepthStencilBufferEnabled() { return false; }
+
+	public:
+		void* getNativeHandle() { return nullptr; }
+
+		bool setSize(Vector2U size);
+		ITexture2D* getTexture() { return *m_texture; }
+
+	public:
+		RenderTarget_Null(Device_Null* device, Vector2U size);
+		~RenderTarget_Null();
+	};
+}
@@ -145,6 +145,19 @@ namespace Core::Graphics
 			return false;
 		}
 	}
+	bool Device_OpenGL::createTexture(Vector2U size, Format format, ITexture2D** pp_texture)
+	{
+		try
+		{
+			*pp_texture = new Texture2D_OpenGL(this, size, format);
+			return true;
+		}
+		catch (...)
+		{
+			*pp_texture = nullptr;
+			return false;
+		}
+	}
 
 	bool Device_OpenGL::createRenderTarget(Vector2U size, IRenderTarget** pp_rt)
 	{
@@ -225,24 +238,87 @@ namespace Core::Graphics
 			return false;
 		}
 
+		// The renderer tracks what is bound to each texture unit, leave the binding as it was
+		GLint last_texture = 0;
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
+
 		glBindTexture(GL_TEXTURE_2D, opengl_texture2d);
-		glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / 4);
-		glTexSubImage2D(GL_TEXTURE_2D, 0, rc.a.x, rc.a.y, rc.width(), rc.height(), GL_RGBA, GL_UNSIGNED_BYTE, data);
+		if (m_format == Format::R8_UNORM)
+		{
+			// Rows of a single channel texture are not 4 byte aligned
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, rc.a.x, rc.a.y, rc.width(), rc.height(), GL_RED, GL_UNSIGNED_BYTE, data);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		}
+		else
+		{
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / 4);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, rc.a.x, rc.a.y, rc.width(), rc.height(), GL_RGBA, GL_UNSIGNED_BYTE, data);
+		}
 		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+		glBindTexture(GL_TEXTURE_2D, last_texture);
 		return true;
 	}
 
+	bool Texture2D_OpenGL::copyPixelData(ITexture2D* p_source, RectU src, Vector2U dst)
+	{
+		if (!m_dynamic || !p_source)
+		{
+			return false;
+		}
+		if (dst.x + src.width() > m_size.x || dst.y + src.height() > m_size.y)
+		{
+			spdlog::error("[core] Texture copy destination out of range");
+			return false;
+		}
+
+		GLint last_read_framebuffer = 0;
+		glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &last_read_framebuffer);
+		GLint last_texture = 0;
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
+
+		GLuint read_framebuffer = 0;
+		glGenFramebuffers(1, &read_framebuffer);
+		if (read_framebuffer == 0) {
+			i18n_core_system_call_report_error("glGenFramebuffers");
+			return false;
+		}
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, read_framebuffer);
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, static_cast<Texture2D_OpenGL*>(p_source)->GetResource(), 0);
+		bool const complete = glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+		if (complete)
+		{
+			glReadBuffer(GL_COLOR_ATTACHMENT0);
+			glBindTexture(GL_TEXTURE_2D, opengl_texture2d);
+			glCopyTexSubImage2D(GL_TEXTURE_2D, 0, dst.x, dst.y, src.a.x, src.a.y, src.width(), src.height());
+		}
+
+		glBindTexture(GL_TEXTURE_2D, last_texture);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, last_read_framebuffer);
+		glDeleteFramebuffers(1, &read_framebuffer);
+		return complete;
+	}
+
 	bool Texture2D_OpenGL::saveToFile(StringView path)
 	{
 		std::string spath(path);
 
 		std::unique_ptr<uint8_t> data(new uint8_t[m_size.x * m_size.y * 4]);
 
+		GLint last_texture = 0;
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
 		glBindTexture(GL_TEXTURE_2D, opengl_texture2d);
 		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.get());
+		glBindTexture(GL_TEXTURE_2D, last_texture);
 
 		return (bool)stbi_write_png(spath.c_str(), m_size.x, m_size.y, 4, data.get(), m_size.x * 4);
 	}
+	bool Texture2D_OpenGL::saveToFileAsync(StringView path, uint64_t* p_id)
+	{
+		return m_device->getImageSaveQueue().readback(opengl_texture2d, m_size, path, p_id);
+	}
 
 	void Texture2D_OpenGL::onDeviceCreate()
 	{
@@ -253,31 +329,127 @@ namespace Core::Graphics
 		glDeleteTextures(1, &opengl_texture2d);
 	}
 
-	bool Texture2D_OpenGL::createResource()
+	bool Texture2D_OpenGL::isFormatSupported(Format format)
 	{
-		if (m_data)
+		switch (format)
 		{
-			Vector2I size;
-			uint8_t* data = stbi_load_from_memory((uint8_t*)m_data->data(), m_data->size(), &size.x, &size.y, NULL, 4);
-			if (data == NULL)
+		case Format::BC1_UNORM:
+		case Format::BC3_UNORM:
+			return GLAD_GL_EXT_texture_compression_s3tc != 0;
+		case Format::BC7_UNORM:
+			return GLAD_GL_ARB_texture_compression_bptc != 0;
+		default:
+			return true;
+		}
+	}
+
+	void Texture2D_OpenGL::setupMipChain(size_t level_count)
+	{
+		// Block compressed levels can't be generated, they have to come with the file
+		if (m_mipmap && level_count == 1 && !isBlockCompressed(m_format))
+		{
+			glGenerateMipmap(GL_TEXTURE_2D);
+			m_memory_usage += m_memory_usage / 3; // a full chain adds about a third
+			return;
+		}
+		// Stop the chain at the last uploaded level, otherwise mipmapped samplers see an incomplete texture
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)(level_count - 1));
+	}
+	bool Texture2D_OpenGL::createResourceFromPixels(void const* pixels)
+	{
+		glGenTextures(1, &opengl_texture2d);
+		if (opengl_texture2d == 0) {
+			i18n_core_system_call_report_error("glGenTextures");
+			return false;
+		}
+		m_memory_usage = getLevelSizeInBytes(m_format, m_size);
+		glBindTexture(GL_TEXTURE_2D, opengl_texture2d);
+		if (m_format == Format::R8_UNORM)
+		{
+			// Coverage only, expand to white with the coverage as alpha when sampled
+			GLint const swizzle[4] = { GL_ONE, GL_ONE, GL_ONE, GL_RED };
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, m_size.x, m_size.y, 0, GL_RED, GL_UNSIGNED_BYTE, pixels);
+			glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+		}
+		else
+		{
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_size.x, m_size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		}
+		setupMipChain(1);
+		// glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		// glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+		// glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 4.0f);
+		return true;
+	}
+	bool Texture2D_OpenGL::createResourceFromImage(TextureImage const& image)
+	{
+		// Stored mip levels are a straight copy, without mipmaps only level 0 is worth the memory
+		size_t const level_count = m_mipmap ? image.levels.size() : 1;
+		TextureImage const* p_image = &image;
+		TextureImage decompressed;
+		if (isBlockCompressed(image.format) && !isFormatSupported(image.format))
+		{
+			static bool warned = false;
+			if (!warned)
 			{
-				spdlog::error("[core] Unable to parse binary data");
+				spdlog::warn("[core] Block compressed textures are not supported by the driver, decoding them on the CPU");
+				warned = true;
+			}
+			if (!decompressTextureImage(image, level_count, decompressed))
+			{
+				spdlog::error("[core] Unable to decompress texture");
 				return false;
 			}
-			// image size will never be negative
-			m_size.x = size.x;
-			m_size.y = size.y;
+			p_image = &decompressed;
+		}
 
-			glGenTextures(1, &opengl_texture2d);
-			if (opengl_texture2d == 0) {
-				i18n_core_system_call_report_error("glGenTextures");
-				return false;
+		glGenTextures(1, &opengl_texture2d);
+		if (opengl_texture2d == 0) {
+			i18n_core_system_call_report_error("glGenTextures");
+			return false;
+		}
+		m_size = p_image->size;
+		m_format = p_image->format;
+		m_memory_usage = 0;
+		glBindTexture(GL_TEXTURE_2D, opengl_texture2d);
+		for (size_t i = 0; i < level_count; i += 1)
+		{
+			TextureImage::Level const& level = p_image->levels[i];
+			switch (m_format)
+			{
+			case Format::BC1_UNORM:
+			case Format::BC3_UNORM:
+			case Format::BC7_UNORM:
+			{
+				GLenum const internal_format = m_format == Format::BC1_UNORM ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+					: (m_format == Format::BC3_UNORM ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_BPTC_UNORM_ARB);
+				glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, internal_format, level.size.x, level.size.y, 0, (GLsizei)level.size_in_bytes, level.data);
+				break;
 			}
-			glBindTexture(GL_TEXTURE_2D, opengl_texture2d);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_size.x, m_size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-			glGenerateMipmap(GL_TEXTURE_2D);
+			default:
+				glTexImage2D(GL_TEXTURE_2D, (GLint)i, GL_RGBA, level.size.x, level.size.y, 0, m_format == Format::B8G8R8A8_UNORM ? GL_BGRA : GL_RGBA, GL_UNSIGNED_BYTE, level.data);
+				break;
+			}
+			m_memory_usage += level.size_in_bytes;
+		}
+		setupMipChain(level_count);
+		return true;
+	}
+	bool Texture2D_OpenGL::createResource()
+	{
+		GLint last_texture = 0;
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
 
-			stbi_image_free(data);
+		bool result = false;
+		if (m_data)
+		{
+			TextureImage image;
+			if (!loadTextureImage((uint8_t const*)m_data->data(), m_data->size(), image))
+			{
+				spdlog::error("[core] Unable to parse binary data");
+				return false;
+			}
+			result = createResourceFromImage(image);
 		}
 		else if (!source_path.empty())
 		{
@@ -289,59 +461,21 @@ namespace Core::Graphics
 			}
 
 			// Load pictures
-			Vector2I size;
-			uint8_t* data;
-			if(src[0] ==  'q' && src[1] == 'o' && src[2] == 'i' && src[3] == 'f')
-			{
-				qoi_desc desc;
-				data = (uint8_t*)qoi_decode(src.data(), src.size(), &desc, 4);
-				size.x = desc.width;
-				size.y = desc.height;
-				spdlog::info("[core] Loaded QOI file '{}'", source_path);
-			}
-			else
-			{
-				data = stbi_load_from_memory(src.data(), src.size(), &size.x, &size.y, NULL, 4);
-			}
-
-			if (data == NULL)
+			TextureImage image;
+			if (!loadTextureImage(src.data(), src.size(), image))
 			{
 				spdlog::error("[core] Unable to parse file '{}'", source_path);
 				return false;
 			}
-			// image size will never be negative
-			m_size.x = size.x;
-			m_size.y = size.y;
-
-			glGenTextures(1, &opengl_texture2d);
-			if (opengl_texture2d == 0) {
-				i18n_core_system_call_report_error("glGenTextures");
-				return false;
-			}
-			glBindTexture(GL_TEXTURE_2D, opengl_texture2d);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_size.x, m_size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-			glGenerateMipmap(GL_TEXTURE_2D);
-			// glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			// glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST_MIPMAP_LINEAR);
-			// glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 4.0f);
-			stbi_image_free(data);
+			result = createResourceFromImage(image);
 		}
 		else
 		{
-			glGenTextures(1, &opengl_texture2d);
-			if (opengl_texture2d == 0) {
-				i18n_core_system_call_report_error("glGenTextures");
-				return false;
-			}
-			glBindTexture(GL_TEXTURE_2D, opengl_texture2d);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_size.x, m_size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
-			glGenerateMipmap(GL_TEXTURE_2D);
-			// glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			// glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			// glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 4.0f);
+			result = createResourceFromPixels(nullptr);
 		}
 
-		return true;
+		glBindTexture(GL_TEXTURE_2D, last_texture);
+		return result;
 	}
 
 	Texture2D_OpenGL::Texture2D_OpenGL(Device_OpenGL* device, StringView path, bool mipmap)
@@ -358,6 +492,24 @@ namespace Core::Graphics
 			throw std::runtime_error("Texture2D::Texture2D(2)");
 		m_device->addEventListener(this);
 	}
+	Texture2D_OpenGL::Texture2D_OpenGL(Device_OpenGL* device, StringView path, bool mipmap, TextureImage const& image)
+		: m_device(device)
+		, source_path(path)
+		, m_dynamic(false)
+		, m_premul(false)
+		, m_mipmap(mipmap)
+		, m_isrt(false)
+	{
+		if (path.empty() || image.levels.empty())
+			throw std::runtime_error("Texture2D::Texture2D(1)");
+		GLint last_texture = 0;
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
+		bool const result = createResourceFromImage(image);
+		glBindTexture(GL_TEXTURE_2D, last_texture);
+		if (!result)
+			throw std::runtime_error("Texture2D::Texture2D(2)");
+		m_device->addEventListener(this);
+	}
 	Texture2D_OpenGL::Texture2D_OpenGL(Device_OpenGL* device, void const* data, size_t size, bool mipmap)
 		: m_device(device)
 		, m_dynamic(false)
@@ -387,6 +539,21 @@ namespace Core::Graphics
 		if (!m_isrt)
 			m_device->addEventListener(this);
 	}
+	Texture2D_OpenGL::Texture2D_OpenGL(Device_OpenGL* device, Vector2U size, Format format)
+		: m_device(device)
+		, m_size(size)
+		, m_format(format)
+		, m_dynamic(true)
+		, m_premul(false)
+		, m_mipmap(false)
+		, m_isrt(false)
+	{
+		if (format != Format::R8G8B8A8_UNORM && format != Format::R8_UNORM)
+			throw std::runtime_error("Texture2D::Texture2D(1)");
+		if (!createResource())
+			throw std::runtime_error("Texture2D::Texture2D(2)");
+		m_device->addEventListener(this);
+	}
 	Texture2D_OpenGL::~Texture2D_OpenGL()
 	{
 		if (!m_isrt)
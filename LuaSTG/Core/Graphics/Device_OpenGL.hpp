@@ -1,6 +1,10 @@
 ﻿#pragma once
 #include "Core/Object.hpp"
 #include "Core/Graphics/Device.hpp"
+#include "Core/Graphics/ProgramCache_OpenGL.hpp"
+#include "Core/Graphics/ImageSaveQueue_OpenGL.hpp"
+#include "Core/Graphics/TextureLoadQueue_OpenGL.hpp"
+#include "Core/Graphics/TextureImage.hpp"
 #include "Core/Type.hpp"
 #include "glad/gl.h"
 #include "SDL.h"
@@ -25,6 +29,9 @@ namespace Core::Graphics
 		bool m_is_dispatch_event{ false };
 		std::vector<IDeviceEventListener*> m_eventobj;
 		std::vector<IDeviceEventListener*> m_eventobj_late;
+		ProgramCache_OpenGL m_program_cache;
+		ImageSaveQueue_OpenGL m_image_save_queue;
+		TextureLoadQueue_OpenGL m_texture_load_queue{ this };
 	private:
 		void dispatchEvent(EventType t);
 	public:
@@ -36,13 +43,23 @@ namespace Core::Graphics
 		void* getNativeHandle() { return nullptr; }
 		void* getNativeRendererHandle() { return SDL_GL_GetCurrentContext(); }
 
+		ProgramCache_OpenGL& getProgramCache() noexcept { return m_program_cache; }
+		ImageSaveQueue_OpenGL& getImageSaveQueue() noexcept { return m_image_save_queue; }
+
 		bool createTextureFromFile(StringView path, bool mipmap, ITexture2D** pp_texutre);
 		bool createTextureFromMemory(void const* data, size_t size, bool mipmap, ITexture2D** pp_texutre);
 		bool createTexture(Vector2U size, ITexture2D** pp_texutre);
+		bool createTexture(Vector2U size, Format format, ITexture2D** pp_texutre);
+		bool createTextureFromFileAsync(StringView path, bool mipmap, uint64_t* p_id) { return m_texture_load_queue.load(path, mipmap, p_id); }
+		void updateAsyncTextureLoad(double budget) { m_texture_load_queue.update(budget); }
+		bool popAsyncTextureLoadResult(uint64_t* p_id, ITexture2D** pp_texture) { return m_texture_load_queue.popResult(p_id, pp_texture); }
 
 		bool createRenderTarget(Vector2U size, IRenderTarget** pp_rt);
 		bool createDepthStencilBuffer(Vector2U size, IDepthStencilBuffer** pp_ds);
 
+		void updateAsyncSave() { m_image_save_queue.update(); }
+		bool popAsyncSaveResult(ImageSaveResult* p_result) { return m_image_save_queue.popResult(p_result); }
+
 	public:
 		Device_OpenGL();
 		~Device_OpenGL();
@@ -62,11 +79,17 @@ namespace Core::Graphics
 		std::string source_path;
 		GLuint opengl_texture2d = 0;
 		Vector2U m_size{};
+		Format m_format{ Format::R8G8B8A8_UNORM };
+		size_t m_memory_usage{};
 		bool m_dynamic{ false };
 		bool m_premul{ false };
 		bool m_mipmap{ false };
 		bool m_isrt{ false };
 
+		void setupMipChain(size_t level_count);
+		bool createResourceFromPixels(void const* pixels);
+		bool createResourceFromImage(TextureImage const& image);
+
 	public:
 		void onDeviceCreate();
 		void onDeviceDestroy();
@@ -85,19 +108,29 @@ namespace Core::Graphics
 		void setPremultipliedAlpha(bool v) { m_premul = v; }
 		Vector2U getSize() { return m_size; }
 		bool setSize(Vector2U size);
+		Format getFormat() { return m_format; }
+		size_t getMemoryUsage() { return m_memory_usage; }
 
 		bool uploadPixelData(RectU rc, void const* data, uint32_t pitch);
+		bool copyPixelData(ITexture2D* p_source, RectU src, Vector2U dst);
 		void setPixelData(IData* p_data) { m_data = p_data; }
 
 		bool saveToFile(StringView path);
+		bool saveToFileAsync(StringView path, uint64_t* p_id);
 
 		void setSamplerState(SamplerState sampler) { m_sampler = sampler; }
 		std::optional<SamplerState> getSamplerState() { return m_sampler; }
 
+	public:
+		// Block compressed formats depend on driver extensions, the rest always work
+		static bool isFormatSupported(Format format);
+
 	public:
 		Texture2D_OpenGL(Device_OpenGL* device, StringView path, bool mipmap);
+		Texture2D_OpenGL(Device_OpenGL* device, StringView path, bool mipmap, TextureImage const& image); // already decoded, path is kept for device recreation
 		Texture2D_OpenGL(Device_OpenGL* device, void const* data, size_t size, bool mipmap);
 		Texture2D_OpenGL(Device_OpenGL* device, Vector2U size, bool rendertarget); // if rendertarget, then hand over control to RenderTarget_OpenGL
+		Texture2D_OpenGL(Device_OpenGL* device, Vector2U size, Format format);
 		~Texture2D_OpenGL();
 	};
 
@@ -0,0 +1,361 @@
+﻿#include "Core/Graphics/DrawBatch.hpp"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace Core::Graphics
+{
+    void DrawList::allocate(size_t vertex_capacity, size_t index_capacity, size_t command_capacity)
+    {
+        assert(vertex.size == 0 && index.size == 0 && instance.size == 0 && command.size == 0);
+        vertex.capacity = vertex_capacity;
+        vertex.data.resize(vertex_capacity);
+        slot.used = false;
+        slot.data.resize(vertex_capacity);
+        index.capacity = index_capacity;
+        index.data.resize(index_capacity);
+        command.capacity = command_capacity;
+        command.data.resize(command_capacity);
+    }
+
+    void DrawBatch::allocate(size_t vertex_capacity, size_t index_capacity, size_t command_capacity)
+    {
+        m_draw_list.allocate(vertex_capacity, index_capacity, command_capacity);
+    }
+    void DrawBatch::clear()
+    {
+        for (size_t j_ = 0; j_ < m_draw_list.command.size; j_ += 1)
+        {
+            DrawCommand& cmd_ = m_draw_list.command.data[j_];
+            for (uint8_t t_ = 0; t_ < cmd_.texture_count; t_ += 1)
+            {
+                cmd_.texture[t_].reset();
+            }
+        }
+        m_draw_list.vertex.size = 0;
+        m_draw_list.slot.used = false;
+        m_draw_list.index.size = 0;
+        m_draw_list.instance.size = 0;
+        m_draw_list.command.size = 0;
+    }
+    void DrawBatch::restart()
+    {
+        clear();
+        setTexture(m_texture.get());
+    }
+    bool DrawBatch::grow(size_t nvert, size_t nidx)
+    {
+        if (nvert > DrawList::max_vertex_capacity)
+        {
+            spdlog::error("[core] Unable to draw {} vertices at once, the limit is {}", nvert, DrawList::max_vertex_capacity);
+            return false;
+        }
+        if (nidx > DrawList::max_index_capacity)
+        {
+            spdlog::error("[core] Unable to draw {} indices at once, the limit is {}", nidx, DrawList::max_index_capacity);
+            return false;
+        }
+        if (!m_listener->onDrawBatchFull()) return false;
+
+        size_t vertex_capacity = std::max<size_t>(m_draw_list.vertex.capacity, 1);
+        while (vertex_capacity < nvert) vertex_capacity *= 2;
+        vertex_capacity = std::min(vertex_capacity, DrawList::max_vertex_capacity);
+        size_t index_capacity = std::max<size_t>(m_draw_list.index.capacity, 1);
+        while (index_capacity < nidx) index_capacity *= 2;
+        index_capacity = std::min(index_capacity, DrawList::max_index_capacity);
+
+        clear(); // only the empty command the flush started
+        m_draw_list.allocate(vertex_capacity, index_capacity, m_draw_list.command.capacity);
+        if (!m_listener->onDrawBatchResize()) return false;
+        setTexture(m_texture.get());
+        spdlog::info("[core] Renderer batch grown to {} vertices and {} indices", vertex_capacity, index_capacity);
+        return true;
+    }
+    DrawCommand* DrawBatch::getDrawCommand(DrawCommand::Type type)
+    {
+        assert(m_draw_list.command.size > 0);
+        DrawCommand* cmd_ = &m_draw_list.command.data[m_draw_list.command.size - 1];
+        bool const state_changed_ = m_state_changed && cmd_->state != m_state;
+        bool const single_texture_ = (type == DrawCommand::Type::Instance && cmd_->texture_count > 1); // instances only sample slot 0
+        if ((cmd_->vertex_count > 0 || cmd_->instance_count > 0) && (cmd_->type != type || state_changed_ || single_texture_))
+        {
+            // Quads, instances and indexed geometry are drawn with different calls,
+            // and each command is drawn with the render state it was recorded with
+            if ((m_draw_list.command.capacity - m_draw_list.command.size) < 1)
+            {
+                if (!m_listener->onDrawBatchFull()) return nullptr; // Free up space, also starts a new command
+                assert(m_draw_list.command.size > 0);
+                cmd_ = &m_draw_list.command.data[m_draw_list.command.size - 1];
+            }
+            else
+            {
+                DrawCommand* last_ = cmd_;
+                m_draw_list.command.size += 1;
+                cmd_ = &m_draw_list.command.data[m_draw_list.command.size - 1];
+                if (single_texture_)
+                {
+                    cmd_->texture[0] = last_->texture[m_texture_slot];
+                    cmd_->texture_count = 1;
+                    m_texture_slot = 0;
+                }
+                else
+                {
+                    for (uint8_t t_ = 0; t_ < last_->texture_count; t_ += 1)
+                    {
+                        cmd_->texture[t_] = last_->texture[t_];
+                    }
+                    cmd_->texture_count = last_->texture_count;
+                }
+                cmd_->vertex_count = 0;
+                cmd_->index_count = 0;
+                cmd_->instance_count = 0;
+            }
+        }
+        else if (single_texture_)
+        {
+            // Empty command, drop the textures nobody draws with
+            if (m_texture_slot != 0)
+            {
+                cmd_->texture[0] = cmd_->texture[m_texture_slot];
+            }
+            for (uint8_t t_ = 1; t_ < cmd_->texture_count; t_ += 1)
+            {
+                cmd_->texture[t_].reset();
+            }
+            cmd_->texture_count = 1;
+            m_texture_slot = 0;
+        }
+        if (m_state_changed)
+        {
+            cmd_->state = m_state;
+            m_state_changed = false;
+        }
+        cmd_->type = type;
+        return cmd_;
+    }
+
+    void DrawBatch::setVertexColorBlendState(IRenderer::VertexColorBlendState state)
+    {
+        if (m_state.vertex_color_blend_state != state)
+        {
+            // No flush, the next draw starts a new command if the state really differs
+            m_state.vertex_color_blend_state = state;
+            m_state_changed = true;
+        }
+    }
+    void DrawBatch::setFogState(IRenderer::FogState state, Color4B const& color, float density_or_znear, float zfar)
+    {
+        if (m_state.fog_state != state || m_state.fog_color != color || m_state.fog_near_or_density != density_or_znear || m_state.fog_far != zfar)
+        {
+            m_state.fog_state = state;
+            m_state.fog_color = color;
+            m_state.fog_near_or_density = density_or_znear;
+            m_state.fog_far = zfar;
+            m_state_changed = true;
+        }
+    }
+    void DrawBatch::setDepthState(IRenderer::DepthState state)
+    {
+        if (m_state.depth_state != state)
+        {
+            m_state.depth_state = state;
+            m_state_changed = true;
+        }
+    }
+    void DrawBatch::setBlendState(IRenderer::BlendState state)
+    {
+        if (m_state.blend_state != state)
+        {
+            m_state.blend_state = state;
+            m_state_changed = true;
+        }
+    }
+    void DrawBatch::setTexture(ITexture2D* texture)
+    {
+        if (!texture) return;
+        bool merged_ = false;
+        if (m_draw_list.command.size > 0)
+        {
+            DrawCommand& last_ = m_draw_list.command.data[m_draw_list.command.size - 1];
+            for (uint8_t t_ = 0; t_ < last_.texture_count; t_ += 1)
+            {
+                if (last_.texture[t_].get() == texture)
+                {
+                    // Can merge
+                    m_texture_slot = t_;
+                    merged_ = true;
+                    break;
+                }
+            }
+            if (!merged_
+                && m_texture_batching
+                && last_.type != DrawCommand::Type::Instance
+                && last_.texture_count < DrawCommand::texture_slot_count
+                && last_.texture[0]->isPremultipliedAlpha() == texture->isPremultipliedAlpha())
+            {
+                // Can merge, sample it from the next free slot
+                m_texture_slot = last_.texture_count;
+                last_.texture[m_texture_slot] = texture;
+                last_.texture_count += 1;
+                m_draw_list.slot.used = true;
+                merged_ = true;
+            }
+        }
+        if (!merged_)
+        {
+            // New render command
+            if ((m_draw_list.command.capacity - m_draw_list.command.size) < 1)
+            {
+                m_listener->onDrawBatchFull(); // Free up space
+            }
+            m_draw_list.command.size += 1;
+            DrawCommand& cmd_ = m_draw_list.command.data[m_draw_list.command.size - 1];
+            cmd_.texture[0] = texture;
+            cmd_.texture_count = 1;
+            cmd_.vertex_count = 0;
+            cmd_.index_count = 0;
+            cmd_.instance_count = 0;
+            cmd_.type = DrawCommand::Type::Indexed;
+            cmd_.state = m_state;
+            m_state_changed = false;
+            m_texture_slot = 0;
+        }
+        // Update texture of current state
+        if (m_texture.get() != texture)
+        {
+            m_texture = texture;
+        }
+        // Bound per draw command when the renderer flushes
+    }
+
+    bool DrawBatch::drawTriangle(IRenderer::DrawVertex const& v1, IRenderer::DrawVertex const& v2, IRenderer::DrawVertex const& v3)
+    {
+        if ((m_draw_list.vertex.capacity - m_draw_list.vertex.size) < 3 || (m_draw_list.index.capacity - m_draw_list.index.size) < 3)
+        {
+            if (!m_listener->onDrawBatchFull()) return false;
+        }
+        DrawCommand* cmd_ = getDrawCommand(DrawCommand::Type::Indexed);
+        if (!cmd_) return false;
+        IRenderer::DrawVertex* vbuf_ = m_draw_list.vertex.data.data() + m_draw_list.vertex.size;
+        vbuf_[0] = v1;
+        vbuf_[1] = v2;
+        vbuf_[2] = v3;
+        std::memset(m_draw_list.slot.data.data() + m_draw_list.vertex.size, m_texture_slot, 3);
+        m_draw_list.vertex.size += 3;
+        IRenderer::DrawIndex* ibuf_ = m_draw_list.index.data.data() + m_draw_list.index.size;
+        ibuf_[0] = (IRenderer::DrawIndex)cmd_->vertex_count;
+        ibuf_[1] = (IRenderer::DrawIndex)(cmd_->vertex_count + 1);
+        ibuf_[2] = (IRenderer::DrawIndex)(cmd_->vertex_count + 2);
+        m_draw_list.index.size += 3;
+        cmd_->vertex_count += 3;
+        cmd_->index_count += 3;
+        return true;
+    }
+    bool DrawBatch::drawQuad(IRenderer::DrawVertex const& v1, IRenderer::DrawVertex const& v2, IRenderer::DrawVertex const& v3, IRenderer::DrawVertex const& v4)
+    {
+        if ((m_draw_list.vertex.capacity - m_draw_list.vertex.size) < 4)
+        {
+            if (!m_listener->onDrawBatchFull()) return false;
+        }
+        DrawCommand* cmd_ = getDrawCommand(DrawCommand::Type::Quad);
+        if (!cmd_) return false;
+        IRenderer::DrawVertex* vbuf_ = m_draw_list.vertex.data.data() + m_draw_list.vertex.size;
+        vbuf_[0] = v1;
+        vbuf_[1] = v2;
+        vbuf_[2] = v3;
+        vbuf_[3] = v4;
+        std::memset(m_draw_list.slot.data.data() + m_draw_list.vertex.size, m_texture_slot, 4);
+        m_draw_list.vertex.size += 4;
+        // No index data, the static quad index buffer covers it
+        cmd_->vertex_count += 4;
+        cmd_->index_count += 6;
+        return true;
+    }
+    bool DrawBatch::drawRaw(IRenderer::DrawVertex const* pvert, uint32_t nvert, IRenderer::DrawIndex const* pidx, uint32_t nidx)
+    {
+        if (nvert > m_draw_list.vertex.capacity || nidx > m_draw_list.index.capacity)
+        {
+            if (!grow(nvert, nidx)) return false;
+        }
+        else if ((m_draw_list.vertex.capacity - m_draw_list.vertex.size) < nvert || (m_draw_list.index.capacity - m_draw_list.index.size) < nidx)
+        {
+            if (!m_listener->onDrawBatchFull()) return false;
+        }
+
+        DrawCommand* cmd_ = getDrawCommand(DrawCommand::Type::Indexed);
+        if (!cmd_) return false;
+
+        IRenderer::DrawVertex* vbuf_ = m_draw_list.vertex.data.data() + m_draw_list.vertex.size;
+        std::memcpy(vbuf_, pvert, nvert * sizeof(IRenderer::DrawVertex));
+        std::memset(m_draw_list.slot.data.data() + m_draw_list.vertex.size, m_texture_slot, nvert);
+        m_draw_list.vertex.size += nvert;
+
+        IRenderer::DrawIndex* ibuf_ = m_draw_list.index.data.data() + m_draw_list.index.size;
+        for (size_t idx_ = 0; idx_ < nidx; idx_ += 1)
+        {
+            ibuf_[idx_] = (IRenderer::DrawIndex)(cmd_->vertex_count + pidx[idx_]);
+        }
+        m_draw_list.index.size += nidx;
+
+        cmd_->vertex_count += nvert;
+        cmd_->index_count += nidx;
+
+        return true;
+    }
+    bool DrawBatch::drawRequest(uint32_t nvert, uint32_t nidx, IRenderer::DrawVertex** ppvert, IRenderer::DrawIndex** ppidx, IRenderer::DrawIndex* idxoffset)
+    {
+        if (nvert > m_draw_list.vertex.capacity || nidx > m_draw_list.index.capacity)
+        {
+            if (!grow(nvert, nidx)) return false;
+        }
+        else if ((m_draw_list.vertex.capacity - m_draw_list.vertex.size) < nvert || (m_draw_list.index.capacity - m_draw_list.index.size) < nidx)
+        {
+            if (!m_listener->onDrawBatchFull()) return false;
+        }
+
+        DrawCommand* cmd_ = getDrawCommand(DrawCommand::Type::Indexed);
+        if (!cmd_) return false;
+
+        *ppvert = m_draw_list.vertex.data.data() + m_draw_list.vertex.size;
+        std::memset(m_draw_list.slot.data.data() + m_draw_list.vertex.size, m_texture_slot, nvert);
+        m_draw_list.vertex.size += nvert;
+
+        *ppidx = m_draw_list.index.data.data() + m_draw_list.index.size;
+        m_draw_list.index.size += nidx;
+
+        *idxoffset = (IRenderer::DrawIndex)cmd_->vertex_count; // Output vertex offset
+        cmd_->vertex_count += nvert;
+        cmd_->index_count += nidx;
+
+        return true;
+    }
+    bool DrawBatch::drawInstances(IRenderer::DrawInstance const* pinst, uint16_t ninst)
+    {
+        if (ninst > m_draw_list.instance.capacity)
+        {
+            assert(false); return false;
+        }
+
+        if ((m_draw_list.instance.capacity - m_draw_list.instance.size) < ninst)
+        {
+            if (!m_listener->onDrawBatchFull()) return false;
+        }
+
+        DrawCommand* cmd_ = getDrawCommand(DrawCommand::Type::Instance);
+        if (!cmd_) return false;
+
+        std::memcpy(m_draw_list.instance.data + m_draw_list.instance.size, pinst, ninst * sizeof(IRenderer::DrawInstance));
+        m_draw_list.instance.size += ninst;
+
+        cmd_->instance_count += ninst;
+
+        return true;
+    }
+    bool DrawBatch::canBatchInstance() const noexcept
+    {
+        if (m_draw_list.command.size == 0) return false;
+        DrawCommand const& cmd_ = m_draw_list.command.data[m_draw_list.command.size - 1];
+        return cmd_.type == DrawCommand::Type::Instance || (cmd_.vertex_count == 0 && cmd_.instance_count == 0);
+    }
+}
@@ -0,0 +1,154 @@
+﻿#pragma once
+#include "Core/Object.hpp"
+#include "Core/Graphics/Renderer.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Core::Graphics
+{
+	// Render state recorded per draw command, applied by the renderer at flush time
+	struct DrawState
+	{
+		IRenderer::VertexColorBlendState vertex_color_blend_state = IRenderer::VertexColorBlendState::Mul;
+		IRenderer::FogState fog_state = IRenderer::FogState::Disable;
+		IRenderer::DepthState depth_state = IRenderer::DepthState::Disable;
+		IRenderer::BlendState blend_state = IRenderer::BlendState::Alpha;
+		Color4B fog_color;
+		float fog_near_or_density = 0.0f;
+		float fog_far = 0.0f;
+
+		bool isFogDataEqual(DrawState const& r) const noexcept
+		{
+			return fog_color == r.fog_color
+				&& fog_near_or_density == r.fog_near_or_density
+				&& fog_far == r.fog_far;
+		}
+		bool operator==(DrawState const& r) const noexcept
+		{
+			return vertex_color_blend_state == r.vertex_color_blend_state
+				&& fog_state == r.fog_state
+				&& depth_state == r.depth_state
+				&& blend_state == r.blend_state
+				&& isFogDataEqual(r);
+		}
+		bool operator!=(DrawState const& r) const noexcept { return !(*this == r); }
+	};
+
+	struct DrawCommand
+	{
+		static constexpr uint8_t texture_slot_count = 8; // textures one command can sample from with texture batching
+
+		enum class Type : uint8_t
+		{
+			Indexed,
+			Quad, // quads only, indices come from the static quad index buffer
+			Instance, // sprite instances, expanded by the instanced vertex shader
+		};
+
+		ScopeObject<ITexture2D> texture[texture_slot_count]; // bound to texture units 0..texture_count-1
+		uint8_t texture_count = 1;
+		uint32_t vertex_count = 0;
+		uint32_t index_count = 0;
+		uint32_t instance_count = 0;
+		Type type = Type::Indexed;
+		DrawState state;
+	};
+
+	// Capacities come from config.json (renderer_batch_*_capacity) and grow when one draw doesn't fit
+	struct DrawList
+	{
+		static constexpr size_t max_vertex_capacity = IRenderer::max_draw_vertex_count; // the static quad index buffer has to fit too
+		static constexpr size_t max_index_capacity = 3 * max_vertex_capacity; // a triangle list over every vertex of a full batch
+
+		struct VertexBuffer
+		{
+			size_t capacity = 0;
+			size_t size = 0;
+			std::vector<IRenderer::DrawVertex> data;
+		} vertex;
+		struct TextureSlotBuffer
+		{
+			bool used = false; // some command samples from more than one texture
+			std::vector<uint8_t> data; // one per vertex
+		} slot;
+		struct IndexBuffer
+		{
+			size_t capacity = 0;
+			size_t size = 0;
+			std::vector<IRenderer::DrawIndex> data;
+		} index;
+		struct InstanceBuffer
+		{
+			const size_t capacity = 8192;
+			size_t size = 0;
+			IRenderer::DrawInstance data[8192] = {};
+		} instance;
+		struct DrawCommandBuffer
+		{
+			size_t capacity = 0;
+			size_t size = 0;
+			std::vector<DrawCommand> data;
+		} command;
+
+		// Only while empty
+		void allocate(size_t vertex_capacity, size_t index_capacity, size_t command_capacity);
+	};
+
+	struct IDrawBatchListener
+	{
+		// Submit the draw list to make room, then DrawBatch::restart
+		virtual bool onDrawBatchFull() = 0;
+		// The draw list was reallocated, GPU buffers sized after it have to be created again
+		virtual bool onDrawBatchResize() = 0;
+	};
+
+	// CPU side of batching, shared by every renderer so they record the same commands:
+	// draws are merged into as few commands as the render state and textures allow,
+	// the renderer only submits the draw list
+	class DrawBatch
+	{
+	private:
+		IDrawBatchListener* m_listener;
+		DrawList m_draw_list;
+		DrawState m_state;
+		ScopeObject<ITexture2D> m_texture;
+		uint8_t m_texture_slot = 0; // slot of m_texture in the last draw command
+		bool m_texture_batching = false;
+		bool m_state_changed = true; // m_state may no longer match the last draw command
+
+		DrawCommand* getDrawCommand(DrawCommand::Type type);
+		bool grow(size_t nvert, size_t nidx);
+
+	public:
+		DrawList& getDrawList() noexcept { return m_draw_list; }
+		DrawState const& getDrawState() const noexcept { return m_state; }
+		ITexture2D* getTexture() const noexcept { return m_texture.get(); }
+		void resetTexture() { m_texture.reset(); }
+		// Something else drew in between, the next draw starts from the current state
+		void invalidateState() noexcept { m_state_changed = true; }
+
+		void allocate(size_t vertex_capacity, size_t index_capacity, size_t command_capacity);
+		// Drops every command and releases their textures
+		void clear();
+		// After a flush, starts a new command with the current texture
+		void restart();
+
+		void setVertexColorBlendState(IRenderer::VertexColorBlendState state);
+		void setFogState(IRenderer::FogState state, Color4B const& color, float density_or_znear, float zfar);
+		void setDepthState(IRenderer::DepthState state);
+		void setBlendState(IRenderer::BlendState state);
+		void setTexture(ITexture2D* texture);
+		void setTextureBatching(bool enable) noexcept { m_texture_batching = enable; }
+		bool getTextureBatching() const noexcept { return m_texture_batching; }
+
+		bool drawTriangle(IRenderer::DrawVertex const& v1, IRenderer::DrawVertex const& v2, IRenderer::DrawVertex const& v3);
+		bool drawQuad(IRenderer::DrawVertex const& v1, IRenderer::DrawVertex const& v2, IRenderer::DrawVertex const& v3, IRenderer::DrawVertex const& v4);
+		bool drawRaw(IRenderer::DrawVertex const* pvert, uint32_t nvert, IRenderer::DrawIndex const* pidx, uint32_t nidx);
+		bool drawRequest(uint32_t nvert, uint32_t nidx, IRenderer::DrawVertex** ppvert, IRenderer::DrawIndex** ppidx, IRenderer::DrawIndex* idxoffset);
+		bool drawInstances(IRenderer::DrawInstance const* pinst, uint16_t ninst);
+		bool canBatchInstance() const noexcept;
+
+	public:
+		DrawBatch(IDrawBatchListener* p_listener) : m_listener(p_listener) {}
+	};
+}
@@ -22,6 +22,19 @@ namespace Core::Graphics
 		bool       is_buffer;        // If true, `source` is taken as binary data, not the file path.
 	};
 
+	struct GlyphCacheStatistics
+	{
+		uint64_t hit{};          // Lookups served from the atlas
+		uint64_t miss{};         // Lookups that had to render the glyph
+		uint64_t eviction{};     // Glyphs dropped to make room
+		uint32_t page_count{};   // Atlas pages in use
+		uint32_t page_budget{};  // Most atlas pages allowed
+		size_t   memory_usage{}; // Atlas textures plus their CPU copies, in bytes
+	};
+
+	// Caching may evict glyphs that draws already batched by the renderer still sample.
+	// While isEvictionPending is true, submit those draws before calling flush,
+	// flush overwrites the evicted area of the atlas textures.
 	struct IGlyphManager : public IObject
 	{
 		virtual float getLineHeight() = 0;
@@ -37,6 +50,9 @@ namespace Core::Graphics
 
 		virtual bool getGlyph(uint32_t codepoint, GlyphInfo* p_ref_info, bool no_render) = 0;
 
+		virtual bool isEvictionPending() = 0;
+		virtual GlyphCacheStatistics getCacheStatistics() = 0;
+
 		static bool create(IDevice* p_device, TrueTypeFontInfo* p_arr_info, size_t info_count, IGlyphManager** pp_glyphmgr);
 	};
 
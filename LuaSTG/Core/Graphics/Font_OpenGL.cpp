@@ -1,5 +1,6 @@
 ﻿#include "Core/Graphics/Font_OpenGL.hpp"
 #include "Core/FileManager.hpp"
+#include "Core/InitializeConfigure.hpp"
 #include "spdlog/spdlog.h"
 #include "utility/utf.hpp"
 #include <limits>
@@ -50,19 +51,19 @@ namespace Core::Graphics
     public:
         uint32_t width() const noexcept { return m_bitmap.width; }
         uint32_t height() const noexcept { return m_bitmap.rows; }
-        uint32_t pixel(uint32_t x, uint32_t y) const noexcept
+        uint8_t pixel(uint32_t x, uint32_t y) const noexcept
         {
             if (m_bitmap.pixel_mode == FT_PIXEL_MODE_MONO)
             {
                 auto const line = (uint8_t*)m_bitmap.buffer + (y * m_bitmap.pitch);
                 auto const block = line[x / 8];
                 auto const flag = (1 << (7 - (x % 8))) & block; // 最左边的像素在最高位
-                return flag ? 0xFFFFFFFF : 0x00FFFFFF;
+                return flag ? 0xFF : 0x00;
             }
             else if (m_bitmap.pixel_mode == FT_PIXEL_MODE_GRAY)
             {
                 auto const line = (uint8_t*)m_bitmap.buffer + (y * m_bitmap.pitch);
-                return (line[x] << 24) | 0x00FFFFFF;
+                return line[x];
             }
             return 0;
         }
@@ -97,13 +98,16 @@ namespace Core::Graphics
     }
     void TrueTypeGlyphManager_OpenGL::onDeviceDestroy()
     {
-        // mark all as dirty
+        // mark all shelves as dirty
         for (auto& t : m_tex)
         {
-            t.dirty_l = 0;
-            t.dirty_t = 0;
-            t.dirty_r = t.image.width;
-            t.dirty_b = t.pen_bottom + 1; // one more pixel on the edge
+            if (t->pen_bottom > 0)
+            {
+                t->dirty_l = 0;
+                t->dirty_t = 0;
+                t->dirty_r = t->image.width;
+                t->dirty_b = t->pen_bottom;
+            }
         }
     }
 
@@ -235,15 +239,128 @@ namespace Core::Graphics
     }
     bool TrueTypeGlyphManager_OpenGL::addTexture()
     {
-        m_tex.emplace_back();
-        auto& t = m_tex.back();
-        if (!m_device->createTexture(Vector2U(t.image.width, t.image.height), ~t.texture))
+        auto t = std::make_unique<GlyphCache2D>();
+        if (!m_device->createTexture(Vector2U(t->image.width, t->image.height), Format::R8_UNORM, ~t->texture))
         {
             return false;
         }
-        //t.texture->setPremultipliedAlpha(true); // to support colored text, you must use premultiplied alpha
+        //t->texture->setPremultipliedAlpha(true); // to support colored text, you must use premultiplied alpha
+        m_tex.emplace_back(std::move(t));
         return true;
     }
+    void TrueTypeGlyphManager_OpenGL::evictShelf(GlyphShelf& s)
+    {
+        for (auto const codepoint : s.codepoints)
+        {
+            m_map.erase(codepoint);
+        }
+        m_statistics.eviction += s.codepoints.size();
+        m_eviction_pending = m_eviction_pending || !s.codepoints.empty();
+        s.codepoints.clear();
+        s.pen_x = 1;
+        s.last_use = 0;
+    }
+    void TrueTypeGlyphManager_OpenGL::evictPage(GlyphCache2D& t)
+    {
+        for (auto& s : t.shelves)
+        {
+            evictShelf(s);
+        }
+        t.shelves.clear();
+        t.pen_bottom = 0;
+        t.last_use = 0;
+    }
+    bool TrueTypeGlyphManager_OpenGL::allocateShelf(uint32_t height, uint32_t width, uint32_t& page, uint32_t& shelf)
+    {
+        // leave 1 pixel right edge
+        auto const fits = [&](GlyphShelf const& s) { return s.pen_x + width + 1 <= TEXTURE_SIZE; };
+        auto const openShelf = [&](uint32_t p) -> bool
+        {
+            GlyphCache2D& t = *m_tex[p];
+            if (t.pen_bottom + height > t.image.height)
+            {
+                return false;
+            }
+            GlyphShelf s;
+            s.y = t.pen_bottom;
+            s.height = height;
+            t.pen_bottom += height;
+            t.shelves.emplace_back(std::move(s));
+            page = p;
+            shelf = (uint32_t)(t.shelves.size() - 1);
+            return true;
+        };
+
+        // a shelf of the same height with room left
+        for (uint32_t p = 0; p < (uint32_t)m_tex.size(); p += 1)
+        {
+            auto& shelves = m_tex[p]->shelves;
+            for (uint32_t i = 0; i < (uint32_t)shelves.size(); i += 1)
+            {
+                if (shelves[i].height == height && fits(shelves[i]))
+                {
+                    page = p;
+                    shelf = i;
+                    return true;
+                }
+            }
+        }
+        // a new shelf below the others
+        for (uint32_t p = 0; p < (uint32_t)m_tex.size(); p += 1)
+        {
+            if (openShelf(p))
+            {
+                return true;
+            }
+        }
+        // a new page
+        if (m_tex.size() < m_page_budget)
+        {
+            return addTexture() && openShelf((uint32_t)(m_tex.size() - 1));
+        }
+        // the least recently used shelf of the same height
+        GlyphShelf* lru_shelf = nullptr;
+        for (uint32_t p = 0; p < (uint32_t)m_tex.size(); p += 1)
+        {
+            auto& shelves = m_tex[p]->shelves;
+            for (uint32_t i = 0; i < (uint32_t)shelves.size(); i += 1)
+            {
+                GlyphShelf& s = shelves[i];
+                if (s.height == height && s.last_use != m_epoch && (!lru_shelf || s.last_use < lru_shelf->last_use))
+                {
+                    lru_shelf = &s;
+                    page = p;
+                    shelf = i;
+                }
+            }
+        }
+        if (lru_shelf)
+        {
+            evictShelf(*lru_shelf);
+            return true;
+        }
+        // the least recently used page, when no shelf has the right height
+        uint32_t lru_index = INVALID_SHELF;
+        for (uint32_t p = 0; p < (uint32_t)m_tex.size(); p += 1)
+        {
+            if (m_tex[p]->last_use != m_epoch && (lru_index == INVALID_SHELF || m_tex[p]->last_use < m_tex[lru_index]->last_use))
+            {
+                lru_index = p;
+            }
+        }
+        if (lru_index != INVALID_SHELF)
+        {
+            evictPage(*m_tex[lru_index]);
+            return openShelf(lru_index);
+        }
+        // everything is used by the current text
+        if (!m_budget_warned)
+        {
+            spdlog::warn("[core] Glyph cache is full, the text uses more than {} atlas pages, increase glyph_cache_page_budget", m_page_budget);
+            m_budget_warned = true;
+        }
+        return false;
+    }
     bool TrueTypeGlyphManager_OpenGL::findGlyph(FT_ULong code, FT_Face& face, FT_UInt& index)
     {
         for (auto& f : m_font)
@@ -268,93 +385,70 @@ namespace Core::Graphics
         {
             assert(false); return false;
         }
-        // get a position
-        GlyphCache2D* pt = nullptr;
-        do
+        // empty glyphs (space) take no room
+        if (bitmap.width == 0 || bitmap.rows == 0)
         {
-            for (auto& t : m_tex)
-            {
-                // initialize, leave 1 pixel top-left edge
-                if (t.pen_x == 0 || t.pen_y == 0)
-                {
-                    t.pen_x = 1;
-                    t.pen_y = 1;
-                }
-                // leave 1 pixel on bottom right edge
-                if ((t.pen_x + bitmap.width) < (t.image.width - 1) && (t.pen_y + bitmap.rows) < (t.image.height - 1))
-                {
-                    pt = &t;
-                    break;
-                }
-                // line feed, leaving 1px edge
-                uint32_t const new_pen_x = 1;
-                uint32_t const new_pen_y = std::max(t.pen_y, t.pen_bottom + 1);
-                // leave 1 pixel on bottom right edge
-                if ((new_pen_x + bitmap.width) < (t.image.width - 1) && (new_pen_y + bitmap.rows) < (t.image.height - 1))
-                {
-                    t.pen_x = new_pen_x;
-                    t.pen_y = new_pen_y;
-                    pt = &t;
-                    break;
-                }
-            }
-            if (pt)
-            {
-                break;
-            }
-            else
-            {
-                // it's time for a new texture.
-                if (!addTexture())
-                {
-                    return false;
-                }
-            }
-        } while (!pt);
-        GlyphCache2D& t = *pt;
+            info.texture_index = 0;
+            info.texture_rect = RectF();
+            info.shelf_index = INVALID_SHELF;
+            return true;
+        }
+        // get a position, the shelf leaves 1 pixel top and bottom edge
+        uint32_t const height = ((bitmap.rows + 2 + SHELF_ALIGN - 1) / SHELF_ALIGN) * SHELF_ALIGN;
+        uint32_t page = 0;
+        uint32_t shelf = 0;
+        if (!allocateShelf(height, bitmap.width, page, shelf))
+        {
+            return false;
+        }
+        GlyphCache2D& t = *m_tex[page];
+        GlyphShelf& s = t.shelves[shelf];
+        uint32_t const pen_x = s.pen_x;
+        uint32_t const pen_y = s.y + 1;
         // write to glyph data
-        info.texture_index = (uint32_t)(pt - m_tex.data());
-        info.texture_rect.a.x = (float)t.pen_x / (float)t.image.width;
-        info.texture_rect.a.y = (float)t.pen_y / (float)t.image.height;
-        info.texture_rect.b.x = (float)(t.pen_x + bitmap.width) / (float)t.image.width;
-        info.texture_rect.b.y = (float)(t.pen_y + bitmap.rows) / (float)t.image.height;
+        info.texture_index = page;
+        info.shelf_index = shelf;
+        info.texture_rect.a.x = (float)pen_x / (float)t.image.width;
+        info.texture_rect.a.y = (float)pen_y / (float)t.image.height;
+        info.texture_rect.b.x = (float)(pen_x + bitmap.width) / (float)t.image.width;
+        info.texture_rect.b.y = (float)(pen_y + bitmap.rows) / (float)t.image.height;
         // Write bitmap data with a 1px transparent edge, which is a bit messy, mainly to minimize CPU Cache Miss.
         FT_Bitmap_Accessor accessor(bitmap);
         for (int x = 0; x < (int)(accessor.width() + 2); x += 1) // upper 1px edge is the width of the bitmap plus 2px.
         {
-            t.image.pixel(t.pen_x - 1 + x, t.pen_y - 1) = Color4B(0x00FFFFFF);
+            t.image.pixel(pen_x - 1 + x, pen_y - 1) = 0;
         }
         for (int y = 0; y < (int)accessor.height(); y += 1)
         {
-            t.image.pixel(t.pen_x - 1, t.pen_y + y) = Color4B(0x00FFFFFF); // left 1px wide side
+            t.image.pixel(pen_x - 1, pen_y + y) = 0; // left 1px wide side
             for (int x = 0; x < (int)accessor.width(); x += 1)
             {
-                t.image.pixel(t.pen_x + x, t.pen_y + y) = accessor.pixel(x, y);
+                t.image.pixel(pen_x + x, pen_y + y) = accessor.pixel(x, y);
             }
-            t.image.pixel(t.pen_x + accessor.width(), t.pen_y + y) = Color4B(0x00FFFFFF); // right 1px wide side
+            t.image.pixel(pen_x + accessor.width(), pen_y + y) = 0; // right 1px wide side
         }
         for (int x = 0; x < (int)(accessor.width() + 2); x += 1) // next 1px edge is the width of the bitmap plus 2px.
         {
-            t.image.pixel(t.pen_x - 1 + x, t.pen_y + accessor.height()) = Color4B(0x00FFFFFF);
+            t.image.pixel(pen_x - 1 + x, pen_y + accessor.height()) = 0;
         }
         // update dirty areas
         if (t.dirty_l == INVALID_RECT)
         {
-            t.dirty_l = t.pen_x - 1;
-            t.dirty_t = t.pen_y - 1;
-            t.dirty_r = t.pen_x + bitmap.width + 1;
-            t.dirty_b = t.pen_y + bitmap.rows + 1;
+            t.dirty_l = pen_x - 1;
+            t.dirty_t = pen_y - 1;
+            t.dirty_r = pen_x + bitmap.width + 1;
+            t.dirty_b = pen_y + bitmap.rows + 1;
         }
         else
         {
-            t.dirty_l = std::min(t.dirty_l, t.pen_x - 1);
-            t.dirty_t = std::min(t.dirty_t, t.pen_y - 1);
-            t.dirty_r = std::max(t.dirty_r, t.pen_x + bitmap.width + 1);
-            t.dirty_b = std::max(t.dirty_b, t.pen_y + bitmap.rows + 1);
+            t.dirty_l = std::min(t.dirty_l, pen_x - 1);
+            t.dirty_t = std::min(t.dirty_t, pen_y - 1);
+            t.dirty_r = std::max(t.dirty_r, pen_x + bitmap.width + 1);
+            t.dirty_b = std::max(t.dirty_b, pen_y + bitmap.rows + 1);
         }
-        // update cache
-        t.pen_x += bitmap.width + 1;
-        t.pen_bottom = std::max(t.pen_bottom, t.pen_y + bitmap.rows);
+        // update shelf, the right edge is shared with the next glyph
+        s.pen_x += bitmap.width + 1;
+        s.codepoints.push_back(info.codepoint);
         return true;
     }
     GlyphCacheInfo* TrueTypeGlyphManager_OpenGL::getGlyphCacheInfo(uint32_t codepoint)
@@ -362,16 +456,26 @@ namespace Core::Graphics
         auto it = m_map.find(codepoint);
         if (it != m_map.end())
         {
-            return &it->second;
+            m_statistics.hit += 1;
         }
-        else if (renderCache(codepoint))
+        else
         {
-            return &m_map[codepoint];
+            m_statistics.miss += 1;
+            if (!renderCache(codepoint))
+            {
+                return nullptr;
+            }
+            it = m_map.find(codepoint);
         }
-        else
+        // keep it away from eviction while the current text uses it
+        GlyphCacheInfo& info = it->second;
+        if (info.shelf_index != INVALID_SHELF)
         {
-            return nullptr;
+            GlyphCache2D& t = *m_tex[info.texture_index];
+            t.last_use = m_epoch;
+            t.shelves[info.shelf_index].last_use = m_epoch;
         }
+        return &info;
     }
     bool TrueTypeGlyphManager_OpenGL::renderCache(uint32_t codepoint)
     {
@@ -395,6 +499,7 @@ namespace Core::Graphics
             }
             // 塞表里
             m_map.emplace(codepoint, cache);
+            return true;
         }
         return false;
     }
@@ -420,19 +525,21 @@ namespace Core::Graphics
     {
         if (index < m_tex.size())
         {
-            return m_tex[index].texture.get();
+            return m_tex[index]->texture.get();
         }
         return nullptr;
     }
 
     bool TrueTypeGlyphManager_OpenGL::cacheGlyph(uint32_t codepoint)
     {
+        m_epoch += 1;
         if (!getGlyphCacheInfo(codepoint))
             return false;
         return true;
     }
     bool TrueTypeGlyphManager_OpenGL::cacheString(StringView str)
     {
+        m_epoch += 1;
         // utf-8 迭代器
         char32_t code_ = 0;
         utf::utf8reader reader_(str.data(), str.size());
@@ -449,22 +556,23 @@ namespace Core::Graphics
     {
         for (auto& t : m_tex)
         {
-            if (t.dirty_l != INVALID_RECT)
+            if (t->dirty_l != INVALID_RECT)
             {
-                if (!t.texture->uploadPixelData(
-                    RectU(t.dirty_l, t.dirty_t, t.dirty_r, t.dirty_b),
-                    &t.image.pixel(t.dirty_l, t.dirty_t),
-                    // &t.image.data,
-                    t.image.pitch))
+                if (!t->texture->uploadPixelData(
+                    RectU(t->dirty_l, t->dirty_t, t->dirty_r, t->dirty_b),
+                    &t->image.pixel(t->dirty_l, t->dirty_t),
+                    // &t->image.data,
+                    t->image.pitch))
                 {
                     return false;
                 }
-                t.dirty_l = INVALID_RECT;
-                t.dirty_t = INVALID_RECT;
-                t.dirty_r = INVALID_RECT;
-                t.dirty_b = INVALID_RECT;
+                t->dirty_l = INVALID_RECT;
+                t->dirty_t = INVALID_RECT;
+                t->dirty_r = INVALID_RECT;
+                t->dirty_b = INVALID_RECT;
             }
         }
+        m_eviction_pending = false;
         return true;
     }
 
@@ -486,9 +594,24 @@ namespace Core::Graphics
         return false;
     }
 
+    GlyphCacheStatistics TrueTypeGlyphManager_OpenGL::getCacheStatistics()
+    {
+        GlyphCacheStatistics statistics = m_statistics;
+        statistics.page_count = (uint32_t)m_tex.size();
+        statistics.page_budget = m_page_budget;
+        for (auto& t : m_tex)
+        {
+            statistics.memory_usage += sizeof(t->image.data) + t->texture->getMemoryUsage();
+        }
+        return statistics;
+    }
+
     TrueTypeGlyphManager_OpenGL::TrueTypeGlyphManager_OpenGL(IDevice* p_device, TrueTypeFontInfo* p_arr_info, size_t info_count)
         : m_device(p_device)
     {
+        InitializeConfigure config;
+        config.loadFromFile("config.json");
+        m_page_budget = (uint32_t)std::max(1, config.glyph_cache_page_budget);
         if (!openFonts(p_arr_info, info_count))
         {
             throw std::runtime_error("TrueTypeGlyphManager_OpenGL::TrueTypeGlyphManager_OpenGL (openFonts)");
@@ -525,6 +648,12 @@ namespace Core::Graphics
 {
     bool TextRenderer_OpenGL::drawGlyph(GlyphInfo const& glyph_info, Vector2F const& start_pos)
     {
+        // 空白字形（全角空格、制表符等）不占用图集，没有可画的
+        if (glyph_info.size.x == 0.0f || glyph_info.size.y == 0.0f)
+        {
+            return true;
+        }
+
         // 准备顶点
         IRenderer::DrawVertex vert[4] = {
             IRenderer::DrawVertex(0.0f, 0.0f, m_z, 0.0f, 0.0f, m_color.color()),
@@ -583,6 +712,12 @@ namespace Core::Graphics
     }
     bool TextRenderer_OpenGL::drawGlyphInSpace(GlyphInfo const& glyph_info, Vector3F const& start_pos, Vector3F const& right_vec, Vector3F const& down_vec)
     {
+        // 空白字形（全角空格、制表符等）不占用图集，没有可画的
+        if (glyph_info.size.x == 0.0f || glyph_info.size.y == 0.0f)
+        {
+            return true;
+        }
+
         // 准备顶点
         IRenderer::DrawVertex vert[4] = {
             IRenderer::DrawVertex(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, m_color.color()),
@@ -742,6 +877,10 @@ namespace Core::Graphics
         {
             //return false; // Ignore unavailable glyphs
         }
+        if (m_glyphmgr->isEvictionPending())
+        {
+            m_renderer->flush(); // Earlier text may still sample the evicted glyphs
+        }
         if (!m_glyphmgr->flush())
         {
             return false;
@@ -869,6 +1008,10 @@ namespace Core::Graphics
         {
             //return false; // 找不到的就忽略
         }
+        if (m_glyphmgr->isEvictionPending())
+        {
+            m_renderer->flush(); // 之前的文字可能还在用被淘汰的字形
+        }
         if (!m_glyphmgr->flush())
         {
             return false;
@@ -1,6 +1,7 @@
 ﻿#pragma once
 #include "Core/Object.hpp"
 #include "Core/Graphics/Font.hpp"
+#include <memory>
 
 #include "ft2build.h"
 #include FT_FREETYPE_H
@@ -9,27 +10,39 @@ namespace Core::Graphics
 {
 	constexpr uint32_t const TEXTURE_SIZE = 1024;
 	constexpr uint32_t const INVALID_RECT = 0x7FFFFFFF;
+	constexpr uint32_t const SHELF_ALIGN = 8; // shelf heights are rounded up to this, glyphs only share shelves of the same height
+	constexpr uint32_t const INVALID_SHELF = 0xFFFFFFFF;
 
+	// Coverage only, the texture expands it to white with the coverage as alpha
 	struct Image2D
 	{
 		uint32_t const width = TEXTURE_SIZE;
 		uint32_t const height = TEXTURE_SIZE;
-		uint32_t const pitch = TEXTURE_SIZE * sizeof(Color4B);
-		Color4B data[TEXTURE_SIZE * TEXTURE_SIZE];
-		inline Color4B& pixel(uint32_t x, uint32_t y)
+		uint32_t const pitch = TEXTURE_SIZE;
+		uint8_t data[TEXTURE_SIZE * TEXTURE_SIZE];
+		inline uint8_t& pixel(uint32_t x, uint32_t y)
 		{
-			return data[y * 1024 + x];
+			return data[y * TEXTURE_SIZE + x];
 		}
 		Image2D();
 	};
 
+	struct GlyphShelf
+	{
+		uint32_t y = 0;
+		uint32_t height = 0;
+		uint32_t pen_x = 1; // leave 1 pixel left edge
+		uint64_t last_use = 0;
+		std::vector<uint32_t> codepoints;
+	};
+
 	struct GlyphCache2D
 	{
 		Image2D image;
 		ScopeObject<ITexture2D> texture;
-		uint32_t pen_x = 0;
-		uint32_t pen_y = 0;
-		uint32_t pen_bottom = 0;
+		std::vector<GlyphShelf> shelves;
+		uint32_t pen_bottom = 0; // top of the free area below the last shelf
+		uint64_t last_use = 0;
 		uint32_t dirty_l = INVALID_RECT;
 		uint32_t dirty_t = INVALID_RECT;
 		uint32_t dirty_r = INVALID_RECT;
@@ -46,6 +59,7 @@ namespace Core::Graphics
 		Vector2F advance;           // advance
 		// privately-owned
 		uint32_t codepoint = 0;     // current character
+		uint32_t shelf_index = INVALID_SHELF; // shelf on the texture, INVALID_SHELF for empty glyphs
 	};
 
 	struct FreeTypeFontData
@@ -73,8 +87,13 @@ namespace Core::Graphics
 		ScopeObject<IDevice> m_device;
 		FreeTypeFontCommonInfo m_common_info;
 		std::vector<FreeTypeFontData> m_font;
-		std::vector<GlyphCache2D> m_tex;
+		std::vector<std::unique_ptr<GlyphCache2D>> m_tex;
 		std::unordered_map<uint32_t, GlyphCacheInfo> m_map;
+		uint32_t m_page_budget{ 4 };
+		uint64_t m_epoch{ 1 }; // advanced by every cacheGlyph and cacheString, glyphs used in the current one are never evicted
+		bool m_eviction_pending{ false };
+		bool m_budget_warned{ false };
+		GlyphCacheStatistics m_statistics;
 
 	public:
 		void onDeviceCreate();
@@ -84,6 +103,9 @@ namespace Core::Graphics
 		void closeFonts();
 		bool openFonts(TrueTypeFontInfo* fonts, size_t count);
 		bool addTexture();
+		void evictShelf(GlyphShelf& s);
+		void evictPage(GlyphCache2D& t);
+		bool allocateShelf(uint32_t height, uint32_t width, uint32_t& page, uint32_t& shelf);
 		bool findGlyph(FT_ULong code, FT_Face& face, FT_UInt& index);
 		bool writeBitmapToCache(GlyphCacheInfo& info, FT_Bitmap& bitmap);
 		GlyphCacheInfo* getGlyphCacheInfo(uint32_t codepoint);
@@ -103,6 +125,9 @@ namespace Core::Graphics
 
 		bool getGlyph(uint32_t codepoint, GlyphInfo* p_ref_info, bool no_render);
 
+		bool isEvictionPending() { return m_eviction_pending; }
+		GlyphCacheStatistics getCacheStatistics();
+
 	public:
 		TrueTypeGlyphManager_OpenGL(IDevice* p_device, TrueTypeFontInfo* p_arr_info, size_t info_count);
 		~TrueTypeGlyphManager_OpenGL();
@@ -8,5 +8,9 @@ namespace Core::Graphics
 		Unknown,
 		R8G8B8A8_UNORM,
 		B8G8R8A8_UNORM,
+		BC1_UNORM,
+		BC3_UNORM,
+		BC7_UNORM,
+		R8_UNORM, // single channel, sampled as (1, 1, 1, r)
 	};
 }
@@ -0,0 +1,305 @@
+﻿#include "Core/Graphics/FrameCapture_OpenGL.hpp"
+#include "spdlog/spdlog.h"
+#include "stb_image_write.h"
+#include "qoi.h"
+#include <cassert>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <format>
+
+namespace Core::Graphics
+{
+	void FrameCapture_OpenGL::worker()
+	{
+		while (true)
+		{
+			Frame frame;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_cv_frame.wait(lock, [this] { return m_quit || !m_frames.empty(); });
+				if (m_frames.empty())
+				{
+					return; // quit, but only after the queued frames are written
+				}
+				frame = std::move(m_frames.front());
+				m_frames.pop_front();
+			}
+			m_cv_space.notify_one();
+			if (m_failed)
+			{
+				continue; // drain, the capture is broken anyway
+			}
+			if (encode(frame))
+			{
+				m_written += 1;
+			}
+			else
+			{
+				m_failed = true;
+			}
+		}
+	}
+	bool FrameCapture_OpenGL::encode(Frame const& frame)
+	{
+		switch (m_format)
+		{
+		case FrameCaptureFormat::PNG:
+		{
+			std::string const path = (std::filesystem::path(m_target) / std::format("{:06}.png", frame.index)).string();
+			if (!stbi_write_png(path.c_str(), (int)m_size.x, (int)m_size.y, 4, frame.pixels.data(), (int)m_size.x * 4))
+			{
+				spdlog::error("[core] Frame capture: unable to write '{}'", path);
+				return false;
+			}
+			return true;
+		}
+		case FrameCaptureFormat::QOI:
+		{
+			std::string const path = (std::filesystem::path(m_target) / std::format("{:06}.qoi", frame.index)).string();
+			qoi_desc desc{};
+			desc.width = m_size.x;
+			desc.height = m_size.y;
+			desc.channels = 4;
+			desc.colorspace = QOI_SRGB;
+			if (!qoi_write(path.c_str(), frame.pixels.data(), &desc))
+			{
+				spdlog::error("[core] Frame capture: unable to write '{}'", path);
+				return false;
+			}
+			return true;
+		}
+		case FrameCaptureFormat::Pipe:
+			if (std::fwrite(frame.pixels.data(), 1, frame.pixels.size(), m_pipe) != frame.pixels.size())
+			{
+				spdlog::error("[core] Frame capture: the encoder process stopped reading");
+				return false;
+			}
+			return true;
+		default:
+			assert(false);
+			return false;
+		}
+	}
+	void FrameCapture_OpenGL::collect(Readback& readback)
+	{
+		// Usually signalled already, the frame was submitted a few frames ago
+		while (true)
+		{
+			GLenum const status = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000); // 100ms
+			if (status != GL_TIMEOUT_EXPIRED)
+			{
+				break;
+			}
+		}
+		glDeleteSync(readback.fence);
+		readback.fence = nullptr;
+
+		Frame frame;
+		frame.index = readback.index;
+		size_t const bytes = (size_t)m_size.x * (size_t)m_size.y * 4;
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+		void const* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)bytes, GL_MAP_READ_BIT);
+		if (!data)
+		{
+			spdlog::error("[core] Frame capture: unable to map frame {}", readback.index);
+			m_failed = true;
+			return;
+		}
+		frame.pixels.resize(bytes);
+		std::memcpy(frame.pixels.data(), data, bytes);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_cv_space.wait(lock, [this] { return m_frames.size() < max_pending_frames; });
+		m_frames.emplace_back(std::move(frame));
+		lock.unlock();
+		m_cv_frame.notify_one();
+	}
+	GLuint FrameCapture_OpenGL::scale(GLuint texture, Vector2U size)
+	{
+		GLint last_read_framebuffer = 0;
+		GLint last_draw_framebuffer = 0;
+		glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &last_read_framebuffer);
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &last_draw_framebuffer);
+		GLboolean const last_scissor_test = glIsEnabled(GL_SCISSOR_TEST);
+
+		glDisable(GL_SCISSOR_TEST); // the blit would be clipped too
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_read_fbo);
+		glFramebufferTexture(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, 0);
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_scale_fbo);
+		glBlitFramebuffer(0, 0, size.x, size.y, 0, 0, m_size.x, m_size.y, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		glFramebufferTexture(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0);
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)last_read_framebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)last_draw_framebuffer);
+		if (last_scissor_test)
+		{
+			glEnable(GL_SCISSOR_TEST);
+		}
+		return m_scale_texture;
+	}
+
+	bool FrameCapture_OpenGL::begin(FrameCaptureFormat format, std::string_view target, Vector2U size)
+	{
+		if (m_capturing)
+		{
+			end();
+		}
+		if (size.x == 0 || size.y == 0)
+		{
+			return false;
+		}
+
+		m_format = format;
+		m_target = target;
+		m_size = size;
+		if (format == FrameCaptureFormat::Pipe)
+		{
+		#ifdef _WIN32
+			m_pipe = _popen(m_target.c_str(), "wb");
+		#else
+			std::signal(SIGPIPE, SIG_IGN); // an encoder that exits early fails the write instead of killing us
+			m_pipe = popen(m_target.c_str(), "w");
+		#endif
+			if (!m_pipe)
+			{
+				spdlog::error("[core] Frame capture: unable to start '{}'", m_target);
+				return false;
+			}
+		}
+		else
+		{
+			std::error_code ec;
+			std::filesystem::create_directories(std::filesystem::path(m_target), ec);
+			if (!std::filesystem::is_directory(std::filesystem::path(m_target), ec))
+			{
+				spdlog::error("[core] Frame capture: cannot create directory '{}'", m_target);
+				return false;
+			}
+		}
+
+		GLint last_pack_buffer = 0;
+		glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &last_pack_buffer);
+		for (auto& readback : m_readback)
+		{
+			glGenBuffers(1, &readback.pbo);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+			glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)size.x * (GLsizeiptr)size.y * 4, nullptr, GL_STREAM_READ);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, (GLuint)last_pack_buffer);
+
+		GLint last_texture = 0;
+		GLint last_draw_framebuffer = 0;
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &last_draw_framebuffer);
+		glGenTextures(1, &m_scale_texture);
+		glBindTexture(GL_TEXTURE_2D, m_scale_texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glGenFramebuffers(1, &m_scale_fbo);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_scale_fbo);
+		glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_scale_texture, 0);
+		glGenFramebuffers(1, &m_read_fbo);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)last_draw_framebuffer);
+		glBindTexture(GL_TEXTURE_2D, (GLuint)last_texture);
+
+		m_readback_index = 0;
+		m_frame_index = 0;
+		m_written = 0;
+		m_failed = false;
+		m_quit = false;
+		m_thread = std::thread(&FrameCapture_OpenGL::worker, this);
+		m_capturing = true;
+		spdlog::info("[core] Frame capture started ({}x{}) to '{}'", size.x, size.y, m_target);
+		return true;
+	}
+	void FrameCapture_OpenGL::capture(GLuint texture, Vector2U size)
+	{
+		if (!m_capturing)
+		{
+			return;
+		}
+		if (m_failed)
+		{
+			end();
+			return;
+		}
+		if (size != m_size)
+		{
+			// Every frame of a recording has to be the same size, dynamic resolution changes the render size often
+			texture = scale(texture, size);
+		}
+
+		GLint last_texture = 0;
+		GLint last_pack_buffer = 0;
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
+		glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &last_pack_buffer);
+
+		Readback& readback = m_readback[m_readback_index];
+		if (readback.fence)
+		{
+			collect(readback); // the ring is full, hand the oldest frame to the encoder
+		}
+		readback.index = m_frame_index++;
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_readback_index = (m_readback_index + 1) % readback_count;
+
+		glBindTexture(GL_TEXTURE_2D, (GLuint)last_texture);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, (GLuint)last_pack_buffer);
+	}
+	void FrameCapture_OpenGL::end()
+	{
+		if (!m_capturing)
+		{
+			return;
+		}
+		m_capturing = false;
+
+		GLint last_pack_buffer = 0;
+		glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &last_pack_buffer);
+		for (size_t i = 0; i < readback_count; i += 1)
+		{
+			// Oldest first
+			Readback& readback = m_readback[(m_readback_index + i) % readback_count];
+			if (readback.fence)
+			{
+				collect(readback);
+			}
+			glDeleteBuffers(1, &readback.pbo);
+			readback.pbo = 0;
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, (GLuint)last_pack_buffer);
+		glDeleteFramebuffers(1, &m_read_fbo);
+		glDeleteFramebuffers(1, &m_scale_fbo);
+		glDeleteTextures(1, &m_scale_texture);
+		m_read_fbo = 0;
+		m_scale_fbo = 0;
+		m_scale_texture = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_quit = true;
+		}
+		m_cv_frame.notify_all();
+		m_thread.join();
+		if (m_pipe)
+		{
+		#ifdef _WIN32
+			_pclose(m_pipe);
+		#else
+			pclose(m_pipe);
+		#endif
+			m_pipe = nullptr;
+		}
+		spdlog::info("[core] Frame capture finished, {} of {} frames written", m_written.load(), m_frame_index);
+	}
+
+	FrameCapture_OpenGL::~FrameCapture_OpenGL()
+	{
+		end();
+	}
+}
@@ -0,0 +1,84 @@
+﻿#pragma once
+#include "Core/Graphics/SwapChain.hpp"
+#include "Core/Type.hpp"
+#include "glad/gl.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace Core::Graphics
+{
+	// Records every presented frame: the canvas is read back through a ring of pixel buffer
+	// objects and an encoder thread writes numbered image files or streams raw RGBA into the
+	// standard input of an external process. Frames are never dropped, when the encoder falls
+	// behind rendering waits for it. Frames are recorded at the logical canvas size, a canvas
+	// rendered at another scale by dynamic resolution is scaled into a texture of that size first
+	class FrameCapture_OpenGL
+	{
+	private:
+		static constexpr size_t readback_count = 3; // frames in flight between the GPU and the CPU
+		static constexpr size_t max_pending_frames = 8; // frames waiting for the encoder
+
+		struct Readback
+		{
+			GLuint pbo{};
+			GLsync fence{};
+			uint64_t index{};
+		};
+		struct Frame
+		{
+			uint64_t index{};
+			std::vector<uint8_t> pixels;
+		};
+
+		FrameCaptureFormat m_format{ FrameCaptureFormat::PNG };
+		std::string m_target; // directory for image files, command line for Pipe
+		Vector2U m_size;
+		GLuint m_read_fbo{};
+		GLuint m_scale_fbo{};
+		GLuint m_scale_texture{}; // m_size, for canvases rendered at another size
+		Readback m_readback[readback_count];
+		size_t m_readback_index{}; // next slot to fill, also the oldest frame in flight
+		uint64_t m_frame_index{};
+		bool m_capturing{ false };
+
+		// Shared with the encoder thread
+		std::mutex m_mutex;
+		std::condition_variable m_cv_frame;
+		std::condition_variable m_cv_space;
+		std::deque<Frame> m_frames;
+		bool m_quit{ false };
+		std::thread m_thread;
+		FILE* m_pipe{ nullptr };
+		std::atomic<uint64_t> m_written{ 0 };
+		std::atomic<bool> m_failed{ false };
+
+		void worker();
+		bool encode(Frame const& frame);
+		void collect(Readback& readback);
+		GLuint scale(GLuint texture, Vector2U size);
+
+	public:
+		// size is the logical canvas size, every frame is written at this size
+		bool begin(FrameCaptureFormat format, std::string_view target, Vector2U size);
+		// Queues a readback of the canvas, call once per presented frame
+		void capture(GLuint texture, Vector2U size);
+		// Waits for the frames in flight and for the encoder
+		void end();
+
+		bool isCapturing() const noexcept { return m_capturing; }
+		uint64_t getWrittenFrameCount() const noexcept { return m_written; }
+
+	public:
+		FrameCapture_OpenGL() = default;
+		FrameCapture_OpenGL(FrameCapture_OpenGL const&) = delete;
+		~FrameCapture_OpenGL();
+	};
+}
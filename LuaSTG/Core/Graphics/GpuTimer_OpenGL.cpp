@@ -0,0 +1,138 @@
+﻿#include "Core/Graphics/GpuTimer_OpenGL.hpp"
+#include "Tracy.hpp"
+
+namespace Core::Graphics
+{
+	size_t GpuTimer_OpenGL::writeTimestamp(Frame& frame)
+	{
+		if (frame.query_used == frame.query.size())
+		{
+			GLuint query = 0;
+			glGenQueries(1, &query);
+			frame.query.push_back(query);
+		}
+		size_t const index = frame.query_used;
+		frame.query_used += 1;
+		glQueryCounter(frame.query[index], GL_TIMESTAMP);
+		return index;
+	}
+	void GpuTimer_OpenGL::resolve(Frame& frame)
+	{
+		frame.pending = false;
+		if (frame.query_used < 2)
+		{
+			return;
+		}
+		// Never stall on the GPU, drop the frame if it is still in flight
+		GLint available = 0;
+		glGetQueryObjectiv(frame.query[frame.query_used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			return;
+		}
+		auto const read = [&frame](size_t index) -> GLuint64
+		{
+			GLuint64 value = 0;
+			glGetQueryObjectui64v(frame.query[index], GL_QUERY_RESULT, &value);
+			return value;
+		};
+		// The first and the last timestamp enclose the whole frame
+		m_frame_time = (double)(read(frame.query_used - 1) - read(0)) * 1e-9;
+		m_zone_result.resize(frame.zone_used);
+		for (size_t i = 0; i < frame.zone_used; i += 1)
+		{
+			Zone const& zone = frame.zone[i];
+			GpuTimingZone& result = m_zone_result[i];
+			result.name = zone.name;
+			result.depth = zone.depth;
+			result.time = (double)(read(zone.query_end) - read(zone.query_begin)) * 1e-9;
+		}
+		TracyPlot("GPU Frame Time (ms)", m_frame_time * 1000.0);
+	}
+
+	void GpuTimer_OpenGL::beginFrame()
+	{
+		if (m_recording)
+		{
+			endFrame();
+		}
+		m_frame_index = (m_frame_index + 1) % frame_count;
+		Frame& frame = m_frame[m_frame_index];
+		if (frame.pending)
+		{
+			resolve(frame);
+		}
+		frame.query_used = 0;
+		frame.zone_used = 0;
+		m_zone_stack.clear();
+		writeTimestamp(frame);
+		m_recording = true;
+	}
+	void GpuTimer_OpenGL::endFrame()
+	{
+		if (!m_recording)
+		{
+			return;
+		}
+		// Zones left open (e.g. an unbalanced render target stack) end with the frame
+		while (!m_zone_stack.empty())
+		{
+			endZone();
+		}
+		Frame& frame = m_frame[m_frame_index];
+		writeTimestamp(frame);
+		frame.pending = true;
+		m_recording = false;
+	}
+	void GpuTimer_OpenGL::beginZone(StringView name)
+	{
+		if (!m_recording)
+		{
+			return;
+		}
+		Frame& frame = m_frame[m_frame_index];
+		if (frame.zone_used == frame.zone.size())
+		{
+			frame.zone.emplace_back();
+		}
+		Zone& zone = frame.zone[frame.zone_used];
+		zone.name.assign(name);
+		zone.depth = (uint32_t)m_zone_stack.size();
+		zone.query_begin = writeTimestamp(frame);
+		zone.query_end = SIZE_MAX;
+		m_zone_stack.push_back(frame.zone_used);
+		frame.zone_used += 1;
+	}
+	void GpuTimer_OpenGL::endZone()
+	{
+		if (!m_recording || m_zone_stack.empty())
+		{
+			return;
+		}
+		Frame& frame = m_frame[m_frame_index];
+		frame.zone[m_zone_stack.back()].query_end = writeTimestamp(frame);
+		m_zone_stack.pop_back();
+	}
+
+	void GpuTimer_OpenGL::destroy()
+	{
+		for (auto& frame : m_frame)
+		{
+			if (!frame.query.empty())
+			{
+				glDeleteQueries((GLsizei)frame.query.size(), frame.query.data());
+			}
+			frame.query.clear();
+			frame.query_used = 0;
+			frame.zone_used = 0;
+			frame.pending = false;
+		}
+		m_zone_stack.clear();
+		m_recording = false;
+	}
+
+	GpuTimer_OpenGL::~GpuTimer_OpenGL()
+	{
+		destroy();
+	}
+}
@@ -0,0 +1,59 @@
+﻿#pragma once
+#include "Core/Graphics/Renderer.hpp"
+#include "glad/gl.h"
+#include <string>
+#include <vector>
+
+namespace Core::Graphics
+{
+	// GL_TIMESTAMP query pool, a frame is read back frame_count frames after it was recorded
+	class GpuTimer_OpenGL
+	{
+	public:
+		static constexpr size_t frame_count = 4;
+
+	private:
+		struct Zone
+		{
+			std::string name;
+			size_t query_begin{};
+			size_t query_end{ SIZE_MAX }; // not closed yet
+			uint32_t depth{};
+		};
+		struct Frame
+		{
+			std::vector<GLuint> query; // grows as needed, reused every frame_count frames
+			size_t query_used{};
+			std::vector<Zone> zone;
+			size_t zone_used{};
+			bool pending{ false };
+		};
+
+		Frame m_frame[frame_count];
+		size_t m_frame_index{};
+		std::vector<size_t> m_zone_stack; // open zones of the frame being recorded
+		bool m_recording{ false };
+
+		double m_frame_time{};
+		std::vector<GpuTimingZone> m_zone_result;
+
+		size_t writeTimestamp(Frame& frame);
+		void resolve(Frame& frame);
+
+	public:
+		void beginFrame();
+		void endFrame();
+		void beginZone(StringView name);
+		void endZone();
+
+		double getFrameTime() const noexcept { return m_frame_time; }
+		std::vector<GpuTimingZone> const& getZones() const noexcept { return m_zone_result; }
+
+		void destroy();
+
+	public:
+		GpuTimer_OpenGL() = default;
+		GpuTimer_OpenGL(GpuTimer_OpenGL const&) = delete;
+		~GpuTimer_OpenGL();
+	};
+}
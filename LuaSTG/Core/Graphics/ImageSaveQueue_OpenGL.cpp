@@ -0,0 +1,172 @@
+﻿#include "Core/Graphics/ImageSaveQueue_OpenGL.hpp"
+#include "spdlog/spdlog.h"
+#include "stb_image_write.h"
+#include <cassert>
+#include <cstring>
+
+namespace Core::Graphics
+{
+	void ImageSaveQueue_OpenGL::worker()
+	{
+		while (true)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_cv.wait(lock, [this] { return m_quit || !m_jobs.empty(); });
+				if (m_jobs.empty())
+				{
+					return; // quit, but only after the queued images are written
+				}
+				job = std::move(m_jobs.front());
+				m_jobs.pop_front();
+			}
+			bool const success = 0 != stbi_write_png(job.path.c_str(), (int)job.size.x, (int)job.size.y, 4, job.pixels.data(), (int)job.size.x * 4);
+			if (!success)
+			{
+				spdlog::error("[core] Unable to write image '{}'", job.path);
+			}
+			pushResult(job.id, success);
+		}
+	}
+	void ImageSaveQueue_OpenGL::pushResult(uint64_t id, bool success)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_results.push_back(ImageSaveResult{ id, success });
+	}
+
+	bool ImageSaveQueue_OpenGL::readback(GLuint texture, Vector2U size, std::string_view path, uint64_t* p_id)
+	{
+		assert(p_id);
+		if (texture == 0 || size.x == 0 || size.y == 0)
+		{
+			return false;
+		}
+
+		Readback item;
+		item.id = m_next_id++;
+		item.path = path;
+		item.size = size;
+
+		GLint last_texture = 0;
+		GLint last_pack_buffer = 0;
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
+		glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &last_pack_buffer);
+
+		glGenBuffers(1, &item.pbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, item.pbo);
+		glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)size.x * (GLsizeiptr)size.y * 4, nullptr, GL_STREAM_READ);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr); // into the buffer, returns right away
+		item.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		glBindTexture(GL_TEXTURE_2D, (GLuint)last_texture);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, (GLuint)last_pack_buffer);
+
+		if (!item.fence)
+		{
+			glDeleteBuffers(1, &item.pbo);
+			spdlog::error("[core] Unable to read back image for '{}'", item.path);
+			return false;
+		}
+		*p_id = item.id;
+		m_readback.emplace_back(std::move(item));
+		return true;
+	}
+	void ImageSaveQueue_OpenGL::update()
+	{
+		if (m_readback.empty())
+		{
+			return;
+		}
+
+		GLint last_pack_buffer = 0;
+		glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &last_pack_buffer);
+
+		size_t done = 0;
+		for (auto& item : m_readback)
+		{
+			// Keep the order, a later readback waits for the earlier ones
+			GLenum const status = glClientWaitSync(item.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+			if (status == GL_TIMEOUT_EXPIRED)
+			{
+				break;
+			}
+			done += 1;
+
+			Job job;
+			job.id = item.id;
+			job.path = std::move(item.path);
+			job.size = item.size;
+			bool success = (status != GL_WAIT_FAILED);
+			if (success)
+			{
+				size_t const bytes = (size_t)item.size.x * (size_t)item.size.y * 4;
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, item.pbo);
+				void const* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)bytes, GL_MAP_READ_BIT);
+				if (data)
+				{
+					job.pixels.resize(bytes);
+					std::memcpy(job.pixels.data(), data, bytes);
+					glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+				}
+				else
+				{
+					success = false;
+				}
+			}
+			glDeleteSync(item.fence);
+			glDeleteBuffers(1, &item.pbo);
+
+			if (!success)
+			{
+				spdlog::error("[core] Unable to read back image for '{}'", job.path);
+				pushResult(job.id, false);
+				continue;
+			}
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (!m_thread.joinable())
+				{
+					m_thread = std::thread(&ImageSaveQueue_OpenGL::worker, this);
+				}
+				m_jobs.emplace_back(std::move(job));
+			}
+			m_cv.notify_one();
+		}
+		m_readback.erase(m_readback.begin(), m_readback.begin() + (ptrdiff_t)done);
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, (GLuint)last_pack_buffer);
+	}
+	bool ImageSaveQueue_OpenGL::popResult(ImageSaveResult* p_result)
+	{
+		assert(p_result);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_results.empty())
+		{
+			return false;
+		}
+		*p_result = m_results.front();
+		m_results.pop_front();
+		return true;
+	}
+
+	ImageSaveQueue_OpenGL::~ImageSaveQueue_OpenGL()
+	{
+		for (auto& item : m_readback)
+		{
+			glDeleteSync(item.fence);
+			glDeleteBuffers(1, &item.pbo);
+		}
+		m_readback.clear();
+		if (m_thread.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_quit = true;
+			}
+			m_cv.notify_all();
+			m_thread.join();
+		}
+	}
+}
@@ -0,0 +1,64 @@
+﻿#pragma once
+#include "Core/Graphics/Device.hpp"
+#include "Core/Type.hpp"
+#include "glad/gl.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace Core::Graphics
+{
+	// Saves textures to PNG files without stalling the frame: the pixels are read back into a
+	// pixel buffer object, mapped once the GPU has signalled the fence, then encoded and written
+	// on a worker thread
+	class ImageSaveQueue_OpenGL
+	{
+	private:
+		struct Readback
+		{
+			uint64_t id{};
+			std::string path;
+			Vector2U size;
+			GLuint pbo{};
+			GLsync fence{};
+		};
+		struct Job
+		{
+			uint64_t id{};
+			std::string path;
+			Vector2U size;
+			std::vector<uint8_t> pixels;
+		};
+
+		uint64_t m_next_id{ 1 };
+		std::vector<Readback> m_readback;
+
+		// Shared with the worker thread
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		std::deque<Job> m_jobs;
+		std::deque<ImageSaveResult> m_results;
+		bool m_quit{ false };
+		std::thread m_thread;
+
+		void worker();
+		void pushResult(uint64_t id, bool success);
+
+	public:
+		// Queues a readback of level 0 of the texture, p_id identifies the result
+		bool readback(GLuint texture, Vector2U size, std::string_view path, uint64_t* p_id);
+		// Hands finished readbacks to the worker thread, call once per frame
+		void update();
+		bool popResult(ImageSaveResult* p_result);
+
+	public:
+		ImageSaveQueue_OpenGL() = default;
+		ImageSaveQueue_OpenGL(ImageSaveQueue_OpenGL const&) = delete;
+		~ImageSaveQueue_OpenGL();
+	};
+}
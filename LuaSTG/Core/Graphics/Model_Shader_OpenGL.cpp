@@ -1,6 +1,8 @@
 ﻿#include "Core/Graphics/Model_OpenGL.hpp"
 #include "Core/Graphics/Renderer.hpp"
 #include "glad/gl.h"
+#include <format>
+#include <string>
 
 // Default Fragment Shader
 const constexpr GLchar default_fragment[]{R"(
@@ -187,40 +189,11 @@ namespace Core::Graphics
         "VERTEX_COLOR",
     };
 
-    static bool compileShaderMacro(const GLchar* data, GLint size, GLenum shadertype, GLuint& shader)
-    {
-        shader = glCreateShader(shadertype);
-        glShaderSource(shader, 1, &data, &size);
-        glCompileShader(shader);
-
-        GLint result;
-        glGetShaderiv(shader, GL_COMPILE_STATUS, &result);
-        if (result == GL_FALSE)
-        {
-            GLchar log[1024];
-            int32_t log_len;
-            glGetShaderInfoLog(shader, 1024, &log_len, log);
-            spdlog::error("[core] Failed to compile shader: {}", log);
-            glDeleteShader(shader);
-            return false;
-        }
-
-        return true;
-    }
-    static bool compileVertexShaderMacro(const GLchar* data, GLint size, GLuint& shader)
-    {
-        return compileShaderMacro(data, size, GL_VERTEX_SHADER, shader);
-    }
-    static bool compileFragmentShaderMacro(const GLchar* data, GLint size, GLuint& shader)
-    {
-        return compileShaderMacro(data, size, GL_FRAGMENT_SHADER, shader);
-    }
     bool ModelSharedComponent_OpenGL::createShader()
     {
         // built-in: compile shader
 
-        GLuint vert = 0;
-        compileVertexShaderMacro(default_vertex, sizeof(default_vertex), vert);
+        ProgramCache_OpenGL& cache = m_device->getProgramCache();
 
         GLuint idx_view_proj_buffer;
         GLuint idx_world_buffer;
@@ -234,17 +207,13 @@ namespace Core::Graphics
         for (int k = 0; k < 2; k++)
         for (int l = 0; l < 2; l++)
         {
-            GLuint frag = 0;
             std::string s_frag = std::format(dfrag_sv, fog_state[i], amask[j], btex[k], vc[l]);
-            compileFragmentShaderMacro(s_frag.c_str(), s_frag.length(), frag);
-
-            GLuint prgm = glCreateProgram();
+            GLuint prgm = cache.createProgram(default_vertex, s_frag);
             programs[i][j][k][l] = prgm;
-            glAttachShader(prgm, vert);
-            glAttachShader(prgm, frag);
-            glLinkProgram(prgm);
-
-            glDeleteShader(frag);
+            if (prgm == 0)
+            {
+                return false;
+            }
 
             idx_view_proj_buffer = glGetUniformBlockIndex(prgm, "view_proj_buffer");
             idx_world_buffer = glGetUniformBlockIndex(prgm, "world_buffer");
@@ -261,8 +230,6 @@ namespace Core::Graphics
             glUniformBlockBinding(prgm, idx_light_info, 5);
         }
 
-        glDeleteShader(vert);
-
         // idx_fog_uniform = glGetSubroutineUniformLocation(shader_program, GL_FRAGMENT_SHADER, "fog_uniform");
         // idx_btex_uniform = glGetSubroutineUniformLocation(shader_program, GL_FRAGMENT_SHADER, "btex_uniform");
         // idx_vc_uniform = glGetSubroutineUniformLocation(shader_program, GL_FRAGMENT_SHADER, "vc_uniform");
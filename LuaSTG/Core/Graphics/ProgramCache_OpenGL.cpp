@@ -0,0 +1,248 @@
+﻿#include "Core/Graphics/ProgramCache_OpenGL.hpp"
+#include "Core/InitializeConfigure.hpp"
+#include "spdlog/spdlog.h"
+#include "xxhash.h"
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <vector>
+
+namespace Core::Graphics
+{
+	namespace
+	{
+		struct ProgramBinaryHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t format;
+			uint32_t size;
+		};
+		constexpr uint32_t program_binary_magic = 0x42505453u; // "STPB"
+		constexpr uint32_t program_binary_version = 1;
+
+		bool compileShader(std::string_view source, GLenum type, GLuint& shader)
+		{
+			GLchar const* data = source.data();
+			GLint const size = (GLint)source.size();
+			shader = glCreateShader(type);
+			glShaderSource(shader, 1, &data, &size);
+			glCompileShader(shader);
+
+			GLint result;
+			glGetShaderiv(shader, GL_COMPILE_STATUS, &result);
+			if (result == GL_FALSE)
+			{
+				GLchar log[1024];
+				int32_t log_len;
+				glGetShaderInfoLog(shader, 1024, &log_len, log);
+				spdlog::error("[core] Failed to compile shader: {}", log);
+				glDeleteShader(shader);
+				shader = 0;
+				return false;
+			}
+			return true;
+		}
+	}
+
+	void ProgramCache_OpenGL::initialize()
+	{
+		m_initialized = true;
+
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		if (formats <= 0)
+		{
+			spdlog::info("[core] Program binary cache disabled, the driver has no program binary formats");
+			return;
+		}
+
+		InitializeConfigure config;
+		config.loadFromFile("config.json");
+		if (config.engine_cache_directory.empty())
+		{
+			spdlog::info("[core] Program binary cache disabled, engine_cache_directory is not set");
+			return;
+		}
+		std::string directory;
+		if (!InitializeConfigure::parserDirectory(config.engine_cache_directory, directory, true))
+		{
+			return;
+		}
+		std::error_code ec;
+		std::filesystem::path path = std::filesystem::path(directory) / "shader";
+		std::filesystem::create_directories(path, ec);
+		if (!std::filesystem::is_directory(path, ec))
+		{
+			spdlog::warn("[core] Program binary cache disabled, cannot create '{}'", path.string());
+			return;
+		}
+		m_directory = path.string();
+
+		auto const get_string = [](GLenum name) -> std::string_view
+		{
+			auto const* str = reinterpret_cast<char const*>(glGetString(name));
+			return str ? std::string_view(str) : std::string_view();
+		};
+		m_driver = std::format("{}\n{}\n{}", get_string(GL_VENDOR), get_string(GL_RENDERER), get_string(GL_VERSION));
+	}
+	std::string ProgramCache_OpenGL::getFilePath(std::string_view vert_source, std::string_view frag_source)
+	{
+		XXH3_state_t* state = XXH3_createState();
+		XXH3_64bits_reset(state);
+		XXH3_64bits_update(state, m_driver.data(), m_driver.size());
+		XXH3_64bits_update(state, vert_source.data(), vert_source.size());
+		XXH3_64bits_update(state, "\0", 1); // keep "ab" + "c" apart from "a" + "bc"
+		XXH3_64bits_update(state, frag_source.data(), frag_source.size());
+		XXH64_hash_t const hash = XXH3_64bits_digest(state);
+		XXH3_freeState(state);
+		return (std::filesystem::path(m_directory) / std::format("{:016x}.bin", hash)).string();
+	}
+	GLuint ProgramCache_OpenGL::loadProgram(std::string const& path)
+	{
+		std::ifstream file(std::filesystem::path(path), std::ios::binary);
+		if (!file)
+		{
+			return 0;
+		}
+		ProgramBinaryHeader header{};
+		if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+			|| header.magic != program_binary_magic
+			|| header.version != program_binary_version
+			|| header.size == 0)
+		{
+			return 0;
+		}
+		std::vector<char> binary(header.size);
+		if (!file.read(binary.data(), (std::streamsize)binary.size()))
+		{
+			return 0;
+		}
+
+		GLuint program = glCreateProgram();
+		glProgramBinary(program, (GLenum)header.format, binary.data(), (GLsizei)binary.size());
+		GLint result = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &result);
+		if (result == GL_FALSE)
+		{
+			// Driver update or a different GPU, the binary is rebuilt from source
+			glDeleteProgram(program);
+			file.close();
+			std::error_code ec;
+			std::filesystem::remove(std::filesystem::path(path), ec);
+			return 0;
+		}
+		return program;
+	}
+	void ProgramCache_OpenGL::saveProgram(std::string const& path, GLuint program)
+	{
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0)
+		{
+			return;
+		}
+		std::vector<char> binary((size_t)length);
+		GLenum format = 0;
+		glGetProgramBinary(program, length, &length, &format, binary.data());
+		if (length <= 0)
+		{
+			return;
+		}
+
+		ProgramBinaryHeader const header{ program_binary_magic, program_binary_version, (uint32_t)format, (uint32_t)length };
+		std::filesystem::path const final_path(path);
+		std::filesystem::path temp_path(final_path);
+		temp_path += ".tmp";
+		{
+			std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+			if (!file
+				|| !file.write(reinterpret_cast<char const*>(&header), sizeof(header))
+				|| !file.write(binary.data(), length))
+			{
+				spdlog::warn("[core] Unable to write program binary '{}'", path);
+				return;
+			}
+		}
+		// Never leave a half written binary behind
+		std::error_code ec;
+		std::filesystem::rename(temp_path, final_path, ec);
+		if (ec)
+		{
+			std::filesystem::remove(temp_path, ec);
+		}
+	}
+	GLuint ProgramCache_OpenGL::compileProgram(std::string_view vert_source, std::string_view frag_source)
+	{
+		GLuint vert = 0;
+		GLuint frag = 0;
+		if (!compileShader(vert_source, GL_VERTEX_SHADER, vert))
+		{
+			return 0;
+		}
+		if (!compileShader(frag_source, GL_FRAGMENT_SHADER, frag))
+		{
+			glDeleteShader(vert);
+			return 0;
+		}
+
+		GLuint program = glCreateProgram();
+		if (!m_directory.empty())
+		{
+			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+		glAttachShader(program, vert);
+		glAttachShader(program, frag);
+		glLinkProgram(program);
+		glDetachShader(program, vert);
+		glDetachShader(program, frag);
+		glDeleteShader(vert);
+		glDeleteShader(frag);
+
+		GLint result = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &result);
+		if (result == GL_FALSE)
+		{
+			GLchar log[1024];
+			int32_t log_len;
+			glGetProgramInfoLog(program, 1024, &log_len, log);
+			spdlog::error("[core] Failed to link shader: {}", log);
+			glDeleteProgram(program);
+			return 0;
+		}
+		return program;
+	}
+
+	GLuint ProgramCache_OpenGL::createProgram(std::string_view vert_source, std::string_view frag_source)
+	{
+		if (!m_initialized)
+		{
+			initialize();
+		}
+
+		using clock = std::chrono::steady_clock;
+		auto const t_begin = clock::now();
+
+		std::string path;
+		if (!m_directory.empty())
+		{
+			path = getFilePath(vert_source, frag_source);
+			if (GLuint program = loadProgram(path))
+			{
+				m_statistics.loaded += 1;
+				m_statistics.load_time += std::chrono::duration<double>(clock::now() - t_begin).count();
+				return program;
+			}
+		}
+
+		GLuint program = compileProgram(vert_source, frag_source);
+		if (program && !path.empty())
+		{
+			saveProgram(path, program);
+		}
+		m_statistics.compiled += 1;
+		m_statistics.compile_time += std::chrono::duration<double>(clock::now() - t_begin).count();
+		return program;
+	}
+}
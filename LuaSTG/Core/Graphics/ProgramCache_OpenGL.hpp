@@ -0,0 +1,39 @@
+﻿#pragma once
+#include "glad/gl.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Core::Graphics
+{
+	struct ProgramCacheStatistics
+	{
+		uint32_t loaded{}; // restored from a cached program binary
+		uint32_t compiled{}; // compiled and linked from source
+		double load_time{}; // seconds
+		double compile_time{}; // seconds
+	};
+
+	// Linked program binaries in engine_cache_directory, keyed by the shader sources and the GL driver
+	class ProgramCache_OpenGL
+	{
+	private:
+		std::string m_directory; // empty when programs can't be cached
+		std::string m_driver; // vendor, renderer and version
+		bool m_initialized{ false };
+		ProgramCacheStatistics m_statistics;
+
+		void initialize();
+		std::string getFilePath(std::string_view vert_source, std::string_view frag_source);
+		GLuint loadProgram(std::string const& path);
+		void saveProgram(std::string const& path, GLuint program);
+		GLuint compileProgram(std::string_view vert_source, std::string_view frag_source);
+
+	public:
+		// Returns a linked program, or 0 if the sources don't compile. Loading a binary resets
+		// uniform block bindings and uniforms, so callers set those after every call
+		GLuint createProgram(std::string_view vert_source, std::string_view frag_source);
+
+		ProgramCacheStatistics const& getStatistics() const noexcept { return m_statistics; }
+	};
+}
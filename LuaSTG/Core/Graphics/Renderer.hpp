@@ -1,10 +1,50 @@
 ﻿#pragma once
 #include "Core/Type.hpp"
 #include "Core/Graphics/Device.hpp"
+#include <string>
+#include <vector>
 
 namespace Core::Graphics
 {
 	struct IRenderer;
+	struct IMeshBuffer;
+
+	struct GpuTimingZone
+	{
+		std::string name;
+		double time{}; // seconds
+		uint32_t depth{}; // nesting level, zones are listed in the order they began
+	};
+
+	// The GL renderer only counts when built with LUASTG_RENDERER_STATISTICS, otherwise always zero
+	struct RendererFrameStatistics
+	{
+		enum class FlushCause : uint8_t
+		{
+			BufferFull, // vertex, index, instance or draw command buffer has no room left
+			StateChange, // camera, viewport or scissor rect
+			RenderTarget, // render target switch or clear
+			Explicit, // flush, endBatch and GPU timer zones
+
+			MAX_COUNT,
+		};
+
+		uint64_t flush[(size_t)FlushCause::MAX_COUNT]{};
+		uint64_t draw{};
+		uint64_t vertex{};
+		uint64_t index{};
+		uint64_t texture_bind{};
+		uint64_t sampler_bind{};
+		uint64_t program_switch{};
+		uint64_t post_effect{};
+
+		// GL calls skipped because the state was already bound
+		uint64_t texture_bind_skipped{};
+		uint64_t sampler_bind_skipped{};
+		uint64_t program_switch_skipped{};
+		uint64_t vertex_array_bind_skipped{};
+		uint64_t blend_state_skipped{};
+	};
 
 	struct IPostEffectShader : public IObject
 	{
@@ -125,7 +165,25 @@ namespace Core::Graphics
 			DrawVertex(float const x_, float const y_, float const u_, float const v_)
 				: x(x_), y(y_), z(0.f), u(u_), v(v_), color(0xFFFFFFFFu) {} // TODO: z = 0.0f or z = 0.5f ?
 		};
+	#ifdef LUASTG_RENDERER_INDEX32
+		using DrawIndex = uint32_t;
+	#else
 		using DrawIndex = uint16_t;
+	#endif
+		// Most vertices one draw can address, 16-bit indices can't go past 65536
+		static constexpr uint32_t max_draw_vertex_count = sizeof(DrawIndex) < 4 ? 65536u : (1u << 24);
+		// One sprite quad, expanded and rotated by the vertex shader
+		struct DrawInstance
+		{
+			float x, y, z; // position
+			float l, t, r, b; // quad rect relative to position, before scale and rotation
+			float u0, v0, u1, v1; // texture coordinates of (l, t) and (r, b)
+			uint32_t color;
+			float sx, sy; // scale
+			float rotation; // radians
+
+			DrawInstance() : x(0.0f), y(0.0f), z(0.0f), l(0.0f), t(0.0f), r(0.0f), b(0.0f), u0(0.0f), v0(0.0f), u1(0.0f), v1(0.0f), color(0xFFFFFFFFu), sx(1.0f), sy(1.0f), rotation(0.0f) {}
+		};
 
 		virtual bool beginBatch() = 0;
 		virtual bool endBatch() = 0;
@@ -143,21 +201,35 @@ namespace Core::Graphics
 		virtual void setViewport(BoxF const& box) = 0;
 		virtual void setScissorRect(RectF const& rect) = 0;
 		virtual void setViewportAndScissorRect() = 0;
+		// Dynamic resolution, the viewport and scissor rect are multiplied by this before they reach the render target
+		virtual void setViewportScale(float scale) = 0;
+		virtual float getViewportScale() = 0;
 
 		virtual void setVertexColorBlendState(VertexColorBlendState state) = 0;
 		virtual void setFogState(FogState state, Color4B const& color, float density_or_znear, float zfar) = 0;
 		virtual void setDepthState(DepthState state) = 0;
 		virtual void setBlendState(BlendState state) = 0;
 		virtual void setTexture(ITexture2D* texture) = 0;
+		// Let draws with different textures share a draw command, up to 8 textures with the same alpha type
+		virtual void setTextureBatching(bool enable) = 0;
+		virtual bool getTextureBatching() = 0;
 
 		virtual bool drawTriangle(DrawVertex const& v1, DrawVertex const& v2, DrawVertex const& v3) = 0;
 		virtual bool drawTriangle(DrawVertex const* pvert) = 0;
 		virtual bool drawQuad(DrawVertex const& v1, DrawVertex const& v2, DrawVertex const& v3, DrawVertex const& v4) = 0;
 		virtual bool drawQuad(DrawVertex const* pvert) = 0;
-		virtual bool drawRaw(DrawVertex const* pvert, uint16_t nvert, DrawIndex const* pidx, uint16_t nidx) = 0;
-		virtual bool drawRequest(uint16_t nvert, uint16_t nidx, DrawVertex** ppvert, DrawIndex** ppidx, uint16_t* idxoffset) = 0;
+		// Meshes larger than the batch capacity grow the batch buffers instead of failing
+		virtual bool drawRaw(DrawVertex const* pvert, uint32_t nvert, DrawIndex const* pidx, uint32_t nidx) = 0;
+		virtual bool drawRequest(uint32_t nvert, uint32_t nidx, DrawVertex** ppvert, DrawIndex** ppidx, DrawIndex* idxoffset) = 0;
+		virtual bool drawInstance(DrawInstance const& inst) = 0;
+		virtual bool drawInstances(DrawInstance const* pinst, uint16_t ninst) = 0;
+		// True when an instance would join the last draw command, it is instanced or still empty,
+		// otherwise instances and quads alternate commands that quads alone would have merged
+		virtual bool canBatchInstance() = 0;
 
 		virtual bool createPostEffectShader(StringView path, IPostEffectShader** pp_effect) = 0;
+		// Compose several post effect sources into one full screen pass, each source is a per-pixel stage
+		virtual bool createPostEffectChain(StringView const* paths, size_t count, IPostEffectShader** pp_effect) = 0;
 		virtual bool drawPostEffect(
 			IPostEffectShader* p_effect,
 			BlendState blend,
@@ -169,8 +241,35 @@ namespace Core::Graphics
 		virtual bool createModel(StringView path, IModel** pp_model) = 0;
 		virtual bool drawModel(IModel* p_model) = 0;
 
+		virtual bool createMeshBuffer(IMeshBuffer** pp_mesh) = 0;
+		// Drawn right away with the current texture and states, after the batched draws before it
+		virtual bool drawMeshBuffer(IMeshBuffer* p_mesh) = 0;
+
 		virtual Graphics::SamplerState getKnownSamplerState(SamplerState state) = 0;
 
+		// GPU timer queries, results belong to a frame a few frames back,
+		// endGpuFrame also closes the frame for getFrameStatistics
+		virtual void beginGpuFrame() = 0;
+		virtual void endGpuFrame() = 0;
+		virtual void beginGpuZone(StringView name) = 0;
+		virtual void endGpuZone() = 0;
+		virtual double getGpuFrameTime() = 0;
+		virtual std::vector<GpuTimingZone> const& getGpuZones() = 0;
+		virtual RendererFrameStatistics getFrameStatistics() = 0; // last completed frame
+
 		static bool create(IDevice* p_device, IRenderer** pp_renderer);
 	};
+
+	// Vertex and index data kept in GPU buffers, for meshes that are drawn often but rarely change
+	struct IMeshBuffer : public IObject
+	{
+		// Replaces the mesh, the GPU buffers are updated the next time it is drawn
+		virtual bool setData(IRenderer::DrawVertex const* pvert, uint32_t nvert, IRenderer::DrawIndex const* pidx, uint32_t nidx) = 0;
+		virtual uint32_t getVertexCount() = 0;
+		virtual uint32_t getIndexCount() = 0;
+
+		virtual void setScaling(Vector3F const& scale) = 0;
+		virtual void setPosition(Vector3F const& pos) = 0;
+		virtual void setRotationRollPitchYaw(float roll, float pitch, float yaw) = 0;
+	};
 }
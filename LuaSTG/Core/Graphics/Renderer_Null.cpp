@@ -0,0 +1,478 @@
+﻿#include "Core/Graphics/Renderer_Null.hpp"
+#include "Core/FileManager.hpp"
+#include "Core/InitializeConfigure.hpp"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+
+#define IDX(x) (size_t)static_cast<uint8_t>(x)
+
+namespace Core::Graphics
+{
+    PostEffectShader_Null::PostEffectShader_Null(StringView path)
+        : m_path(path)
+    {
+        // Reading the source is the only CPU-side work the shader does
+        std::vector<uint8_t> src;
+        if (!GFileManager().loadEx(m_path, src))
+        {
+            spdlog::error("[core] Unable to load file '{}'", m_path);
+            throw std::runtime_error("PostEffectShader_Null::PostEffectShader_Null");
+        }
+    }
+    PostEffectShader_Null::PostEffectShader_Null(StringView const* paths, size_t count)
+        : m_path(paths[0])
+    {
+        for (size_t i = 0; i < count; i += 1)
+        {
+            std::vector<uint8_t> src;
+            if (!GFileManager().loadEx(paths[i], src))
+            {
+                spdlog::error("[core] Unable to load file '{}'", paths[i]);
+                throw std::runtime_error("PostEffectShader_Null::PostEffectShader_Null");
+            }
+        }
+    }
+    PostEffectShader_Null::~PostEffectShader_Null()
+    {
+    }
+
+    bool Renderer_Null::onDrawBatchFull()
+    {
+        return batchFlush(RendererFrameStatistics::FlushCause::BufferFull);
+    }
+    bool Renderer_Null::onDrawBatchResize()
+    {
+        return true; // no GPU buffers sized after the draw list
+    }
+
+    void Renderer_Null::createStates()
+    {
+        // Same table as Renderer_OpenGL, resources look these up by name
+        for (size_t i_ = 0; i_ < IDX(SamplerState::MAX_COUNT); i_ += 1)
+        {
+            bool const linear_ = i_ >= IDX(SamplerState::LinearWrap);
+            auto& state_ = _sampler_state[i_];
+            state_.filter = linear_ ? Filter(FilterMode::Linear, FilterMode::Linear) : Filter(FilterMode::Nearest, FilterMode::Nearest);
+            switch (i_ - (linear_ ? IDX(SamplerState::LinearWrap) : IDX(SamplerState::PointWrap)))
+            {
+            case 0:
+                state_.address_u = state_.address_v = TextureAddressMode::Wrap;
+                break;
+            case 1:
+                state_.address_u = state_.address_v = TextureAddressMode::Clamp;
+                break;
+            case 2:
+                state_.address_u = state_.address_v = TextureAddressMode::Border;
+                state_.border_color = BorderColor::Black;
+                break;
+            case 3:
+                state_.address_u = state_.address_v = TextureAddressMode::Border;
+                state_.border_color = BorderColor::White;
+                break;
+            }
+        }
+    }
+    void Renderer_Null::initState()
+    {
+        _state_dirty = true;
+        invalidateTextures();
+        _bound_program = SIZE_MAX;
+        _bound_state_valid = false;
+        _batch.invalidateState();
+
+        if (!_is_3D)
+        {
+            setOrtho(_ortho);
+        }
+        else
+        {
+            setPerspective(_eye, _lookat, _headup, _fov, _aspect, _znear, _zfar);
+        }
+
+        setViewport(_viewport);
+        setScissorRect(_scissor_rect);
+
+        setTexture(_batch.getTexture());
+
+        _state_dirty = false;
+    }
+    void Renderer_Null::invalidateTextures()
+    {
+        for (auto& texture_ : _bound_texture)
+        {
+            texture_ = nullptr;
+        }
+    }
+    void Renderer_Null::bindTexture(ITexture2D* texture, uint8_t unit)
+    {
+        if (_bound_texture[unit] != texture)
+        {
+            _bound_texture[unit] = texture;
+            _statistics.texture_bind += 1;
+        }
+    }
+    void Renderer_Null::bindProgram(DrawCommand const& cmd)
+    {
+        size_t const kind_ = (cmd.type == DrawCommand::Type::Instance) ? 1 : ((cmd.texture_count > 1) ? 2 : 0);
+        size_t const premul_ = (cmd.texture[0].get() && cmd.texture[0].get()->isPremultipliedAlpha()) ? 1 : 0;
+        size_t const program_ = ((kind_ * IDX(VertexColorBlendState::MAX_COUNT) + IDX(cmd.state.vertex_color_blend_state)) * IDX(FogState::MAX_COUNT) + IDX(cmd.state.fog_state)) * IDX(TextureAlphaType::MAX_COUNT) + premul_;
+        if (_bound_program != program_)
+        {
+            _bound_program = program_;
+            _statistics.program_switch += 1;
+        }
+    }
+    void Renderer_Null::applyDrawState(DrawState const& state)
+    {
+        if (!_bound_state_valid)
+        {
+            _statistics.state_change += 3;
+        }
+        else
+        {
+            if (_bound_state.depth_state != state.depth_state)
+                _statistics.state_change += 1;
+            if (_bound_state.blend_state != state.blend_state)
+                _statistics.state_change += 1;
+            if (_bound_state.fog_color != state.fog_color || _bound_state.fog_near_or_density != state.fog_near_or_density || _bound_state.fog_far != state.fog_far)
+                _statistics.state_change += 1;
+        }
+        _bound_state = state;
+        _bound_state_valid = true;
+    }
+    bool Renderer_Null::batchFlush(RendererFrameStatistics::FlushCause cause, bool discard)
+    {
+        if (!discard)
+        {
+            if (_draw_list.vertex.size > 0 || _draw_list.instance.size > 0)
+            {
+                _statistics.flush[IDX(cause)] += 1;
+            }
+            for (size_t j_ = 0; j_ < _draw_list.command.size; j_ += 1)
+            {
+                DrawCommand& cmd_ = _draw_list.command.data[j_];
+                bool const has_data_ = (cmd_.type == DrawCommand::Type::Instance)
+                    ? (cmd_.instance_count > 0)
+                    : (cmd_.vertex_count > 0 && cmd_.index_count > 0);
+                if (!has_data_)
+                {
+                    continue;
+                }
+                for (uint8_t t_ = cmd_.texture_count; t_ > 0; t_ -= 1)
+                {
+                    bindTexture(cmd_.texture[t_ - 1].get(), t_ - 1);
+                }
+                applyDrawState(cmd_.state);
+                bindProgram(cmd_);
+                _statistics.draw += 1;
+                if (cmd_.type == DrawCommand::Type::Instance)
+                {
+                    _statistics.instance += cmd_.instance_count;
+                    _statistics.vertex += 4 * (uint64_t)cmd_.instance_count;
+                }
+                else
+                {
+                    _statistics.vertex += cmd_.vertex_count;
+                    _statistics.index += cmd_.index_count;
+                }
+            }
+        }
+        // clear, Renderer_OpenGL forgets its texture bindings here too
+        invalidateTextures();
+        _batch.restart();
+        return true;
+    }
+
+    bool Renderer_Null::beginBatch()
+    {
+        initState();
+        _batch_scope = true;
+        return true;
+    }
+    bool Renderer_Null::endBatch()
+    {
+        _batch_scope = false;
+        if (!batchFlush())
+            return false;
+        _batch.resetTexture();
+        return true;
+    }
+    bool Renderer_Null::flush()
+    {
+        return batchFlush();
+    }
+
+    void Renderer_Null::clearRenderTarget(Color4B const& color)
+    {
+        std::ignore = color;
+        batchFlush(RendererFrameStatistics::FlushCause::RenderTarget);
+        _statistics.clear += 1;
+    }
+    void Renderer_Null::clearDepthBuffer(float zvalue)
+    {
+        std::ignore = zvalue;
+        batchFlush(RendererFrameStatistics::FlushCause::RenderTarget);
+        _statistics.clear += 1;
+    }
+    void Renderer_Null::setRenderAttachment(IRenderTarget* p_rt)
+    {
+        std::ignore = p_rt;
+        batchFlush(RendererFrameStatistics::FlushCause::RenderTarget);
+        _statistics.render_target_switch += 1;
+    }
+
+    void Renderer_Null::setOrtho(BoxF const& box)
+    {
+        if (_state_dirty || _is_3D || _ortho != box)
+        {
+            batchFlush(RendererFrameStatistics::FlushCause::StateChange);
+            _ortho = box;
+            _is_3D = false;
+            _statistics.state_change += 1;
+        }
+    }
+    void Renderer_Null::setPerspective(Vector3F const& eye, Vector3F const& lookat, Vector3F const& headup, float fov, float aspect, float znear, float zfar)
+    {
+        if (_state_dirty || !_is_3D || _eye != eye || _lookat != lookat || _headup != headup || _fov != fov || _aspect != aspect || _znear != znear || _zfar != zfar)
+        {
+            batchFlush(RendererFrameStatistics::FlushCause::StateChange);
+            _eye = eye;
+            _lookat = lookat;
+            _headup = headup;
+            _fov = fov;
+            _aspect = aspect;
+            _znear = znear;
+            _zfar = zfar;
+            _is_3D = true;
+            _statistics.state_change += 1;
+        }
+    }
+
+    void Renderer_Null::setViewport(BoxF const& box)
+    {
+        if (_state_dirty || _viewport != box)
+        {
+            batchFlush(RendererFrameStatistics::FlushCause::StateChange);
+            _viewport = box;
+            _statistics.state_change += 1;
+        }
+    }
+    void Renderer_Null::setScissorRect(RectF const& rect)
+    {
+        if (_state_dirty || _scissor_rect != rect)
+        {
+            batchFlush(RendererFrameStatistics::FlushCause::StateChange);
+            _scissor_rect = rect;
+            _statistics.state_change += 1;
+        }
+    }
+    void Renderer_Null::setViewportAndScissorRect()
+    {
+        _state_dirty = true;
+        setViewport(_viewport);
+        setScissorRect(_scissor_rect);
+        _state_dirty = false;
+    }
+    void Renderer_Null::setViewportScale(float scale)
+    {
+        if (_viewport_scale != scale)
+        {
+            batchFlush(RendererFrameStatistics::FlushCause::RenderTarget);
+            _viewport_scale = scale;
+            setViewportAndScissorRect();
+        }
+    }
+
+    bool Renderer_Null::createPostEffectShader(StringView path, IPostEffectShader** pp_effect)
+    {
+        try
+        {
+            *pp_effect = new PostEffectShader_Null(path);
+            return true;
+        }
+        catch (...)
+        {
+            *pp_effect = nullptr;
+            return false;
+        }
+    }
+    bool Renderer_Null::createPostEffectChain(StringView const* paths, size_t count, IPostEffectShader** pp_effect)
+    {
+        assert(paths && count > 0);
+        try
+        {
+            *pp_effect = new PostEffectShader_Null(paths, count);
+            return true;
+        }
+        catch (...)
+        {
+            *pp_effect = nullptr;
+            return false;
+        }
+    }
+    bool Renderer_Null::drawPostEffect(
+        IPostEffectShader* p_effect,
+        BlendState blend,
+        ITexture2D* p_tex, SamplerState rtsv,
+        Vector4F const* cv, size_t cv_n,
+        ITexture2D* const* p_tex_arr, SamplerState const* sv, size_t tv_sv_n)
+    {
+        std::ignore = p_effect;
+        std::ignore = blend;
+        std::ignore = rtsv;
+        std::ignore = cv;
+        std::ignore = cv_n;
+        std::ignore = sv;
+
+        if (!endBatch()) return false;
+
+        _bound_program = SIZE_MAX;
+        _bound_state_valid = false;
+        bindTexture(p_tex, 0);
+        for (size_t i_ = 0; i_ < tv_sv_n && i_ + 1 < DrawCommand::texture_slot_count; i_ += 1)
+        {
+            bindTexture(p_tex_arr[i_], (uint8_t)(i_ + 1));
+        }
+        _statistics.program_switch += 1;
+        _statistics.post_effect += 1;
+        _statistics.draw += 1;
+        _statistics.vertex += 4;
+        _statistics.index += 6;
+
+        return beginBatch();
+    }
+    bool Renderer_Null::drawPostEffect(IPostEffectShader* p_effect, BlendState blend)
+    {
+        assert(p_effect);
+        std::ignore = blend;
+
+        if (!endBatch()) return false;
+
+        _bound_program = SIZE_MAX;
+        _bound_state_valid = false;
+        if (!p_effect->apply(this))
+        {
+            spdlog::error("[core] Cannot apply PostEffectShader variables");
+            return false;
+        }
+        _statistics.program_switch += 1;
+        _statistics.post_effect += 1;
+        _statistics.draw += 1;
+        _statistics.vertex += 4;
+        _statistics.index += 6;
+
+        return beginBatch();
+    }
+
+    bool Renderer_Null::createModel(StringView path, IModel** pp_model)
+    {
+        spdlog::error("[core] Cannot load model '{}', the null renderer does not support models", path);
+        *pp_model = nullptr;
+        return false;
+    }
+    bool Renderer_Null::drawModel(IModel* p_model)
+    {
+        std::ignore = p_model;
+        assert(false);
+        return false;
+    }
+
+    bool Renderer_Null::createMeshBuffer(IMeshBuffer** pp_mesh)
+    {
+        *pp_mesh = new MeshBuffer_Null();
+        return true;
+    }
+    bool Renderer_Null::drawMeshBuffer(IMeshBuffer* p_mesh)
+    {
+        assert(p_mesh);
+        auto* mesh_ = static_cast<MeshBuffer_Null*>(p_mesh);
+        if (mesh_->getVertexCount() == 0 || mesh_->getIndexCount() == 0)
+        {
+            return true;
+        }
+
+        if (!batchFlush()) return false;
+
+        ITexture2D* texture_ = _batch.getTexture();
+        DrawState const& state_ = _batch.getDrawState();
+        bindTexture(texture_, 0);
+        applyDrawState(state_);
+        // Mesh buffers have their own programs, after the regular, instanced and multi-texture ones
+        size_t const premul_ = (texture_ && texture_->isPremultipliedAlpha()) ? 1 : 0;
+        size_t const program_ = ((3 * IDX(VertexColorBlendState::MAX_COUNT) + IDX(state_.vertex_color_blend_state)) * IDX(FogState::MAX_COUNT) + IDX(state_.fog_state)) * IDX(TextureAlphaType::MAX_COUNT) + premul_;
+        if (_bound_program != program_)
+        {
+            _bound_program = program_;
+            _statistics.program_switch += 1;
+        }
+        if (mesh_->consumeDirty())
+        {
+            _statistics.mesh_buffer_upload += 1;
+        }
+        _statistics.draw += 1;
+        _statistics.vertex += mesh_->getVertexCount();
+        _statistics.index += mesh_->getIndexCount();
+
+        return true;
+    }
+
+    Graphics::SamplerState Renderer_Null::getKnownSamplerState(SamplerState state)
+    {
+        return _sampler_state[IDX(state)];
+    }
+
+    void Renderer_Null::endGpuFrame()
+    {
+        batchFlush(); // same as Renderer_OpenGL, the frame's draws are counted in this frame
+        // Only the counters Renderer_OpenGL has too
+        RendererFrameStatistics& frame_ = _last_frame_statistics;
+        frame_ = {};
+        for (size_t i_ = 0; i_ < IDX(RendererFrameStatistics::FlushCause::MAX_COUNT); i_ += 1)
+        {
+            frame_.flush[i_] = _statistics.flush[i_] - _frame_begin_statistics.flush[i_];
+        }
+        frame_.draw = _statistics.draw - _frame_begin_statistics.draw;
+        frame_.vertex = _statistics.vertex - _frame_begin_statistics.vertex;
+        frame_.index = _statistics.index - _frame_begin_statistics.index;
+        frame_.texture_bind = _statistics.texture_bind - _frame_begin_statistics.texture_bind;
+        frame_.program_switch = _statistics.program_switch - _frame_begin_statistics.program_switch;
+        frame_.post_effect = _statistics.post_effect - _frame_begin_statistics.post_effect;
+        _frame_begin_statistics = _statistics;
+    }
+
+    Renderer_Null::Renderer_Null(Device_Null* p_device)
+        : m_device(p_device)
+    {
+        InitializeConfigure config;
+        config.loadFromFile("config.json");
+        _batch.allocate(
+            std::clamp<size_t>((size_t)std::max(config.renderer_batch_vertex_capacity, 0), 1024, DrawList::max_vertex_capacity),
+            std::clamp<size_t>((size_t)std::max(config.renderer_batch_index_capacity, 0), 1536, DrawList::max_index_capacity),
+            std::max<size_t>((size_t)std::max(config.renderer_batch_command_capacity, 0), 64));
+        createStates();
+        spdlog::info("[core] Null Renderer Initialized");
+    }
+    Renderer_Null::~Renderer_Null()
+    {
+        uint64_t flush_ = 0;
+        for (uint64_t const n_ : _statistics.flush) flush_ += n_;
+        spdlog::info("[core] Null Renderer submitted {} draws ({} vertices, {} indices, {} instances) in {} flushes",
+            _statistics.draw, _statistics.vertex, _statistics.index, _statistics.instance, flush_);
+        spdlog::info("[core] Null Renderer state: {} texture binds, {} program switches, {} state changes, {} post effects, {} clears, {} render target switches",
+            _statistics.texture_bind, _statistics.program_switch, _statistics.state_change, _statistics.post_effect, _statistics.clear, _statistics.render_target_switch);
+    }
+
+    bool Renderer_Null::create(Device_Null* p_device, Renderer_Null** pp_renderer)
+    {
+        try
+        {
+            *pp_renderer = new Renderer_Null(p_device);
+            return true;
+        }
+        catch (...)
+        {
+            *pp_renderer = nullptr;
+            return false;
+        }
+    }
+}
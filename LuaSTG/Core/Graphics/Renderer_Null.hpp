@@ -0,0 +1,199 @@
+﻿#pragma once
+#include "Core/Object.hpp"
+#include "Core/Graphics/Renderer.hpp"
+#include "Core/Graphics/DrawBatch.hpp"
+#include "Core/Graphics/Device_Null.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define IDX(x) (size_t)static_cast<uint8_t>(x)
+
+namespace Core::Graphics
+{
+	// What Renderer_Null would have submitted to the GPU
+	struct NullRendererStatistics
+	{
+		uint64_t flush[(size_t)RendererFrameStatistics::FlushCause::MAX_COUNT]{};
+		uint64_t draw{};
+		uint64_t vertex{};
+		uint64_t index{};
+		uint64_t instance{};
+		uint64_t texture_bind{};
+		uint64_t program_switch{};
+		uint64_t state_change{}; // blend, depth, fog data, camera, viewport and scissor rect
+		uint64_t post_effect{};
+		uint64_t mesh_buffer_upload{};
+		uint64_t clear{};
+		uint64_t render_target_switch{};
+	};
+
+	class PostEffectShader_Null : public Object<IPostEffectShader>
+	{
+	private:
+		std::string m_path;
+
+	public:
+		bool setFloat(StringView name, float value) { std::ignore = name; std::ignore = value; return true; }
+		bool setFloat2(StringView name, Vector2F value) { std::ignore = name; std::ignore = value; return true; }
+		bool setFloat3(StringView name, Vector3F value) { std::ignore = name; std::ignore = value; return true; }
+		bool setFloat4(StringView name, Vector4F value) { std::ignore = name; std::ignore = value; return true; }
+		bool setTexture2D(StringView name, ITexture2D* p_texture) { std::ignore = name; return p_texture != nullptr; }
+		bool apply(IRenderer* p_renderer) { std::ignore = p_renderer; return true; }
+
+	public:
+		PostEffectShader_Null(StringView path);
+		PostEffectShader_Null(StringView const* paths, size_t count);
+		~PostEffectShader_Null();
+	};
+
+	class MeshBuffer_Null : public Object<IMeshBuffer>
+	{
+	private:
+		uint32_t m_vertex_count = 0;
+		uint32_t m_index_count = 0;
+		bool m_dirty = false;
+
+	public:
+		// True once after every setData, when the GL backend would upload the buffers
+		bool consumeDirty() noexcept { bool const dirty = m_dirty; m_dirty = false; return dirty; }
+
+	public:
+		bool setData(IRenderer::DrawVertex const* pvert, uint32_t nvert, IRenderer::DrawIndex const* pidx, uint32_t nidx)
+		{
+			std::ignore = pvert; std::ignore = pidx;
+			m_vertex_count = nvert; m_index_count = nidx; m_dirty = true;
+			return true;
+		}
+		uint32_t getVertexCount() { return m_vertex_count; }
+		uint32_t getIndexCount() { return m_index_count; }
+
+		void setScaling(Vector3F const& scale) { std::ignore = scale; }
+		void setPosition(Vector3F const& pos) { std::ignore = pos; }
+		void setRotationRollPitchYaw(float roll, float pitch, float yaw) { std::ignore = roll; std::ignore = pitch; std::ignore = yaw; }
+	};
+
+	// Batches with the same DrawBatch as Renderer_OpenGL, then counts the GL calls instead of making them
+	class Renderer_Null
+		: public Object<IRenderer>
+		, IDrawBatchListener
+	{
+	private:
+		ScopeObject<Device_Null> m_device;
+		DrawBatch _batch{ this };
+		DrawList& _draw_list = _batch.getDrawList(); // submitted by batchFlush
+		Graphics::SamplerState _sampler_state[IDX(SamplerState::MAX_COUNT)];
+
+		BoxF _ortho = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+		Vector3F _eye = { 0.0f, 0.0f, 0.0f };
+		Vector3F _lookat = { 0.0f, 0.0f, 1.0f };
+		Vector3F _headup = { 0.0f, 1.0f, 0.0f };
+		float _fov = 0.0f;
+		float _aspect = 0.0f;
+		float _znear = 0.0f;
+		float _zfar = 0.0f;
+		bool _is_3D = false;
+		BoxF _viewport = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+		RectF _scissor_rect = { 0.0f, 0.0f, 1.0f, 1.0f };
+		float _viewport_scale = 1.0f;
+		bool _state_dirty = false;
+		bool _batch_scope = false;
+
+		// Mirror of what the GL backend would have bound
+		ITexture2D* _bound_texture[DrawCommand::texture_slot_count] = {};
+		size_t _bound_program = SIZE_MAX;
+		DrawState _bound_state;
+		bool _bound_state_valid = false;
+
+		NullRendererStatistics _statistics; // since the renderer was created
+		NullRendererStatistics _frame_begin_statistics; // _statistics when the current frame began
+		RendererFrameStatistics _last_frame_statistics;
+		std::vector<GpuTimingZone> _gpu_zones;
+
+		bool onDrawBatchFull();
+		bool onDrawBatchResize();
+		void createStates();
+		void initState();
+		void invalidateTextures();
+		void bindTexture(ITexture2D* texture, uint8_t unit);
+		void bindProgram(DrawCommand const& cmd);
+		void applyDrawState(DrawState const& state);
+		bool batchFlush(RendererFrameStatistics::FlushCause cause = RendererFrameStatistics::FlushCause::Explicit, bool discard = false);
+
+	public:
+		NullRendererStatistics const& getStatistics() const noexcept { return _statistics; }
+
+	public:
+		bool beginBatch();
+		bool endBatch();
+		bool isBatchScope() { return _batch_scope; }
+		bool flush();
+
+		void clearRenderTarget(Color4B const& color);
+		void clearDepthBuffer(float zvalue);
+		void setRenderAttachment(IRenderTarget* p_rt);
+
+		void setOrtho(BoxF const& box);
+		void setPerspective(Vector3F const& eye, Vector3F const& lookat, Vector3F const& headup, float fov, float aspect, float znear, float zfar);
+
+		inline BoxF getViewport() { return _viewport; }
+		void setViewport(BoxF const& box);
+		void setScissorRect(RectF const& rect);
+		void setViewportAndScissorRect();
+		void setViewportScale(float scale);
+		float getViewportScale() { return _viewport_scale; }
+
+		void setVertexColorBlendState(VertexColorBlendState state) { _batch.setVertexColorBlendState(state); }
+		void setFogState(FogState state, Color4B const& color, float density_or_znear, float zfar) { _batch.setFogState(state, color, density_or_znear, zfar); }
+		void setDepthState(DepthState state) { _batch.setDepthState(state); }
+		void setBlendState(BlendState state) { _batch.setBlendState(state); }
+		void setTexture(ITexture2D* texture) { _batch.setTexture(texture); }
+		void setTextureBatching(bool enable) { _batch.setTextureBatching(enable); }
+		bool getTextureBatching() { return _batch.getTextureBatching(); }
+
+		bool drawTriangle(DrawVertex const& v1, DrawVertex const& v2, DrawVertex const& v3) { return _batch.drawTriangle(v1, v2, v3); }
+		bool drawTriangle(DrawVertex const* pvert) { return _batch.drawTriangle(pvert[0], pvert[1], pvert[2]); }
+		bool drawQuad(DrawVertex const& v1, DrawVertex const& v2, DrawVertex const& v3, DrawVertex const& v4) { return _batch.drawQuad(v1, v2, v3, v4); }
+		bool drawQuad(DrawVertex const* pvert) { return _batch.drawQuad(pvert[0], pvert[1], pvert[2], pvert[3]); }
+		bool drawRaw(DrawVertex const* pvert, uint32_t nvert, DrawIndex const* pidx, uint32_t nidx) { return _batch.drawRaw(pvert, nvert, pidx, nidx); }
+		bool drawRequest(uint32_t nvert, uint32_t nidx, DrawVertex** ppvert, DrawIndex** ppidx, DrawIndex* idxoffset) { return _batch.drawRequest(nvert, nidx, ppvert, ppidx, idxoffset); }
+		bool drawInstance(DrawInstance const& inst) { return _batch.drawInstances(&inst, 1); }
+		bool drawInstances(DrawInstance const* pinst, uint16_t ninst) { return _batch.drawInstances(pinst, ninst); }
+		bool canBatchInstance() { return _batch.canBatchInstance(); }
+
+		bool createPostEffectShader(StringView path, IPostEffectShader** pp_effect);
+		bool createPostEffectChain(StringView const* paths, size_t count, IPostEffectShader** pp_effect);
+		bool drawPostEffect(
+			IPostEffectShader* p_effect,
+			BlendState blend,
+			ITexture2D* p_tex, SamplerState rtsv,
+			Vector4F const* cv, size_t cv_n,
+			ITexture2D* const* p_tex_arr, SamplerState const* sv, size_t tv_sv_n);
+		bool drawPostEffect(IPostEffectShader* p_effect, BlendState blend);
+
+		bool createModel(StringView path, IModel** pp_model);
+		bool drawModel(IModel* p_model);
+
+		bool createMeshBuffer(IMeshBuffer** pp_mesh);
+		bool drawMeshBuffer(IMeshBuffer* p_mesh);
+
+		Graphics::SamplerState getKnownSamplerState(SamplerState state);
+
+		void beginGpuFrame() {}
+		void endGpuFrame();
+		void beginGpuZone(StringView name) { std::ignore = name; }
+		void endGpuZone() {}
+		double getGpuFrameTime() { return 0.0; }
+		std::vector<GpuTimingZone> const& getGpuZones() { return _gpu_zones; }
+		RendererFrameStatistics getFrameStatistics() { return _last_frame_statistics; }
+
+	public:
+		Renderer_Null(Device_Null* p_device);
+		~Renderer_Null();
+
+	public:
+		static bool create(Device_Null* p_device, Renderer_Null** pp_renderer);
+	};
+}
+
+#undef IDX
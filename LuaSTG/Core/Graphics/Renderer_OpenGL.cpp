@@ -3,6 +3,7 @@
 #include "Core/Graphics/Device_OpenGL.hpp"
 #include "Core/Graphics/Model_OpenGL.hpp"
 #include "Core/Graphics/Renderer.hpp"
+#include "Core/InitializeConfigure.hpp"
 #include "Core/Type.hpp"
 #include "TracyOpenGL.hpp"
 #include "glad/gl.h"
@@ -10,11 +11,21 @@
 #include "glm/ext/matrix_clip_space.hpp"
 #include "glm/ext/matrix_transform.hpp"
 #include "spdlog/spdlog.h"
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <optional>
 
 #define IDX(x) (size_t)static_cast<uint8_t>(x)
-using DrawIndex = uint16_t;
+using DrawIndex = Core::Graphics::IRenderer::DrawIndex;
+constexpr GLenum draw_index_type = sizeof(DrawIndex) < 4 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+// Counting is compiled out of release builds, see Core.cmake
+#ifdef LUASTG_RENDERER_STATISTICS
+#define RENDERER_STATISTICS_ADD(field, n) (_frame_statistics[_frame_statistics_index].field += (n))
+#else
+#define RENDERER_STATISTICS_ADD(field, n) ((void)0)
+#endif
 
 
 namespace Core::Graphics
@@ -35,6 +46,18 @@ namespace Core::Graphics
     {
         return get_view(static_cast<Texture2D_OpenGL*>(p.get()));
     }
+    inline bool is_same(Graphics::SamplerState const& a, Graphics::SamplerState const& b)
+    {
+        return a.filter.min == b.filter.min
+            && a.filter.mag == b.filter.mag
+            && a.address_u == b.address_u
+            && a.address_v == b.address_v
+            && a.mip_lod_bias == b.mip_lod_bias
+            && a.max_anisotropy == b.max_anisotropy
+            && a.min_lod == b.min_lod
+            && a.max_lod == b.max_lod
+            && a.border_color == b.border_color;
+    }
 
     // inline GLuint get_sampler(ISamplerState* p_sampler)
     // {
@@ -55,10 +78,6 @@ namespace Core::Graphics
     void PostEffectShader_OpenGL::onDeviceDestroy()
     {
         glDeleteProgram(opengl_prgm);
-        for (auto& v : m_buffer_map)
-        {
-            glDeleteBuffers(1, &v.second.opengl_buffer);
-        }
     }
 
     bool PostEffectShader_OpenGL::findVariable(StringView name, LocalConstantBuffer*& buf, LocalVariable*& val)
@@ -129,26 +148,26 @@ namespace Core::Graphics
 
         for (auto& v : m_buffer_map)
         {
-            glBindBuffer(GL_UNIFORM_BUFFER, v.second.opengl_buffer);
-            glBufferData(GL_UNIFORM_BUFFER, v.second.buffer.size(), v.second.buffer.data(), GL_STATIC_DRAW);
-            glBindBufferBase(GL_UNIFORM_BUFFER, v.second.binding, v.second.opengl_buffer);
+            if (v.second.buffer.empty()) continue;
+            static_cast<Renderer_OpenGL*>(p_renderer)->uploadUniformData(v.second.binding, v.second.buffer.data(), v.second.buffer.size());
         }
 
         for (auto& v : m_texture2d_map)
         {
             auto p_custom = v.second.texture->getSamplerState();
-            glActiveTexture(GL_TEXTURE0 + v.second.index);
-            glBindTexture(GL_TEXTURE_2D, v.second.texture->GetResource());
+            static_cast<Renderer_OpenGL*>(p_renderer)->bindTexture(v.second.index, v.second.texture->GetResource());
             static_cast<Renderer_OpenGL*>(p_renderer)->setSamplerState(p_custom.value_or(p_sampler), v.second.index);
         }
 
         return true;
     }
 
-    void PostEffectShader_OpenGL::bind(GLuint engine_data, GLuint user_data)
+    bool PostEffectShader_OpenGL::findBinding(std::string const& name, GLuint& binding)
     {
-        glBindBufferBase(GL_UNIFORM_BUFFER, m_buffer_map["engine_data"].binding, engine_data);
-        glBindBufferBase(GL_UNIFORM_BUFFER, m_buffer_map["user_data"].binding, user_data);
+        auto it = m_buffer_map.find(name);
+        if (it == m_buffer_map.end()) { return false; }
+        binding = it->second.binding;
+        return true;
     }
 
     PostEffectShader_OpenGL::PostEffectShader_OpenGL(Device_OpenGL* p_device, StringView path, bool is_path_)
@@ -160,12 +179,154 @@ namespace Core::Graphics
             throw std::runtime_error("PostEffectShader_OpenGL::PostEffectShader_OpenGL");
         m_device->addEventListener(this);
     }
+    PostEffectShader_OpenGL::PostEffectShader_OpenGL(Device_OpenGL* p_device, std::vector<std::string> chain)
+        : m_device(p_device)
+        , m_chain(std::move(chain))
+        , is_path(true)
+    {
+        if (!createResources())
+            throw std::runtime_error("PostEffectShader_OpenGL::PostEffectShader_OpenGL");
+        m_device->addEventListener(this);
+    }
     PostEffectShader_OpenGL::~PostEffectShader_OpenGL()
     {
         m_device->removeEventListener(this);
     }
 }
 
+namespace Core::Graphics
+{
+    bool MeshBuffer_OpenGL::createResources()
+    {
+        // Meshes can be created in the middle of a batch, leave the renderer's bindings alone
+        GLint last_vertex_array = 0;
+        GLint last_array_buffer = 0;
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &last_vertex_array);
+        glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &last_array_buffer);
+
+        glGenVertexArrays(1, &m_vao);
+        glGenBuffers(1, &m_vertex_buffer);
+        glGenBuffers(1, &m_index_buffer);
+        if (m_vao == 0 || m_vertex_buffer == 0 || m_index_buffer == 0)
+        {
+            spdlog::error("[core] Unable to create mesh buffer");
+            return false;
+        }
+
+        glBindVertexArray(m_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_index_buffer);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(IRenderer::DrawVertex), (const GLvoid *)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(IRenderer::DrawVertex), (const GLvoid *)offsetof(IRenderer::DrawVertex, u));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(IRenderer::DrawVertex), (const GLvoid *)offsetof(IRenderer::DrawVertex, color));
+        glEnableVertexAttribArray(2);
+
+        glBindVertexArray((GLuint)last_vertex_array);
+        glBindBuffer(GL_ARRAY_BUFFER, (GLuint)last_array_buffer);
+
+        m_vertex_capacity = 0;
+        m_index_capacity = 0;
+        m_dirty = true;
+        return true;
+    }
+    void MeshBuffer_OpenGL::onDeviceCreate()
+    {
+        createResources();
+    }
+    void MeshBuffer_OpenGL::onDeviceDestroy()
+    {
+        glDeleteVertexArrays(1, &m_vao);
+        glDeleteBuffers(1, &m_vertex_buffer);
+        glDeleteBuffers(1, &m_index_buffer);
+        m_vao = 0;
+        m_vertex_buffer = 0;
+        m_index_buffer = 0;
+    }
+
+    void MeshBuffer_OpenGL::upload()
+    {
+        if (!m_dirty)
+        {
+            return;
+        }
+        m_dirty = false;
+        glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer);
+        if (m_vertex.size() > m_vertex_capacity)
+        {
+            glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(m_vertex.size() * sizeof(IRenderer::DrawVertex)), m_vertex.data(), GL_STATIC_DRAW);
+            m_vertex_capacity = m_vertex.size();
+        }
+        else if (!m_vertex.empty())
+        {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(m_vertex.size() * sizeof(IRenderer::DrawVertex)), m_vertex.data());
+        }
+        // The element array binding belongs to our vertex array, which the caller has bound
+        if (m_index.size() > m_index_capacity)
+        {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(m_index.size() * sizeof(IRenderer::DrawIndex)), m_index.data(), GL_STATIC_DRAW);
+            m_index_capacity = m_index.size();
+        }
+        else if (!m_index.empty())
+        {
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, (GLsizeiptr)(m_index.size() * sizeof(IRenderer::DrawIndex)), m_index.data());
+        }
+    }
+
+    bool MeshBuffer_OpenGL::setData(IRenderer::DrawVertex const* pvert, uint32_t nvert, IRenderer::DrawIndex const* pidx, uint32_t nidx)
+    {
+        try
+        {
+            m_vertex.assign(pvert, pvert + nvert);
+            m_index.assign(pidx, pidx + nidx);
+        }
+        catch (...)
+        {
+            spdlog::error("[core] Unable to allocate memory for mesh buffer ({} vertices, {} indices)", nvert, nidx);
+            m_vertex.clear();
+            m_index.clear();
+            return false;
+        }
+        m_dirty = true;
+        return true;
+    }
+
+    void MeshBuffer_OpenGL::setScaling(Vector3F const& scale)
+    {
+        t_scale_ = glm::scale(glm::identity<glm::mat4>(), glm::vec3(scale.x, scale.y, scale.z));
+    }
+    void MeshBuffer_OpenGL::setPosition(Vector3F const& pos)
+    {
+        t_trans_ = glm::translate(glm::identity<glm::mat4>(), glm::vec3(pos.x, pos.y, pos.z));
+    }
+    void MeshBuffer_OpenGL::setRotationRollPitchYaw(float roll, float pitch, float yaw)
+    {
+        // Same order as Model_OpenGL
+        glm::mat4 m = glm::identity<glm::mat4>();
+        m = glm::rotate(m, pitch, glm::vec3(1, 0, 0));
+        m = glm::rotate(m, yaw, glm::vec3(0, 1, 0));
+        m = glm::rotate(m, roll, glm::vec3(0, 0, 1));
+        t_mbrot_ = m;
+    }
+
+    MeshBuffer_OpenGL::MeshBuffer_OpenGL(Device_OpenGL* p_device)
+        : m_device(p_device)
+    {
+        if (!createResources())
+        {
+            onDeviceDestroy();
+            throw std::runtime_error("MeshBuffer_OpenGL::MeshBuffer_OpenGL");
+        }
+        m_device->addEventListener(this);
+    }
+    MeshBuffer_OpenGL::~MeshBuffer_OpenGL()
+    {
+        m_device->removeEventListener(this);
+        onDeviceDestroy();
+    }
+}
+
 namespace Core::Graphics
 {
     void Renderer_OpenGL::setVertexIndexBuffer(size_t index)
@@ -173,7 +334,7 @@ namespace Core::Graphics
         index = (index == 0xFFFFFFFFu) ? _vi_buffer_index : index;
         auto& vi = _vi_buffer[index];
 
-        glBindVertexArray(_vao);
+        bindVertexArray(_vao);
         glBindBuffer(GL_ARRAY_BUFFER, vi.vertex_buffer);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vi.index_buffer);
 
@@ -183,12 +344,16 @@ namespace Core::Graphics
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DrawVertex), (const GLvoid *)offsetof(DrawVertex, color));
         glEnableVertexAttribArray(2);
+
+        glBindBuffer(GL_ARRAY_BUFFER, vi.slot_buffer);
+        glVertexAttribIPointer(3, 1, GL_UNSIGNED_BYTE, sizeof(uint8_t), (const GLvoid *)0);
+        glEnableVertexAttribArray(3);
     }
     bool Renderer_OpenGL::uploadVertexIndexBuffer(bool discard)
     {
         ZoneScoped;
         TracyGpuZone("UploadVertexIndexBuffer");
-        glBindVertexArray(_vao);
+        bindVertexArray(_vao);
         auto& vi_ = _vi_buffer[_vi_buffer_index];
         GLuint inv = discard ? GL_MAP_INVALIDATE_BUFFER_BIT : 0;
         // copy vertex data
@@ -204,7 +369,13 @@ namespace Core::Graphics
             // );
             // std::memcpy((DrawVertex*)map, _draw_list.vertex.data, _draw_list.vertex.size * sizeof(DrawVertex));
             // glUnmapBuffer(GL_ARRAY_BUFFER);
-            glBufferSubData(GL_ARRAY_BUFFER, vi_.vertex_offset * sizeof(DrawVertex), _draw_list.vertex.size * sizeof(DrawVertex), _draw_list.vertex.data);
+            glBufferSubData(GL_ARRAY_BUFFER, vi_.vertex_offset * sizeof(DrawVertex), _draw_list.vertex.size * sizeof(DrawVertex), _draw_list.vertex.data.data());
+        }
+        // copy texture slots, only read by commands with more than one texture
+        if (_draw_list.vertex.size > 0 && _draw_list.slot.used)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, vi_.slot_buffer);
+            glBufferSubData(GL_ARRAY_BUFFER, vi_.vertex_offset * sizeof(uint8_t), _draw_list.vertex.size * sizeof(uint8_t), _draw_list.slot.data.data());
         }
         // copy index data
         if (_draw_list.index.size > 0)
@@ -218,20 +389,98 @@ namespace Core::Graphics
             // );
             // std::memcpy((DrawIndex*)map, _draw_list.index.data, _draw_list.index.size * sizeof(DrawIndex));
             // glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
-            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, vi_.index_offset * sizeof(DrawIndex), _draw_list.index.size * sizeof(DrawIndex), _draw_list.index.data);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, vi_.index_offset * sizeof(DrawIndex), _draw_list.index.size * sizeof(DrawIndex), _draw_list.index.data.data());
+        }
+        // copy instance data
+        if (_draw_list.instance.size > 0)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, vi_.instance_buffer);
+            glBufferSubData(GL_ARRAY_BUFFER, vi_.instance_offset * sizeof(DrawInstance), _draw_list.instance.size * sizeof(DrawInstance), _draw_list.instance.data);
         }
         
         return true;
     }
-    void Renderer_OpenGL::clearDrawList()
+    bool UniformRingBuffer::create(GLsizeiptr size)
+    {
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        if (alignment <= 0) alignment = 256;
+        glGenBuffers(1, &buffer);
+        if (buffer == 0) return false;
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        capacity = size;
+        offset = 0;
+        GLint binding_count = 0;
+        glGetIntegerv(GL_MAX_UNIFORM_BUFFER_BINDINGS, &binding_count);
+        live.resize((size_t)std::max(binding_count, 1));
+        return true;
+    }
+    void UniformRingBuffer::destroy()
+    {
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+        capacity = 0;
+        offset = 0;
+        live.clear();
+    }
+    void UniformRingBuffer::write(GLuint binding, void const* data, GLsizeiptr size)
+    {
+        assert(buffer != 0 && size > 0 && size <= capacity && binding < live.size());
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        GLintptr const start = (offset + alignment - 1) / alignment * alignment;
+        if (start + size > capacity)
+        {
+            orphan(binding);
+        }
+        upload(binding, data, size);
+        auto const bytes = static_cast<uint8_t const*>(data);
+        live[binding].assign(bytes, bytes + size);
+    }
+    void UniformRingBuffer::orphan(GLuint binding)
     {
-        for (size_t j_ = 0; j_ < _draw_list.command.size; j_ += 1)
+        // Draws still in flight keep reading the old storage
+        glBufferData(GL_UNIFORM_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+        offset = 0;
+        // Ranges bound earlier now point into the new, undefined storage
+        for (GLuint i = 0; i < (GLuint)live.size(); i += 1)
         {
-            _draw_list.command.data[j_].texture.reset();
+            if (i == binding || live[i].empty())
+            {
+                continue;
+            }
+            GLint bound = 0;
+            glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, i, &bound);
+            if ((GLuint)bound != buffer)
+            {
+                live[i].clear(); // another buffer took the binding point over
+                continue;
+            }
+            upload(i, live[i].data(), (GLsizeiptr)live[i].size());
         }
-        _draw_list.vertex.size = 0;
-        _draw_list.index.size = 0;
-        _draw_list.command.size = 0;
+    }
+    void UniformRingBuffer::upload(GLuint binding, void const* data, GLsizeiptr size)
+    {
+        GLintptr const start = (offset + alignment - 1) / alignment * alignment;
+        assert(start + size <= capacity);
+        // Nothing has used this range since the last orphan, no need to wait for the GPU
+        void* ptr = glMapBufferRange(GL_UNIFORM_BUFFER, start, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (ptr)
+        {
+            std::memcpy(ptr, data, (size_t)size);
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+        }
+        else
+        {
+            glBufferSubData(GL_UNIFORM_BUFFER, start, size, data);
+        }
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, start, size);
+        offset = start + size;
+    }
+
+    void Renderer_OpenGL::clearDrawList()
+    {
+        _batch.clear();
+        _gl_shadow.invalidateTextures();
     }
 
     bool Renderer_OpenGL::createBuffers()
@@ -239,14 +488,56 @@ namespace Core::Graphics
         glGenVertexArrays(1, &_vao);
         if (_vao == 0) return false;
 
+        glGenVertexArrays(1, &_instance_vao);
+        if (_instance_vao == 0) return false;
+        glBindVertexArray(_instance_vao);
+        // Attribute pointers are set in batchFlush, the instance offset changes with every command
+        for (GLuint attr_ = 0; attr_ < 5; attr_ += 1)
+        {
+            glEnableVertexAttribArray(attr_);
+            glVertexAttribDivisor(attr_, 1);
+        }
+
         glGenBuffers(1, &_fx_vbuffer);
         if (_fx_vbuffer == 0) return false;
 
-        DrawIndex const idx_[6] = { 0, 1, 2, 0, 2, 3 };
-        glGenBuffers(1, &_fx_ibuffer);
-        if (_fx_ibuffer == 0) return false;
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _fx_ibuffer);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(idx_), &idx_, GL_STATIC_DRAW);
+        if (!createBatchBuffers()) return false;
+
+        // A few hundred camera, fog and post effect updates before the storage is orphaned
+        if (!_uniform_ring.create(256 * 1024)) return false;
+
+        glGenBuffers(1, &_world_matrix_buffer);
+        if (_world_matrix_buffer == 0) return false;
+        {
+            glm::mat4 const identity_ = glm::identity<glm::mat4>();
+            glBindBuffer(GL_UNIFORM_BUFFER, _world_matrix_buffer);
+            glBufferData(GL_UNIFORM_BUFFER, sizeof(identity_), &identity_, GL_STATIC_DRAW);
+        }
+
+        return true;
+    }
+    bool Renderer_OpenGL::createBatchBuffers()
+    {
+        // Sprite quads always follow the same pattern, so their indices are built once
+        glGenBuffers(1, &_quad_ibuffer);
+        if (_quad_ibuffer == 0) return false;
+        {
+            std::vector<DrawIndex> idx_((_draw_list.vertex.capacity / 4) * 6);
+            for (size_t q_ = 0; q_ < _draw_list.vertex.capacity / 4; q_ += 1)
+            {
+                DrawIndex const v_ = (DrawIndex)(q_ * 4);
+                DrawIndex* ibuf_ = idx_.data() + q_ * 6;
+                ibuf_[0] = v_;
+                ibuf_[1] = v_ + 1;
+                ibuf_[2] = v_ + 2;
+                ibuf_[3] = v_;
+                ibuf_[4] = v_ + 2;
+                ibuf_[5] = v_ + 3;
+            }
+            bindVertexArray(_vao);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _quad_ibuffer);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx_.size() * sizeof(DrawIndex), idx_.data(), GL_STATIC_DRAW);
+        }
 
         for (auto& vi_ : _vi_buffer)
         {
@@ -261,25 +552,49 @@ namespace Core::Graphics
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vi_.index_buffer);
             // glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, _draw_list.index.capacity * sizeof(DrawIndex), 0, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
             glBufferData(GL_ELEMENT_ARRAY_BUFFER, _draw_list.index.capacity * sizeof(DrawIndex), 0, GL_DYNAMIC_DRAW);
-        }
 
-        glGenBuffers(1, &_vp_matrix_buffer);
-        if (_vp_matrix_buffer == 0) return false;
+            glGenBuffers(1, &vi_.instance_buffer);
+            if (vi_.instance_buffer == 0) return false;
+            glBindBuffer(GL_ARRAY_BUFFER, vi_.instance_buffer);
+            glBufferData(GL_ARRAY_BUFFER, _draw_list.instance.capacity * sizeof(DrawInstance), 0, GL_DYNAMIC_DRAW);
 
-        glGenBuffers(1, &_world_matrix_buffer);
-        if (_world_matrix_buffer == 0) return false;
-
-        glGenBuffers(1, &_camera_pos_buffer);
-        if (_camera_pos_buffer == 0) return false;
-
-        glGenBuffers(1, &_fog_data_buffer);
-        if (_fog_data_buffer == 0) return false;
-
-        glGenBuffers(1, &_user_float_buffer);
-        if (_user_float_buffer == 0) return false;
+            glGenBuffers(1, &vi_.slot_buffer);
+            if (vi_.slot_buffer == 0) return false;
+            glBindBuffer(GL_ARRAY_BUFFER, vi_.slot_buffer);
+            glBufferData(GL_ARRAY_BUFFER, _draw_list.vertex.capacity * sizeof(uint8_t), 0, GL_DYNAMIC_DRAW);
+        }
 
         return true;
     }
+    void Renderer_OpenGL::destroyBatchBuffers()
+    {
+        glDeleteBuffers(1, &_quad_ibuffer);
+        _quad_ibuffer = 0;
+        for (auto& v : _vi_buffer)
+        {
+            glDeleteBuffers(1, &v.vertex_buffer);
+            glDeleteBuffers(1, &v.index_buffer);
+            glDeleteBuffers(1, &v.instance_buffer);
+            glDeleteBuffers(1, &v.slot_buffer);
+            v = VertexIndexBuffer();
+        }
+        _vi_buffer_index = 0;
+    }
+    bool Renderer_OpenGL::onDrawBatchFull()
+    {
+        return batchFlush(RendererFrameStatistics::FlushCause::BufferFull);
+    }
+    bool Renderer_OpenGL::onDrawBatchResize()
+    {
+        destroyBatchBuffers();
+        if (!createBatchBuffers())
+        {
+            spdlog::error("[core] Unable to create buffers");
+            return false;
+        }
+        setVertexIndexBuffer();
+        return true;
+    }
     bool Renderer_OpenGL::createStates()
     {
         {
@@ -324,6 +639,11 @@ namespace Core::Graphics
             _sampler_state[IDX(SamplerState::LinearBorderWhite)].address_u = TextureAddressMode::Border;
             _sampler_state[IDX(SamplerState::LinearBorderWhite)].address_v = TextureAddressMode::Border;
             _sampler_state[IDX(SamplerState::LinearBorderWhite)].border_color = BorderColor::White;
+
+            for (auto const& v : _sampler_state)
+            {
+                getSamplerObject(v);
+            }
         }
 
         return true;
@@ -331,6 +651,8 @@ namespace Core::Graphics
     void Renderer_OpenGL::initState()
     {
         _state_dirty = true;
+        _gl_state_valid = false; // someone else may have touched GL state (post effects, models, imgui)
+        _batch.invalidateState();
 
         if (!_camera_state_set.is_3D)
         {
@@ -344,13 +666,9 @@ namespace Core::Graphics
         setViewport(_state_set.viewport);
         setScissorRect(_state_set.scissor_rect);
 
-        setVertexColorBlendState(_state_set.vertex_color_blend_state);
-        setTexture(_state_texture.get());
+        setTexture(_batch.getTexture());
         setSamplerState(_state_set.sampler_state, 0);
-        setFogState(_state_set.fog_state, _state_set.fog_color, _state_set.fog_near_or_density, _state_set.fog_far);
-        setDepthState(_state_set.depth_state);
-        setBlendState(_state_set.blend_state);
-        bindTextureAlphaType(_state_texture.get());
+        bindTextureAlphaType(_batch.getTexture());
         
         _state_dirty = false;
     }
@@ -365,26 +683,40 @@ namespace Core::Graphics
     }
     void Renderer_OpenGL::setSamplerState(Graphics::SamplerState state, GLuint index)
     {
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, state.max_anisotropy);
+        bindSampler(index, getSamplerObject(state));
+    }
+    GLuint Renderer_OpenGL::getSamplerObject(Graphics::SamplerState const& state)
+    {
+        for (auto const& v : _sampler_objects)
+        {
+            if (is_same(v.first, state))
+                return v.second;
+        }
+
+        GLuint sampler = 0;
+        glGenSamplers(1, &sampler);
+        _sampler_objects.emplace_back(state, sampler);
+
+        glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, state.max_anisotropy);
         switch (state.filter.min)
         {
         case FilterMode::Nearest:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
             break;
         case FilterMode::NearestMipNearest:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+            glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
             break;
         case FilterMode::NearestMipLinear:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+            glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
             break;
         case FilterMode::Linear:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
             break;
         case FilterMode::LinearMipNearest:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+            glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
             break;
         case FilterMode::LinearMipLinear:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
             break;
         }
         switch (state.filter.mag)
@@ -393,41 +725,41 @@ namespace Core::Graphics
             assert(false);
             break;
         case FilterMode::Nearest:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
             break;
         case FilterMode::Linear:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
             break;
         }
 
         switch (state.address_u)
         {
         case TextureAddressMode::Wrap:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_REPEAT);
             break;
         case TextureAddressMode::Mirror:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
+            glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
             break;
         case TextureAddressMode::Clamp:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
             break;
         case TextureAddressMode::Border:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+            glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
             break;
         }
         switch (state.address_v)
         {
         case TextureAddressMode::Wrap:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_REPEAT);
             break;
         case TextureAddressMode::Mirror:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
+            glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
             break;
         case TextureAddressMode::Clamp:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
             break;
         case TextureAddressMode::Border:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+            glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
             break;
         }
 
@@ -457,24 +789,94 @@ namespace Core::Graphics
             }
 
         #undef makeColor
-            glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, &borderColor[0]);
+            glSamplerParameterfv(sampler, GL_TEXTURE_BORDER_COLOR, &borderColor[0]);
         }
 
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, state.mip_lod_bias);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_NEVER);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, state.min_lod);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_LOD, state.max_lod);
+        glSamplerParameterf(sampler, GL_TEXTURE_LOD_BIAS, state.mip_lod_bias);
+        glSamplerParameteri(sampler, GL_TEXTURE_COMPARE_FUNC, GL_NEVER);
+        glSamplerParameterf(sampler, GL_TEXTURE_MIN_LOD, state.min_lod);
+        glSamplerParameterf(sampler, GL_TEXTURE_MAX_LOD, state.max_lod);
+
+        return sampler;
+    }
+    void Renderer_OpenGL::selectTextureUnit(GLuint unit)
+    {
+        if (_gl_shadow.active_texture_unit != unit)
+        {
+            glActiveTexture(GL_TEXTURE0 + unit);
+            _gl_shadow.active_texture_unit = unit;
+        }
+    }
+    void Renderer_OpenGL::bindTexture(GLuint unit, GLuint texture)
+    {
+        if (unit < GLStateShadow::texture_unit_count && _gl_shadow.texture[unit] == texture)
+        {
+            RENDERER_STATISTICS_ADD(texture_bind_skipped, 1);
+            return;
+        }
+        selectTextureUnit(unit);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        RENDERER_STATISTICS_ADD(texture_bind, 1);
+        if (unit < GLStateShadow::texture_unit_count)
+            _gl_shadow.texture[unit] = texture;
+    }
+    void Renderer_OpenGL::bindSampler(GLuint unit, GLuint sampler)
+    {
+        if (unit < GLStateShadow::texture_unit_count && _gl_shadow.sampler[unit] == sampler)
+        {
+            RENDERER_STATISTICS_ADD(sampler_bind_skipped, 1);
+            return;
+        }
+        glBindSampler(unit, sampler);
+        RENDERER_STATISTICS_ADD(sampler_bind, 1);
+        if (unit < GLStateShadow::texture_unit_count)
+            _gl_shadow.sampler[unit] = sampler;
+    }
+    void Renderer_OpenGL::unbindSamplers()
+    {
+        // Models and imgui rely on the texture's own parameters, which a bound sampler object overrides
+        for (GLuint unit = 0; unit < GLStateShadow::texture_unit_count; unit += 1)
+        {
+            if (_gl_shadow.sampler[unit] != 0)
+            {
+                glBindSampler(unit, 0);
+                _gl_shadow.sampler[unit] = 0;
+            }
+        }
+    }
+    void Renderer_OpenGL::useProgram(GLuint program)
+    {
+        if (_gl_shadow.program == program)
+        {
+            RENDERER_STATISTICS_ADD(program_switch_skipped, 1);
+            return;
+        }
+        glUseProgram(program);
+        RENDERER_STATISTICS_ADD(program_switch, 1);
+        _gl_shadow.program = program;
+    }
+    void Renderer_OpenGL::bindVertexArray(GLuint vertex_array)
+    {
+        if (_gl_shadow.vertex_array == vertex_array)
+        {
+            RENDERER_STATISTICS_ADD(vertex_array_bind_skipped, 1);
+            return;
+        }
+        glBindVertexArray(vertex_array);
+        _gl_shadow.vertex_array = vertex_array;
     }
     bool Renderer_OpenGL::uploadVertexIndexBufferFromDrawList()
     {
         // upload data
         if ((_draw_list.vertex.capacity - _vi_buffer[_vi_buffer_index].vertex_offset) < _draw_list.vertex.size
-            || (_draw_list.index.capacity - _vi_buffer[_vi_buffer_index].index_offset) < _draw_list.index.size)
+            || (_draw_list.index.capacity - _vi_buffer[_vi_buffer_index].index_offset) < _draw_list.index.size
+            || (_draw_list.instance.capacity - _vi_buffer[_vi_buffer_index].instance_offset) < _draw_list.instance.size)
         {
             // next buffer
             _vi_buffer_index = (_vi_buffer_index + 1) % _vi_buffer_count;
             _vi_buffer[_vi_buffer_index].vertex_offset = 0;
             _vi_buffer[_vi_buffer_index].index_offset = 0;
+            _vi_buffer[_vi_buffer_index].instance_offset = 0;
             // discard and copy
             if (!uploadVertexIndexBuffer(true))
             {
@@ -498,14 +900,12 @@ namespace Core::Graphics
         }
         return true;
     }
-    void Renderer_OpenGL::bindTextureSamplerState(ITexture2D* texture)
+    void Renderer_OpenGL::bindTextureSamplerState(ITexture2D* texture, GLuint unit)
     {
         std::optional<Graphics::SamplerState> sampler_from_texture = texture ? texture->getSamplerState() : std::optional<Graphics::SamplerState>();
         Graphics::SamplerState sampler = sampler_from_texture.value_or(_sampler_state[IDX(_state_set.sampler_state)]);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, static_cast<Texture2D_OpenGL*>(texture)->GetResource());
-        setSamplerState(sampler, 0);
-        // glBindSampler(0, static_cast<SamplerState_OpenGL*>(sampler)->GetState());
+        bindTexture(unit, texture ? static_cast<Texture2D_OpenGL*>(texture)->GetResource() : 0); // nothing set yet, e.g. a mesh drawn first
+        setSamplerState(sampler, unit);
     }
     void Renderer_OpenGL::bindTextureAlphaType(ITexture2D* texture)
     {
@@ -525,37 +925,180 @@ namespace Core::Graphics
 
         // glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 2, subroutines);
     }
-    bool Renderer_OpenGL::batchFlush(bool discard)
+    void Renderer_OpenGL::applyDrawState(DrawState const& state)
+    {
+        if (!_gl_state_valid || _gl_state.depth_state != state.depth_state)
+        {
+            if (state.depth_state == DepthState::Enable)
+                glEnable(GL_DEPTH_TEST);
+            else
+                glDisable(GL_DEPTH_TEST);
+        }
+        if (_gl_state_valid && _gl_state.blend_state == state.blend_state)
+        {
+            RENDERER_STATISTICS_ADD(blend_state_skipped, 1);
+        }
+        else
+        {
+            switch (state.blend_state) {
+            default: assert(false); break;
+            case BlendState::Disable:
+                glDisable(GL_BLEND);
+                break;
+            case BlendState::Alpha:
+                glEnable(GL_BLEND);
+                glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+                glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
+                break;
+            case BlendState::One:
+                glEnable(GL_BLEND);
+                glBlendFuncSeparate(GL_ONE, GL_ZERO, GL_ONE, GL_ZERO);
+                glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
+                break;
+            case BlendState::Min:
+                glEnable(GL_BLEND);
+                glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
+                glBlendEquationSeparate(GL_MIN, GL_MIN);
+                break;
+            case BlendState::Max:
+                glEnable(GL_BLEND);
+                glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
+                glBlendEquationSeparate(GL_MAX, GL_MAX);
+                break;
+            case BlendState::Mul:
+                glEnable(GL_BLEND);
+                glBlendFuncSeparate(GL_DST_COLOR, GL_ZERO, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+                glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
+                break;
+            case BlendState::Screen:
+                glEnable(GL_BLEND);
+                glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_COLOR, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+                glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
+                break;
+            case BlendState::Add:
+                glEnable(GL_BLEND);
+                glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+                glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
+                break;
+            case BlendState::Sub:
+                glEnable(GL_BLEND);
+                glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+                glBlendEquationSeparate(GL_FUNC_SUBTRACT, GL_FUNC_ADD);
+                break;
+            case BlendState::RevSub:
+                glEnable(GL_BLEND);
+                glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+                glBlendEquationSeparate(GL_FUNC_REVERSE_SUBTRACT, GL_FUNC_ADD);
+                break;
+            case BlendState::Inv:
+                glEnable(GL_BLEND);
+                glBlendFuncSeparate(GL_ONE_MINUS_DST_COLOR, GL_ONE_MINUS_SRC_COLOR, GL_ZERO, GL_ONE);
+                glBlendEquationSeparate(GL_FUNC_REVERSE_SUBTRACT, GL_FUNC_ADD);
+                break;
+            }
+        }
+        if (!_gl_state_valid || !_gl_state.isFogDataEqual(state))
+        {
+            float const fog_color_and_range[8] = {
+                (float)state.fog_color.r / 255.0f,
+                (float)state.fog_color.g / 255.0f,
+                (float)state.fog_color.b / 255.0f,
+                (float)state.fog_color.a / 255.0f,
+                state.fog_near_or_density, state.fog_far, 0.0f, state.fog_far - state.fog_near_or_density,
+            };
+            _uniform_ring.write(3, fog_color_and_range, sizeof(fog_color_and_range));
+        }
+        _gl_state = state;
+        _gl_state_valid = true;
+    }
+    bool Renderer_OpenGL::batchFlush(RendererFrameStatistics::FlushCause cause, bool discard)
     {
         ZoneScoped;
+        std::ignore = cause;
         if (!discard)
         {
             TracyGpuZone("BatchFlush");
+            if (_draw_list.vertex.size > 0 || _draw_list.instance.size > 0)
+            {
+                RENDERER_STATISTICS_ADD(flush[IDX(cause)], 1);
+            }
             // upload data
             if (!uploadVertexIndexBufferFromDrawList()) return false;
             // draw
             if (_draw_list.command.size > 0)
             {
                 VertexIndexBuffer& vi_ = _vi_buffer[_vi_buffer_index];
+                GLuint ibuffer_ = 0;
                 for (size_t j_ = 0; j_ < _draw_list.command.size; j_ += 1)
                 {
                     DrawCommand& cmd_ = _draw_list.command.data[j_];
+                    if (cmd_.type == DrawCommand::Type::Instance)
+                    {
+                        if (cmd_.instance_count > 0)
+                        {
+                            bindTextureAlphaType(cmd_.texture[0].get());
+                            bindTextureSamplerState(cmd_.texture[0].get());
+                            applyDrawState(cmd_.state);
+                            useProgram(_programs_instance[IDX(cmd_.state.vertex_color_blend_state)][IDX(cmd_.state.fog_state)][IDX(_state_set.texture_alpha_type)]);
+                            bindVertexArray(_instance_vao);
+                            // No base instance in GL 4.1, point the attributes at this command's instances instead
+                            size_t const base_ = vi_.instance_offset * sizeof(DrawInstance);
+                            glBindBuffer(GL_ARRAY_BUFFER, vi_.instance_buffer);
+                            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DrawInstance), (const GLvoid *)(base_ + offsetof(DrawInstance, x)));
+                            glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(DrawInstance), (const GLvoid *)(base_ + offsetof(DrawInstance, l)));
+                            glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(DrawInstance), (const GLvoid *)(base_ + offsetof(DrawInstance, u0)));
+                            glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DrawInstance), (const GLvoid *)(base_ + offsetof(DrawInstance, color)));
+                            glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(DrawInstance), (const GLvoid *)(base_ + offsetof(DrawInstance, sx)));
+                            // Same winding as the static quad index buffer: 0-1-2/0-2-3
+                            glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, cmd_.instance_count);
+                            RENDERER_STATISTICS_ADD(draw, 1);
+                            RENDERER_STATISTICS_ADD(vertex, 4u * cmd_.instance_count);
+                        }
+                        vi_.instance_offset += cmd_.instance_count;
+                        continue;
+                    }
                     if (cmd_.vertex_count > 0 && cmd_.index_count > 0)
                     {
-                        bindTextureAlphaType(cmd_.texture.get());
-                        bindTextureSamplerState(cmd_.texture.get());
-                        glUseProgram(_programs[IDX(_state_set.vertex_color_blend_state)][IDX(_state_set.fog_state)][IDX(_state_set.texture_alpha_type)]);
+                        bindTextureAlphaType(cmd_.texture[0].get()); // same for every slot
+                        for (uint8_t t_ = cmd_.texture_count; t_ > 0; t_ -= 1)
+                        {
+                            bindTextureSamplerState(cmd_.texture[t_ - 1].get(), t_ - 1); // ends on unit 0
+                        }
+                        applyDrawState(cmd_.state);
+                        if (cmd_.texture_count > 1)
+                            useProgram(_programs_multi[IDX(cmd_.state.vertex_color_blend_state)][IDX(cmd_.state.fog_state)][IDX(_state_set.texture_alpha_type)]);
+                        else
+                            useProgram(_programs[IDX(cmd_.state.vertex_color_blend_state)][IDX(cmd_.state.fog_state)][IDX(_state_set.texture_alpha_type)]);
+                        bindVertexArray(_vao);
+                        GLuint const cmd_ibuffer_ = (cmd_.type == DrawCommand::Type::Quad) ? _quad_ibuffer : vi_.index_buffer;
+                        if (ibuffer_ != cmd_ibuffer_)
+                        {
+                            ibuffer_ = cmd_ibuffer_;
+                            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibuffer_);
+                        }
                         // glDrawElementsBaseVertex(GL_TRIANGLES, cmd_.index_count, GL_UNSIGNED_SHORT, 0, vi_.index_offset);
-                        glDrawElementsBaseVertex(GL_TRIANGLES, cmd_.index_count, GL_UNSIGNED_SHORT, (void*)(vi_.index_offset * sizeof(DrawIndex)), vi_.vertex_offset);
+                        if (cmd_.type == DrawCommand::Type::Quad)
+                            glDrawElementsBaseVertex(GL_TRIANGLES, cmd_.index_count, draw_index_type, (void*)0, vi_.vertex_offset);
+                        else
+                            glDrawElementsBaseVertex(GL_TRIANGLES, cmd_.index_count, draw_index_type, (void*)(vi_.index_offset * sizeof(DrawIndex)), vi_.vertex_offset);
+                        RENDERER_STATISTICS_ADD(draw, 1);
+                        RENDERER_STATISTICS_ADD(vertex, cmd_.vertex_count);
+                        RENDERER_STATISTICS_ADD(index, cmd_.index_count);
                     }
                     vi_.vertex_offset += cmd_.vertex_count;
-                    vi_.index_offset += cmd_.index_count;
+                    if (cmd_.type == DrawCommand::Type::Indexed)
+                        vi_.index_offset += cmd_.index_count;
+                }
+                bindVertexArray(_vao); // uploads bind the index buffer into whatever VAO is current
+                if (ibuffer_ != vi_.index_buffer)
+                {
+                    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vi_.index_buffer);
                 }
             }
         }
         // clear
-        clearDrawList();
-        setTexture(_state_texture.get());
+        _gl_shadow.invalidateTextures();
+        _batch.restart();
         return true;
     }
 
@@ -589,47 +1132,48 @@ namespace Core::Graphics
     }
     void Renderer_OpenGL::onDeviceDestroy()
     {
-        batchFlush(true);
+        batchFlush(RendererFrameStatistics::FlushCause::Explicit, true);
 
-        _state_texture.reset();
+        _batch.resetTexture();
 
         glDeleteBuffers(1, &_fx_vbuffer);
-        glDeleteBuffers(1, &_fx_ibuffer);
-        for (auto& v : _vi_buffer)
+        glDeleteVertexArrays(1, &_instance_vao);
+        destroyBatchBuffers();
+
+        _uniform_ring.destroy();
+        glDeleteBuffers(1, &_world_matrix_buffer);
+
+        for (auto& v : _sampler_objects)
         {
-            glDeleteBuffers(1, &v.vertex_buffer);
-            glDeleteBuffers(1, &v.index_buffer);
-            v.vertex_offset = 0;
-            v.index_offset = 0;
+            glDeleteSamplers(1, &v.second);
         }
-        _vi_buffer_index = 0;
+        _sampler_objects.clear();
+        _gl_shadow.invalidate();
 
-        glDeleteBuffers(1, &_vp_matrix_buffer);
-        glDeleteBuffers(1, &_world_matrix_buffer);
-        glDeleteBuffers(1, &_camera_pos_buffer);
-        glDeleteBuffers(1, &_fog_data_buffer);
-        glDeleteBuffers(1, &_user_float_buffer);
+        m_gpu_timer.destroy();
 
 
         for (int i = 0; i < IDX(VertexColorBlendState::MAX_COUNT); i++)
         for (int j = 0; j < IDX(FogState::MAX_COUNT); j++)
         for (int k = 0; k < IDX(TextureAlphaType::MAX_COUNT); k++)
+        {
             glDeleteProgram(_programs[i][j][k]);
+            glDeleteProgram(_programs_instance[i][j][k]);
+            glDeleteProgram(_programs_multi[i][j][k]);
+            glDeleteProgram(_programs_mesh[i][j][k]);
+        }
 
         spdlog::info("[core] Renderer Destroyed");
     }
 
     bool Renderer_OpenGL::beginBatch()
     {
+        _gl_shadow.invalidate(); // post effects, models and imgui bind things directly
         setVertexIndexBuffer();
 
-        // GLuint bufs[4] = {
-        glBindBufferBase(GL_UNIFORM_BUFFER, 0, _vp_matrix_buffer);
+        // View projection matrix and fog data are written again by initState
         glBindBufferBase(GL_UNIFORM_BUFFER, 1, _world_matrix_buffer);
-        glBindBufferBase(GL_UNIFORM_BUFFER, 2, _camera_pos_buffer);
-        glBindBufferBase(GL_UNIFORM_BUFFER, 3, _fog_data_buffer);
-        // };
-        // glBindBuffersBase(GL_UNIFORM_BUFFER, 0, 4, bufs);
+        _uniform_ring.write(2, _camera_pos_data, sizeof(_camera_pos_data));
 
         initState();
 
@@ -641,7 +1185,8 @@ namespace Core::Graphics
         _batch_scope = false;
         if (!batchFlush())
             return false;
-        _state_texture.reset();
+        unbindSamplers();
+        _batch.resetTexture();
         return true;
     }
     bool Renderer_OpenGL::flush()
@@ -651,7 +1196,7 @@ namespace Core::Graphics
 
     void Renderer_OpenGL::clearRenderTarget(Color4B const& color)
     {
-        batchFlush();
+        batchFlush(RendererFrameStatistics::FlushCause::RenderTarget);
         glClearColor(
             (float)color.r / 255.0f,
             (float)color.g / 255.0f,
@@ -662,14 +1207,14 @@ namespace Core::Graphics
     }
     void Renderer_OpenGL::clearDepthBuffer(float zvalue)
     {
-        batchFlush();
+        batchFlush(RendererFrameStatistics::FlushCause::RenderTarget);
         glClearDepth(zvalue);
 
         glClear(GL_DEPTH_BUFFER_BIT);
     }
     void Renderer_OpenGL::setRenderAttachment(IRenderTarget* p_rt)
     {
-        batchFlush();
+        batchFlush(RendererFrameStatistics::FlushCause::RenderTarget);
         glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<RenderTarget_OpenGL*>(p_rt)->GetFramebuffer());
     }
 
@@ -677,22 +1222,19 @@ namespace Core::Graphics
     {
         if (_state_dirty || !_camera_state_set.isEqual(box))
         {
-            batchFlush();
+            batchFlush(RendererFrameStatistics::FlushCause::StateChange);
             _camera_state_set.ortho = box;
             _camera_state_set.is_3D = false;
             glm::mat4 m4 = glm::orthoLH_ZO(box.a.x, box.b.x, box.a.y, box.b.y, box.a.z, box.b.z);
             // spdlog::info("[core] setOrtho: {} {} {} {}", box.a.x, box.b.x, box.b.y, box.a.y);
-            /* upload vp matrix */ {
-                glBindBuffer(GL_UNIFORM_BUFFER, _vp_matrix_buffer);
-                glBufferData(GL_UNIFORM_BUFFER, sizeof(m4), &m4, GL_STATIC_DRAW);
-            }
+            _uniform_ring.write(0, &m4, sizeof(m4));
         }
     }
     void Renderer_OpenGL::setPerspective(Vector3F const& eye, Vector3F const& lookat, Vector3F const& headup, float fov, float aspect, float znear, float zfar)
     {
         if (_state_dirty || !_camera_state_set.isEqual(eye, lookat, headup, fov, aspect, znear, zfar))
         {
-            batchFlush();
+            batchFlush(RendererFrameStatistics::FlushCause::StateChange);
             _camera_state_set.eye = eye;
             _camera_state_set.lookat = lookat;
             _camera_state_set.headup = headup;
@@ -709,16 +1251,9 @@ namespace Core::Graphics
                 eye.x, eye.y, eye.z, 0.0f,
                 lookatf3.x - eyef3.x, lookatf3.y - eyef3.y, lookatf3.z - eyef3.z, 0.0f,
             };
-            // auto* ctx = m_device->GetD3D11DeviceContext();
-            // assert(ctx);
-            /* upload vp matrix */ {
-                glBindBuffer(GL_UNIFORM_BUFFER, _vp_matrix_buffer);
-                glBufferData(GL_UNIFORM_BUFFER, sizeof(m4), &m4, GL_STATIC_DRAW);
-            }
-            /* upload camera pos */ {
-                glBindBuffer(GL_UNIFORM_BUFFER, _camera_pos_buffer);
-                glBufferData(GL_UNIFORM_BUFFER, sizeof(camera_pos), &camera_pos, GL_STATIC_DRAW);
-            }
+            std::memcpy(_camera_pos_data, camera_pos, sizeof(camera_pos));
+            _uniform_ring.write(0, &m4, sizeof(m4));
+            _uniform_ring.write(2, camera_pos, sizeof(camera_pos));
         }
     }
 
@@ -726,18 +1261,20 @@ namespace Core::Graphics
     {
         if (_state_dirty || _state_set.viewport != box)
         {
-            batchFlush();
+            batchFlush(RendererFrameStatistics::FlushCause::StateChange);
             _state_set.viewport = box;
-            glViewport((GLint)box.a.x, (GLint)box.a.y, (GLint)box.b.x - (GLint)box.a.x, (GLint)box.b.y - (GLint)box.a.y);
+            float const s = _viewport_scale;
+            glViewport((GLint)(box.a.x * s), (GLint)(box.a.y * s), (GLint)(box.b.x * s) - (GLint)(box.a.x * s), (GLint)(box.b.y * s) - (GLint)(box.a.y * s));
         }
     }
     void Renderer_OpenGL::setScissorRect(RectF const& rect)
     {
         if (_state_dirty || _state_set.scissor_rect != rect)
         {
-            batchFlush();
+            batchFlush(RendererFrameStatistics::FlushCause::StateChange);
             _state_set.scissor_rect = rect;
-            glScissor((GLint)rect.a.x, (GLint)rect.a.y, (GLint)rect.width(), (GLint)rect.height());
+            float const s = _viewport_scale;
+            glScissor((GLint)(rect.a.x * s), (GLint)(rect.a.y * s), (GLint)(rect.width() * s), (GLint)(rect.height() * s));
         }
     }
     void Renderer_OpenGL::setViewportAndScissorRect()
@@ -747,293 +1284,41 @@ namespace Core::Graphics
         setScissorRect(_state_set.scissor_rect);
         _state_dirty = false;
     }
-
-    void Renderer_OpenGL::setVertexColorBlendState(VertexColorBlendState state)
+    void Renderer_OpenGL::setViewportScale(float scale)
     {
-        if (_state_dirty || _state_set.vertex_color_blend_state != state)
+        if (_viewport_scale != scale)
         {
-            batchFlush();
-            _state_set.vertex_color_blend_state = state;
-            //GLuint subroutines[2] = { (GLuint)(IDX(state) * 2 + IDX(_state_set.texture_alpha_type)), (GLuint)(IDX(_state_set.fog_state) + 8) };
-            //GLuint subroutines[2] = { (GLuint)(IDX(_state_set.fog_state) + 8), (GLuint)(IDX(state) * 2 + IDX(_state_set.texture_alpha_type)) };
-            // GLuint subroutines[2];
-            // subroutines[idx_blend_uniform] = (GLuint)(IDX(state) * 2 + IDX(_state_set.texture_alpha_type));
-            // subroutines[idx_fog_uniform] = (GLuint)(IDX(_state_set.fog_state) + 8);
-
-            // glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 2, subroutines);
+            batchFlush(RendererFrameStatistics::FlushCause::RenderTarget);
+            _viewport_scale = scale;
+            setViewportAndScissorRect();
         }
     }
-    void Renderer_OpenGL::setFogState(FogState state, Color4B const& color, float density_or_znear, float zfar)
-    {
-        if (_state_dirty || _state_set.fog_state != state || _state_set.fog_color != color || _state_set.fog_near_or_density != density_or_znear || _state_set.fog_far != zfar)
-        {
-            batchFlush();
-            _state_set.fog_state = state;
-            _state_set.fog_color = color;
-            _state_set.fog_near_or_density = density_or_znear;
-            _state_set.fog_far = zfar;
-            float const fog_color_and_range[8] = {
-                (float)color.r / 255.0f,
-                (float)color.g / 255.0f,
-                (float)color.b / 255.0f,
-                (float)color.a / 255.0f,
-                density_or_znear, zfar, 0.0f, zfar - density_or_znear,
-            };
-            /* upload */ {
-                glBindBuffer(GL_UNIFORM_BUFFER, _fog_data_buffer);
-                glBufferData(GL_UNIFORM_BUFFER, sizeof(fog_color_and_range), &fog_color_and_range, GL_STATIC_DRAW);
-            }
 
-            //GLuint subroutines[2] = { (GLuint)(IDX(_state_set.vertex_color_blend_state) * 2 + IDX(_state_set.texture_alpha_type)), (GLuint)(IDX(state) + 8) };
-            //GLuint subroutines[2] = { (GLuint)(IDX(state) + 8), (GLuint)(IDX(_state_set.vertex_color_blend_state) * 2 + IDX(_state_set.texture_alpha_type)) };
-
-            // GLuint subroutines[2];
-            // subroutines[idx_blend_uniform] = (GLuint)(IDX(_state_set.vertex_color_blend_state) * 2 + IDX(_state_set.texture_alpha_type));
-            // subroutines[idx_fog_uniform] = (GLuint)(IDX(state) + 8);
-
-            // glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 2, subroutines);
-        }
-    }
-    void Renderer_OpenGL::setDepthState(DepthState state)
-    {
-        if (_state_dirty || _state_set.depth_state != state)
-        {
-            batchFlush();
-            _state_set.depth_state = state;
-            if (state == DepthState::Enable)
-                glEnable(GL_DEPTH_TEST);
-            else
-                glDisable(GL_DEPTH_TEST);
-        }
-    }
-    void Renderer_OpenGL::setBlendState(BlendState state)
+    bool Renderer_OpenGL::createPostEffectShader(StringView path, IPostEffectShader** pp_effect)
     {
-        if (_state_dirty || _state_set.blend_state != state)
+        try
         {
-            batchFlush();
-            _state_set.blend_state = state;
-            switch (state) {
-            default: assert(false); break;
-            case BlendState::Disable:
-                glDisable(GL_BLEND);
-                break;
-            case BlendState::Alpha:
-                glEnable(GL_BLEND);
-                glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-                glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
-                break;
-            case BlendState::One:
-                glEnable(GL_BLEND);
-                glBlendFuncSeparate(GL_ONE, GL_ZERO, GL_ONE, GL_ZERO);
-                glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
-                break;
-            case BlendState::Min:
-                glEnable(GL_BLEND);
-                glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
-                glBlendEquationSeparate(GL_MIN, GL_MIN);
-                break;
-            case BlendState::Max:
-                glEnable(GL_BLEND);
-                glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
-                glBlendEquationSeparate(GL_MAX, GL_MAX);
-                break;
-            case BlendState::Mul:
-                glEnable(GL_BLEND);
-                glBlendFuncSeparate(GL_DST_COLOR, GL_ZERO, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-                glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
-                break;
-            case BlendState::Screen:
-                glEnable(GL_BLEND);
-                glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_COLOR, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-                glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
-                break;
-            case BlendState::Add:
-                glEnable(GL_BLEND);
-                glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-                glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
-                break;
-            case BlendState::Sub:
-                glEnable(GL_BLEND);
-                glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-                glBlendEquationSeparate(GL_FUNC_SUBTRACT, GL_FUNC_ADD);
-                break;
-            case BlendState::RevSub:
-                glEnable(GL_BLEND);
-                glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-                glBlendEquationSeparate(GL_FUNC_REVERSE_SUBTRACT, GL_FUNC_ADD);
-                break;
-            case BlendState::Inv:
-                glEnable(GL_BLEND);
-                glBlendFuncSeparate(GL_ONE_MINUS_DST_COLOR, GL_ONE_MINUS_SRC_COLOR, GL_ZERO, GL_ONE);
-                glBlendEquationSeparate(GL_FUNC_REVERSE_SUBTRACT, GL_FUNC_ADD);
-                break;
-            }
-        }
-    }
-
-    inline bool is_same(Texture2D_OpenGL* a, ITexture2D* b)
-    {
-        if (a && b)
-            return a->GetView() == static_cast<Texture2D_OpenGL*>(b)->GetView();
-        else if (!a && !b)
+            *pp_effect = new PostEffectShader_OpenGL(m_device.get(), path, true);
             return true;
-        else
-            return false;
-    }
-    inline bool is_same(ScopeObject<Texture2D_OpenGL>& a, ITexture2D* b)
-    {
-        return is_same(*a, b);
-    }
-
-    void Renderer_OpenGL::setTexture(ITexture2D* texture)
-    {
-        if (!texture) return;
-        if (_draw_list.command.size > 0 && is_same(_draw_list.command.data[_draw_list.command.size - 1].texture, texture))
-        {
-            // Can merge
-        }
-        else
-        {
-            // New render command
-            if ((_draw_list.command.capacity - _draw_list.command.size) < 1)
-            {
-                batchFlush(); // Free up space
-            }
-            _draw_list.command.size += 1;
-            DrawCommand& cmd_ = _draw_list.command.data[_draw_list.command.size - 1];
-            cmd_.texture = static_cast<Texture2D_OpenGL*>(texture);
-            cmd_.vertex_count = 0;
-            cmd_.index_count = 0;
-        }
-        // Update texture of current state
-        if (!is_same(_state_texture, texture))
-        {
-            _state_texture = static_cast<Texture2D_OpenGL*>(texture);
-        }
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, static_cast<Texture2D_OpenGL*>(texture)->GetResource());
-    }
-
-    bool Renderer_OpenGL::drawTriangle(DrawVertex const& v1, DrawVertex const& v2, DrawVertex const& v3)
-    {
-        if ((_draw_list.vertex.capacity - _draw_list.vertex.size) < 3 || (_draw_list.index.capacity - _draw_list.index.size) < 3)
-        {
-            if (!batchFlush()) return false;
-        }
-        assert(_draw_list.command.size > 0);
-        DrawCommand& cmd_ = _draw_list.command.data[_draw_list.command.size - 1];
-        IRenderer::DrawVertex* vbuf_ = _draw_list.vertex.data + _draw_list.vertex.size;
-        vbuf_[0] = v1;
-        vbuf_[1] = v2;
-        vbuf_[2] = v3;
-        _draw_list.vertex.size += 3;
-        DrawIndex* ibuf_ = _draw_list.index.data + _draw_list.index.size;
-        ibuf_[0] = cmd_.vertex_count;
-        ibuf_[1] = cmd_.vertex_count + 1;
-        ibuf_[2] = cmd_.vertex_count + 2;
-        _draw_list.index.size += 3;
-        cmd_.vertex_count += 3;
-        cmd_.index_count += 3;
-        return true;
-    }
-    bool Renderer_OpenGL::drawTriangle(IRenderer::DrawVertex const* pvert)
-    {
-        return drawTriangle(pvert[0], pvert[1], pvert[2]);
-    }
-    bool Renderer_OpenGL::drawQuad(IRenderer::DrawVertex const& v1, IRenderer::DrawVertex const& v2, IRenderer::DrawVertex const& v3, IRenderer::DrawVertex const& v4)
-    {
-        if ((_draw_list.vertex.capacity - _draw_list.vertex.size) < 4 || (_draw_list.index.capacity - _draw_list.index.size) < 6)
-        {
-            if (!batchFlush()) return false;
-        }
-        assert(_draw_list.command.size > 0);
-        DrawCommand& cmd_ = _draw_list.command.data[_draw_list.command.size - 1];
-        IRenderer::DrawVertex* vbuf_ = _draw_list.vertex.data + _draw_list.vertex.size;
-        vbuf_[0] = v1;
-        vbuf_[1] = v2;
-        vbuf_[2] = v3;
-        vbuf_[3] = v4;
-        _draw_list.vertex.size += 4;
-        DrawIndex* ibuf_ = _draw_list.index.data + _draw_list.index.size;
-        ibuf_[0] = cmd_.vertex_count;
-        ibuf_[1] = cmd_.vertex_count + 1;
-        ibuf_[2] = cmd_.vertex_count + 2;
-        ibuf_[3] = cmd_.vertex_count;
-        ibuf_[4] = cmd_.vertex_count + 2;
-        ibuf_[5] = cmd_.vertex_count + 3;
-        _draw_list.index.size += 6;
-        cmd_.vertex_count += 4;
-        cmd_.index_count += 6;
-        return true;
-    }
-    bool Renderer_OpenGL::drawQuad(IRenderer::DrawVertex const* pvert)
-    {
-        return drawQuad(pvert[0], pvert[1], pvert[2], pvert[3]);
-    }
-    bool Renderer_OpenGL::drawRaw(IRenderer::DrawVertex const* pvert, uint16_t nvert, DrawIndex const* pidx, uint16_t nidx)
-    {
-        if (nvert > _draw_list.vertex.capacity || nidx > _draw_list.index.capacity)
-        {
-            assert(false); return false;
         }
-
-        if ((_draw_list.vertex.capacity - _draw_list.vertex.size) < nvert || (_draw_list.index.capacity - _draw_list.index.size) < nidx)
-        {
-            if (!batchFlush()) return false;
-        }
-
-        assert(_draw_list.command.size > 0);
-        DrawCommand& cmd_ = _draw_list.command.data[_draw_list.command.size - 1];
-
-        IRenderer::DrawVertex* vbuf_ = _draw_list.vertex.data + _draw_list.vertex.size;
-        std::memcpy(vbuf_, pvert, nvert * sizeof(IRenderer::DrawVertex));
-        _draw_list.vertex.size += nvert;
-
-        DrawIndex* ibuf_ = _draw_list.index.data + _draw_list.index.size;
-        for (size_t idx_ = 0; idx_ < nidx; idx_ += 1)
+        catch (...)
         {
-            ibuf_[idx_] = cmd_.vertex_count + pidx[idx_];
+            *pp_effect = nullptr;
+            return false;
         }
-        _draw_list.index.size += nidx;
-
-        cmd_.vertex_count += nvert;
-        cmd_.index_count += nidx;
-
-        return true;
     }
-    bool Renderer_OpenGL::drawRequest(uint16_t nvert, uint16_t nidx, IRenderer::DrawVertex** ppvert, DrawIndex** ppidx, uint16_t* idxoffset)
-    {
-        if (nvert > _draw_list.vertex.capacity || nidx > _draw_list.index.capacity)
-        {
-            assert(false); return false;
-        }
-
-        if ((_draw_list.vertex.capacity - _draw_list.vertex.size) < nvert || (_draw_list.index.capacity - _draw_list.index.size) < nidx)
-        {
-            if (!batchFlush()) return false;
-        }
-
-        // assert(_draw_list.command.size > 0);
-        DrawCommand& cmd_ = _draw_list.command.data[_draw_list.command.size - 1];
-
-        *ppvert = _draw_list.vertex.data + _draw_list.vertex.size;
-        _draw_list.vertex.size += nvert;
-
-        *ppidx = _draw_list.index.data + _draw_list.index.size;
-        _draw_list.index.size += nidx;
-
-        *idxoffset = cmd_.vertex_count; // Output vertex offset
-        cmd_.vertex_count += nvert;
-        cmd_.index_count += nidx;
-
-        return true;
-    }
-
-    bool Renderer_OpenGL::createPostEffectShader(StringView path, IPostEffectShader** pp_effect)
+    bool Renderer_OpenGL::createPostEffectChain(StringView const* paths, size_t count, IPostEffectShader** pp_effect)
     {
+        assert(paths && count > 0);
         try
         {
-            *pp_effect = new PostEffectShader_OpenGL(m_device.get(), path, true);
+            std::vector<std::string> chain;
+            chain.reserve(count);
+            for (size_t i = 0; i < count; i += 1)
+            {
+                chain.emplace_back(paths[i]);
+            }
+            *pp_effect = new PostEffectShader_OpenGL(m_device.get(), std::move(chain));
             return true;
         }
         catch (...)
@@ -1067,7 +1352,8 @@ namespace Core::Graphics
                 return false;
             }
 
-            glBindTexture(GL_TEXTURE_2D, rt);
+            bindTexture(0, (GLuint)rt);
+            selectTextureUnit(0); // bindTexture skips glActiveTexture when rt is bound to unit 0 already
 
             glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &w);
             glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &h);
@@ -1082,7 +1368,7 @@ namespace Core::Graphics
         glViewport(0, 0, w, h);
         glScissor(0, 0, w, h);
 
-        glUseProgram(static_cast<PostEffectShader_OpenGL*>(p_effect)->GetShader());
+        useProgram(static_cast<PostEffectShader_OpenGL*>(p_effect)->GetShader());
 
         /* upload vertex data */ {
             DrawVertex const vertex_data[4] = {
@@ -1095,7 +1381,7 @@ namespace Core::Graphics
             glBufferData(GL_ARRAY_BUFFER, sizeof(vertex_data), &vertex_data, GL_STATIC_DRAW);
         }
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _fx_ibuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _quad_ibuffer);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DrawVertex), (const GLvoid *)0);
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(DrawVertex), (const GLvoid *)offsetof(DrawVertex, u));
@@ -1105,37 +1391,31 @@ namespace Core::Graphics
 
         /* upload vp matrix */ {
             glm::mat4 mat4 = glm::orthoLH_ZO(0.0f, (float)w, 0.0f, (float)h, 0.0f, 1.0f);
-            glBindBuffer(GL_UNIFORM_BUFFER, _vp_matrix_buffer);
-            glBufferData(GL_UNIFORM_BUFFER, sizeof(mat4), &mat4, GL_STATIC_DRAW);
+            _uniform_ring.write(0, &mat4, sizeof(mat4));
         }
 
-        glBindBufferBase(GL_UNIFORM_BUFFER, 0, _vp_matrix_buffer);
-
-        /* upload built-in value */ if (cv_n > 0) {
-            glBindBuffer(GL_UNIFORM_BUFFER, _user_float_buffer);
-            glBufferData(GL_UNIFORM_BUFFER, std::min<GLuint>((GLuint)cv_n, 8) * sizeof(Vector4F), cv, GL_STATIC_DRAW);
+        GLuint binding = 0;
+        /* upload built-in value */ if (static_cast<PostEffectShader_OpenGL*>(p_effect)->findBinding("user_data", binding)) {
+            Vector4F user_data[8]{};
+            std::copy_n(cv, std::min<size_t>(cv_n, 8), user_data);
+            _uniform_ring.write(binding, user_data, sizeof(user_data));
         }
-        /* upload built-in value */ {
+        /* upload built-in value */ if (static_cast<PostEffectShader_OpenGL*>(p_effect)->findBinding("engine_data", binding)) {
             float ps_cbdata[8] = {
                 (float)w, (float)h, 0.0f, 0.0f,
-                _state_set.viewport.a.x, _state_set.viewport.a.y, _state_set.viewport.b.x, _state_set.viewport.b.y,
+                // the post effect covers the render target pixels, so the viewport is scaled like glViewport
+                _state_set.viewport.a.x * _viewport_scale, _state_set.viewport.a.y * _viewport_scale, _state_set.viewport.b.x * _viewport_scale, _state_set.viewport.b.y * _viewport_scale,
             };
-            glBindBuffer(GL_UNIFORM_BUFFER, _fog_data_buffer);
-            glBufferData(GL_UNIFORM_BUFFER, sizeof(ps_cbdata), &ps_cbdata, GL_STATIC_DRAW);
+            _uniform_ring.write(binding, ps_cbdata, sizeof(ps_cbdata));
         }
-        // GLuint frag_bufs[2] = { _fog_data_buffer, _user_float_buffer };
-        // glBindBuffersBase(GL_UNIFORM_BUFFER, 1, 2, frag_bufs);
-        static_cast<PostEffectShader_OpenGL*>(p_effect)->bind(_fog_data_buffer, _user_float_buffer);
 
         for (int stage = 0; stage < std::min<int>((int)tv_sv_n, 4); stage++)
         {
-            glActiveTexture(GL_TEXTURE1 + stage);
-            glBindTexture(GL_TEXTURE_2D, static_cast<Texture2D_OpenGL*>(p_tex_arr[stage])->GetResource());
-            setSamplerState(sv[stage], stage);
+            bindTexture(1 + stage, static_cast<Texture2D_OpenGL*>(p_tex_arr[stage])->GetResource());
+            setSamplerState(sv[stage], 1 + stage);
         }
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, static_cast<Texture2D_OpenGL*>(p_tex)->GetResource());
-        setSamplerState(rtsv, 4);
+        bindTexture(0, static_cast<Texture2D_OpenGL*>(p_tex)->GetResource());
+        setSamplerState(rtsv, 0);
 
         glDisable(GL_DEPTH_TEST);
         switch (blend) {
@@ -1197,7 +1477,16 @@ namespace Core::Graphics
 
         // DRAW
 
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, NULL);
+        {
+            TracyGpuZone("PostEffect");
+            m_gpu_timer.beginZone("PostEffect");
+            glDrawElements(GL_TRIANGLES, 6, draw_index_type, NULL);
+            m_gpu_timer.endZone();
+        }
+        RENDERER_STATISTICS_ADD(post_effect, 1);
+        RENDERER_STATISTICS_ADD(draw, 1);
+        RENDERER_STATISTICS_ADD(vertex, 4);
+        RENDERER_STATISTICS_ADD(index, 6);
 
         return beginBatch();
     }
@@ -1219,7 +1508,8 @@ namespace Core::Graphics
                 return false;
             }
 
-            glBindTexture(GL_TEXTURE_2D, rt);
+            bindTexture(0, (GLuint)rt);
+            selectTextureUnit(0); // bindTexture skips glActiveTexture when rt is bound to unit 0 already
 
             glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &w);
             glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &h);
@@ -1234,7 +1524,7 @@ namespace Core::Graphics
         glViewport(0, 0, w, h);
         glScissor(0, 0, w, h);
 
-        glUseProgram(static_cast<PostEffectShader_OpenGL*>(p_effect)->GetShader());
+        useProgram(static_cast<PostEffectShader_OpenGL*>(p_effect)->GetShader());
 
         /* upload vertex data */ {
             DrawVertex const vertex_data[4] = {
@@ -1247,7 +1537,7 @@ namespace Core::Graphics
             glBufferData(GL_ARRAY_BUFFER, sizeof(vertex_data), &vertex_data, GL_STATIC_DRAW);
         }
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _fx_ibuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _quad_ibuffer);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DrawVertex), (const GLvoid *)0);
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(DrawVertex), (const GLvoid *)offsetof(DrawVertex, u));
@@ -1263,21 +1553,16 @@ namespace Core::Graphics
         
         /* upload vp matrix */ {
             glm::mat4 mat4 = glm::orthoLH_ZO(0.0f, (float)w, 0.0f, (float)h, 0.0f, 1.0f);
-            glBindBuffer(GL_UNIFORM_BUFFER, _vp_matrix_buffer);
-            glBufferData(GL_UNIFORM_BUFFER, sizeof(mat4), &mat4, GL_STATIC_DRAW);
+            _uniform_ring.write(0, &mat4, sizeof(mat4));
         }
 
-        glBindBufferBase(GL_UNIFORM_BUFFER, 0, _vp_matrix_buffer);
-
         /* upload built-in value */ {
             float ps_cbdata[8] = {
                 (float)w, (float)h, 0.0f, 0.0f,
-                _state_set.viewport.a.x, _state_set.viewport.a.y, _state_set.viewport.b.x, _state_set.viewport.b.y,
+                _state_set.viewport.a.x * _viewport_scale, _state_set.viewport.a.y * _viewport_scale, _state_set.viewport.b.x * _viewport_scale, _state_set.viewport.b.y * _viewport_scale,
             };
-            glBindBuffer(GL_UNIFORM_BUFFER, _fog_data_buffer);
-            glBufferData(GL_UNIFORM_BUFFER, sizeof(ps_cbdata), &ps_cbdata, GL_STATIC_DRAW);
+            _uniform_ring.write(3, ps_cbdata, sizeof(ps_cbdata));
         }
-        glBindBufferBase(GL_UNIFORM_BUFFER, 3, _fog_data_buffer);
 
         glDisable(GL_DEPTH_TEST);
         switch (blend) {
@@ -1339,7 +1624,16 @@ namespace Core::Graphics
 
         // DRAW
 
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, NULL);
+        {
+            TracyGpuZone("PostEffect");
+            m_gpu_timer.beginZone("PostEffect");
+            glDrawElements(GL_TRIANGLES, 6, draw_index_type, NULL);
+            m_gpu_timer.endZone();
+        }
+        RENDERER_STATISTICS_ADD(post_effect, 1);
+        RENDERER_STATISTICS_ADD(draw, 1);
+        RENDERER_STATISTICS_ADD(vertex, 4);
+        RENDERER_STATISTICS_ADD(index, 6);
 
         return beginBatch();
     }
@@ -1386,7 +1680,8 @@ namespace Core::Graphics
             return false;
         }
 
-        static_cast<Model_OpenGL*>(p_model)->draw(_state_set.fog_state);
+        applyDrawState(_batch.getDrawState()); // models read the fog data uploaded here
+        static_cast<Model_OpenGL*>(p_model)->draw(_batch.getDrawState().fog_state);
 
         if (!beginBatch())
         {
@@ -1396,14 +1691,100 @@ namespace Core::Graphics
         return true;
     }
 
+    bool Renderer_OpenGL::createMeshBuffer(IMeshBuffer** pp_mesh)
+    {
+        try
+        {
+            *pp_mesh = new MeshBuffer_OpenGL(m_device.get());
+            return true;
+        }
+        catch (const std::exception&)
+        {
+            *pp_mesh = nullptr;
+            spdlog::error("[core] LuaSTG::Core::Renderer::createMeshBuffer failed");
+            return false;
+        }
+    }
+    bool Renderer_OpenGL::drawMeshBuffer(IMeshBuffer* p_mesh)
+    {
+        ZoneScoped;
+        if (!p_mesh)
+        {
+            assert(false);
+            return false;
+        }
+        auto* mesh_ = static_cast<MeshBuffer_OpenGL*>(p_mesh);
+        if (mesh_->getVertexCount() == 0 || mesh_->getIndexCount() == 0)
+        {
+            return true;
+        }
+
+        // Keep the order of the batched draws before it
+        if (!batchFlush())
+        {
+            return false;
+        }
+
+        TracyGpuZone("DrawMeshBuffer");
+        ITexture2D* texture_ = _batch.getTexture();
+        DrawState const& state_ = _batch.getDrawState();
+        bindTextureAlphaType(texture_);
+        bindTextureSamplerState(texture_);
+        applyDrawState(state_);
+        useProgram(_programs_mesh[IDX(state_.vertex_color_blend_state)][IDX(state_.fog_state)][IDX(_state_set.texture_alpha_type)]);
+        glm::mat4 const world_ = mesh_->getWorldMatrix();
+        _uniform_ring.write(1, &world_, sizeof(world_)); // beginBatch binds the identity buffer again
+        bindVertexArray(mesh_->getVertexArray());
+        mesh_->upload();
+        glDrawElements(GL_TRIANGLES, (GLsizei)mesh_->getIndexCount(), draw_index_type, (void*)0);
+        RENDERER_STATISTICS_ADD(draw, 1);
+        RENDERER_STATISTICS_ADD(vertex, mesh_->getVertexCount());
+        RENDERER_STATISTICS_ADD(index, mesh_->getIndexCount());
+        bindVertexArray(_vao); // uploads bind the index buffer into whatever VAO is current
+
+        return true;
+    }
+
     Graphics::SamplerState Renderer_OpenGL::getKnownSamplerState(SamplerState state)
     {
         return _sampler_state[IDX(state)];
     }
 
+    void Renderer_OpenGL::endGpuFrame()
+    {
+        batchFlush(); // the closing timestamp must come after the frame's draws
+        m_gpu_timer.endFrame();
+        _frame_statistics_index = (_frame_statistics_index + 1) % std::size(_frame_statistics);
+        _frame_statistics[_frame_statistics_index] = {};
+    }
+    RendererFrameStatistics Renderer_OpenGL::getFrameStatistics()
+    {
+        size_t const n = std::size(_frame_statistics);
+        return _frame_statistics[(_frame_statistics_index + n - 1) % n];
+    }
+    void Renderer_OpenGL::beginGpuZone(StringView name)
+    {
+        batchFlush();
+        m_gpu_timer.beginZone(name);
+    }
+    void Renderer_OpenGL::endGpuZone()
+    {
+        batchFlush();
+        m_gpu_timer.endZone();
+    }
+
     Renderer_OpenGL::Renderer_OpenGL(Device_OpenGL* p_device)
         : m_device(p_device)
     {
+        InitializeConfigure config;
+        config.loadFromFile("config.json");
+        size_t const vertex_capacity = std::clamp<size_t>((size_t)std::max(config.renderer_batch_vertex_capacity, 0), 1024, DrawList::max_vertex_capacity);
+        size_t const index_capacity = std::clamp<size_t>((size_t)std::max(config.renderer_batch_index_capacity, 0), 1536, DrawList::max_index_capacity);
+        size_t const command_capacity = std::max<size_t>((size_t)std::max(config.renderer_batch_command_capacity, 0), 64);
+        _batch.allocate(vertex_capacity, index_capacity, command_capacity);
+        spdlog::info("[core] Renderer batch capacity: {} vertices, {} indices ({}-bit), {} commands",
+            vertex_capacity, index_capacity, sizeof(DrawIndex) * 8, command_capacity);
+
         if (!createResources())
             throw std::runtime_error("Renderer_OpenGL::Renderer_OpenGL");
         m_device->addEventListener(this);
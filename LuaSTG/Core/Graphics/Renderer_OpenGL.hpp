@@ -2,9 +2,13 @@
 #include "Core/Graphics/Device.hpp"
 #include "Core/Object.hpp"
 #include "Core/Graphics/Renderer.hpp"
+#include "Core/Graphics/DrawBatch.hpp"
 #include "Core/Graphics/Device_OpenGL.hpp"
 #include "Core/Graphics/Model_OpenGL.hpp"
+#include "Core/Graphics/GpuTimer_OpenGL.hpp"
 #include "glad/gl.h"
+#include <utility>
+#include <vector>
 
 #define IDX(x) (size_t)static_cast<uint8_t>(x)
 
@@ -14,15 +18,8 @@ namespace Core::Graphics
 	{
 		BoxF viewport = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
 		RectF scissor_rect = { 0.0f, 0.0f, 1.0f, 1.0f };
-		float fog_near_or_density = 0.0f;
-		float fog_far = 0.0f;
-		Color4B fog_color;
-		IRenderer::VertexColorBlendState vertex_color_blend_state = IRenderer::VertexColorBlendState::Mul;
 		IRenderer::SamplerState sampler_state = IRenderer::SamplerState::LinearClamp;
-		IRenderer::FogState fog_state = IRenderer::FogState::Disable;
 		IRenderer::TextureAlphaType texture_alpha_type = IRenderer::TextureAlphaType::Normal;
-		IRenderer::DepthState depth_state = IRenderer::DepthState::Disable;
-		IRenderer::BlendState blend_state = IRenderer::BlendState::Alpha;
 	};
 
 	struct CameraStateSet
@@ -58,39 +55,67 @@ namespace Core::Graphics
 	{
 		GLuint vertex_buffer = 0;
 		GLuint index_buffer = 0;
+		GLuint instance_buffer = 0;
+		GLuint slot_buffer = 0; // per-vertex texture slot, same offsets as vertex_buffer
 
 		GLint vertex_offset = 0;
 		GLuint index_offset = 0;
+		GLuint instance_offset = 0;
 	};
 
-	struct DrawCommand
+	// Camera, fog and post effect constants are sub-allocated from one buffer instead of
+	// reallocating a buffer per update; ranges are never reused until the storage is orphaned.
+	// Orphaning replaces the storage behind every range bound from the buffer, so the last
+	// data of each binding point is kept and written again into the new storage
+	struct UniformRingBuffer
 	{
-		ScopeObject<Texture2D_OpenGL> texture;
-		uint16_t vertex_count = 0;
-		uint16_t vertex_offset = 0;
-		uint16_t index_count = 0;
+		GLuint buffer = 0;
+		GLintptr offset = 0;
+		GLsizeiptr capacity = 0;
+		GLint alignment = 256; // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+		std::vector<std::vector<uint8_t>> live; // per binding point, empty when not bound from this buffer
+
+		bool create(GLsizeiptr size);
+		void destroy();
+		void upload(GLuint binding, void const* data, GLsizeiptr size);
+		void orphan(GLuint binding);
+		// Copies the data to a fresh range and binds that range to the uniform binding point
+		void write(GLuint binding, void const* data, GLsizeiptr size);
 	};
 
-	struct DrawList
+	// Bindings the renderer made itself, anything outside the batch (post effects, models, imgui)
+	// may change them behind its back, so the shadow is reset whenever a batch begins
+	struct GLStateShadow
 	{
-		struct VertexBuffer
-		{
-			const size_t capacity = 32768;
-			size_t size = 0;
-			IRenderer::DrawVertex data[32768] = {};
-		} vertex;
-		struct IndexBuffer
+		static constexpr GLuint texture_unit_count = 8;
+		static constexpr GLuint unknown = ~GLuint(0);
+
+		GLuint texture[texture_unit_count];
+		GLuint sampler[texture_unit_count];
+		GLuint active_texture_unit;
+		GLuint program;
+		GLuint vertex_array;
+
+		GLStateShadow() { invalidate(); }
+		void invalidate()
 		{
-			const size_t capacity = 32768;
-			size_t size = 0;
-			IRenderer::DrawIndex data[32768] = {};
-		} index;
-		struct DrawCommandBuffer
+			invalidateTextures();
+			for (GLuint i = 0; i < texture_unit_count; i += 1)
+			{
+				sampler[i] = unknown;
+			}
+			active_texture_unit = unknown;
+			program = unknown;
+			vertex_array = unknown;
+		}
+		// A released texture may be deleted and its name handed to a new one
+		void invalidateTextures()
 		{
-			const size_t capacity = 2048;
-			size_t size = 0;
-			DrawCommand data[2048] = {};
-		} command;
+			for (GLuint i = 0; i < texture_unit_count; i += 1)
+			{
+				texture[i] = unknown;
+			}
+		}
 	};
 
 	class PostEffectShader_OpenGL
@@ -108,7 +133,6 @@ namespace Core::Graphics
 			GLuint index{};
 			GLuint binding{};
 			std::vector<uint8_t> buffer;
-			GLuint opengl_buffer = 0;
 			std::unordered_map<std::string, LocalVariable> variable;
 		};
 		struct LocalTexture2D
@@ -122,6 +146,7 @@ namespace Core::Graphics
 		std::unordered_map<std::string, LocalConstantBuffer> m_buffer_map;
 		std::unordered_map<std::string, LocalTexture2D> m_texture2d_map;
 		std::string source;
+		std::vector<std::string> m_chain; // stage paths of a fused post effect chain
 		bool is_path{ false };
 
 		bool createResources();
@@ -131,7 +156,7 @@ namespace Core::Graphics
 
 	public:
 		GLuint GetShader() const noexcept { return opengl_prgm; }
-		void bind(GLuint engine_data, GLuint user_data);
+		bool findBinding(std::string const& name, GLuint& binding);
 
 	public:
 		bool setFloat(StringView name, float value);
@@ -143,39 +168,92 @@ namespace Core::Graphics
 
 	public:
 		PostEffectShader_OpenGL(Device_OpenGL* p_device, StringView path, bool is_path_);
+		PostEffectShader_OpenGL(Device_OpenGL* p_device, std::vector<std::string> chain);
 		~PostEffectShader_OpenGL();
 	};
 
+	class MeshBuffer_OpenGL
+		: public Object<IMeshBuffer>
+		, IDeviceEventListener
+	{
+	private:
+		ScopeObject<Device_OpenGL> m_device;
+		GLuint m_vao = 0;
+		GLuint m_vertex_buffer = 0;
+		GLuint m_index_buffer = 0;
+		size_t m_vertex_capacity = 0; // in vertices, allocated GPU storage
+		size_t m_index_capacity = 0;
+		bool m_dirty = false;
+		// A copy is kept to fill the buffers again after the device is recreated
+		std::vector<IRenderer::DrawVertex> m_vertex;
+		std::vector<IRenderer::DrawIndex> m_index;
+		glm::mat4 t_scale_ = glm::identity<glm::mat4>();
+		glm::mat4 t_trans_ = glm::identity<glm::mat4>();
+		glm::mat4 t_mbrot_ = glm::identity<glm::mat4>();
+
+		bool createResources();
+		void onDeviceCreate();
+		void onDeviceDestroy();
+
+	public:
+		GLuint getVertexArray() const noexcept { return m_vao; }
+		glm::mat4 getWorldMatrix() const noexcept { return t_trans_ * t_mbrot_ * t_scale_; }
+		// With the vertex array bound, uploads the data if it changed since the last draw
+		void upload();
+
+	public:
+		bool setData(IRenderer::DrawVertex const* pvert, uint32_t nvert, IRenderer::DrawIndex const* pidx, uint32_t nidx);
+		uint32_t getVertexCount() { return (uint32_t)m_vertex.size(); }
+		uint32_t getIndexCount() { return (uint32_t)m_index.size(); }
+
+		void setScaling(Vector3F const& scale);
+		void setPosition(Vector3F const& pos);
+		void setRotationRollPitchYaw(float roll, float pitch, float yaw);
+
+	public:
+		MeshBuffer_OpenGL(Device_OpenGL* p_device);
+		~MeshBuffer_OpenGL();
+	};
+
 	class Renderer_OpenGL
 		: public Object<IRenderer>
 		, IDeviceEventListener
+		, IDrawBatchListener
 	{
 	private:
 		ScopeObject<Device_OpenGL> m_device;
 		ScopeObject<ModelSharedComponent_OpenGL> m_model_shared;
+		GpuTimer_OpenGL m_gpu_timer;
 
 		GLuint _fx_vbuffer = 0;
-		GLuint _fx_ibuffer = 0;
+		GLuint _quad_ibuffer = 0; // 0-1-2/0-2-3 for every quad the vertex buffer can hold, also used by post effects
 		GLuint _vao = 0;
+		GLuint _instance_vao = 0; // per-instance attributes, no per-vertex data
 		VertexIndexBuffer _vi_buffer[1];
 		size_t _vi_buffer_index = 0;
 		const size_t _vi_buffer_count = 1;
-		DrawList _draw_list;
+		DrawBatch _batch{ this };
+		DrawList& _draw_list = _batch.getDrawList(); // submitted by batchFlush
 
 		void setVertexIndexBuffer(size_t index = 0xFFFFFFFFu);
 		bool uploadVertexIndexBuffer(bool discard);
 		void clearDrawList();
+		bool createBatchBuffers();
+		void destroyBatchBuffers();
+		bool onDrawBatchFull();
+		bool onDrawBatchResize();
 
-		GLuint _vp_matrix_buffer = 0;
+		UniformRingBuffer _uniform_ring; // binding 0: view projection matrix, 2: camera position, 3: fog data, post effect constants
 		GLuint _world_matrix_buffer = 0;
-		GLuint _camera_pos_buffer = 0; // Changed with postEffect
-		GLuint _fog_data_buffer = 0; // Also used to store texture size and range of postEffect
-		GLuint _user_float_buffer = 0; // Used with postEffect
+		float _camera_pos_data[8]{}; // written again when a batch begins, post effect blocks may use binding 2 too
 
 		// Microsoft::WRL::ComPtr<ID3D11InputLayout> _input_layout;
 		// GLuint _vertex_shader[IDX(FogState::MAX_COUNT)]; // FogState
 		// GLuint _pixel_shader[IDX(VertexColorBlendState::MAX_COUNT)][IDX(FogState::MAX_COUNT)][IDX(TextureAlphaType::MAX_COUNT)]; // VertexColorBlendState, FogState, TextureAlphaType
 		GLuint _programs[IDX(VertexColorBlendState::MAX_COUNT)][IDX(FogState::MAX_COUNT)][IDX(TextureAlphaType::MAX_COUNT)]; // VertexColorBlendState, FogState, TextureAlphaType
+		GLuint _programs_instance[IDX(VertexColorBlendState::MAX_COUNT)][IDX(FogState::MAX_COUNT)][IDX(TextureAlphaType::MAX_COUNT)]; // Same as above, for DrawCommand::Type::Instance
+		GLuint _programs_multi[IDX(VertexColorBlendState::MAX_COUNT)][IDX(FogState::MAX_COUNT)][IDX(TextureAlphaType::MAX_COUNT)]; // Same as above, for commands with more than one texture
+		GLuint _programs_mesh[IDX(VertexColorBlendState::MAX_COUNT)][IDX(FogState::MAX_COUNT)][IDX(TextureAlphaType::MAX_COUNT)]; // Same as above, with the world matrix of a mesh buffer
 		// GLuint _program;
 		// GLint idx_blend_uniform;
 		// GLint idx_fog_uniform;
@@ -184,20 +262,32 @@ namespace Core::Graphics
 		// Microsoft::WRL::ComPtr<ID3D11DepthStencilState> _depth_state[IDX(DepthState::MAX_COUNT)];
 		// Microsoft::WRL::ComPtr<ID3D11BlendState> _blend_state[IDX(BlendState::MAX_COUNT)];
 		
-		ScopeObject<Texture2D_OpenGL> _state_texture;
 		CameraStateSet _camera_state_set;
 		RendererStateSet _state_set;
+		float _viewport_scale = 1.0f; // _state_set keeps the unscaled viewport and scissor rect
+		DrawState _gl_state; // what is currently applied to GL
+		bool _gl_state_valid = false;
+		GLStateShadow _gl_shadow;
+		std::vector<std::pair<Graphics::SamplerState, GLuint>> _sampler_objects; // created on first use, a handful per game
 		bool _state_dirty = false;
 		bool _batch_scope = false;
+		RendererFrameStatistics _frame_statistics[2]{};
+		size_t _frame_statistics_index = 0;
 
 		bool createBuffers();
 		bool createStates();
 		bool createShaders();
 		void initState();
 		bool uploadVertexIndexBufferFromDrawList();
-		void bindTextureSamplerState(ITexture2D* texture);
+		GLuint getSamplerObject(Graphics::SamplerState const& state);
+		void bindSampler(GLuint unit, GLuint sampler);
+		void unbindSamplers();
+		void useProgram(GLuint program);
+		void bindVertexArray(GLuint vertex_array);
+		void bindTextureSamplerState(ITexture2D* texture, GLuint unit = 0);
 		void bindTextureAlphaType(ITexture2D* texture);
-		bool batchFlush(bool discard = false);
+		void applyDrawState(DrawState const& state);
+		bool batchFlush(RendererFrameStatistics::FlushCause cause = RendererFrameStatistics::FlushCause::Explicit, bool discard = false);
 
 		bool createResources();
 		void onDeviceCreate();
@@ -206,6 +296,9 @@ namespace Core::Graphics
 	public:
 		void setSamplerState(IRenderer::SamplerState state, GLuint index);
 		void setSamplerState(Graphics::SamplerState state, GLuint index);
+		void selectTextureUnit(GLuint unit);
+		void bindTexture(GLuint unit, GLuint texture);
+		void uploadUniformData(GLuint binding, void const* data, size_t size) { _uniform_ring.write(binding, data, (GLsizeiptr)size); }
 
 	public:
 		bool beginBatch();
@@ -224,21 +317,29 @@ namespace Core::Graphics
 		void setViewport(BoxF const& box);
 		void setScissorRect(RectF const& rect);
 		void setViewportAndScissorRect();
-
-		void setVertexColorBlendState(VertexColorBlendState state);
-		void setFogState(FogState state, Color4B const& color, float density_or_znear, float zfar);
-		void setDepthState(DepthState state);
-		void setBlendState(BlendState state);
-		void setTexture(ITexture2D* texture);
-
-		bool drawTriangle(DrawVertex const& v1, DrawVertex const& v2, DrawVertex const& v3);
-		bool drawTriangle(DrawVertex const* pvert);
-		bool drawQuad(DrawVertex const& v1, DrawVertex const& v2, DrawVertex const& v3, DrawVertex const& v4);
-		bool drawQuad(DrawVertex const* pvert);
-		bool drawRaw(DrawVertex const* pvert, uint16_t nvert, DrawIndex const* pidx, uint16_t nidx);
-		bool drawRequest(uint16_t nvert, uint16_t nidx, DrawVertex** ppvert, DrawIndex** ppidx, uint16_t* idxoffset);
+		void setViewportScale(float scale);
+		float getViewportScale() { return _viewport_scale; }
+
+		void setVertexColorBlendState(VertexColorBlendState state) { _batch.setVertexColorBlendState(state); }
+		void setFogState(FogState state, Color4B const& color, float density_or_znear, float zfar) { _batch.setFogState(state, color, density_or_znear, zfar); }
+		void setDepthState(DepthState state) { _batch.setDepthState(state); }
+		void setBlendState(BlendState state) { _batch.setBlendState(state); }
+		void setTexture(ITexture2D* texture) { _batch.setTexture(texture); }
+		void setTextureBatching(bool enable) { _batch.setTextureBatching(enable); }
+		bool getTextureBatching() { return _batch.getTextureBatching(); }
+
+		bool drawTriangle(DrawVertex const& v1, DrawVertex const& v2, DrawVertex const& v3) { return _batch.drawTriangle(v1, v2, v3); }
+		bool drawTriangle(DrawVertex const* pvert) { return _batch.drawTriangle(pvert[0], pvert[1], pvert[2]); }
+		bool drawQuad(DrawVertex const& v1, DrawVertex const& v2, DrawVertex const& v3, DrawVertex const& v4) { return _batch.drawQuad(v1, v2, v3, v4); }
+		bool drawQuad(DrawVertex const* pvert) { return _batch.drawQuad(pvert[0], pvert[1], pvert[2], pvert[3]); }
+		bool drawRaw(DrawVertex const* pvert, uint32_t nvert, DrawIndex const* pidx, uint32_t nidx) { return _batch.drawRaw(pvert, nvert, pidx, nidx); }
+		bool drawRequest(uint32_t nvert, uint32_t nidx, DrawVertex** ppvert, DrawIndex** ppidx, DrawIndex* idxoffset) { return _batch.drawRequest(nvert, nidx, ppvert, ppidx, idxoffset); }
+		bool drawInstance(DrawInstance const& inst) { return _batch.drawInstances(&inst, 1); }
+		bool drawInstances(DrawInstance const* pinst, uint16_t ninst) { return _batch.drawInstances(pinst, ninst); }
+		bool canBatchInstance() { return _batch.canBatchInstance(); }
 
 		bool createPostEffectShader(StringView path, IPostEffectShader** pp_effect);
+		bool createPostEffectChain(StringView const* paths, size_t count, IPostEffectShader** pp_effect);
 		bool drawPostEffect(
 			IPostEffectShader* p_effect,
 			BlendState blend,
@@ -250,8 +351,19 @@ namespace Core::Graphics
 		bool createModel(StringView path, IModel** pp_model);
 		bool drawModel(IModel* p_model);
 
+		bool createMeshBuffer(IMeshBuffer** pp_mesh);
+		bool drawMeshBuffer(IMeshBuffer* p_mesh);
+
 		Graphics::SamplerState getKnownSamplerState(SamplerState state);
 
+		void beginGpuFrame() { m_gpu_timer.beginFrame(); }
+		void endGpuFrame();
+		void beginGpuZone(StringView name);
+		void endGpuZone();
+		double getGpuFrameTime() { return m_gpu_timer.getFrameTime(); }
+		std::vector<GpuTimingZone> const& getGpuZones() { return m_gpu_timer.getZones(); }
+		RendererFrameStatistics getFrameStatistics();
+
 	public:
 		Renderer_OpenGL(Device_OpenGL* p_device);
 		~Renderer_OpenGL();
@@ -18,6 +18,7 @@ const constexpr GLchar default_fragment[]{R"(
 #define {}
 #define {}
 #define {}
+#define {}
 
 uniform camera_data
 {{
@@ -29,6 +30,15 @@ uniform fog_data
     vec4 fog_range;
 }};
 uniform sampler2D sampler0;
+#if defined(MULTI_TEXTURE)
+uniform sampler2D sampler1;
+uniform sampler2D sampler2;
+uniform sampler2D sampler3;
+uniform sampler2D sampler4;
+uniform sampler2D sampler5;
+uniform sampler2D sampler6;
+uniform sampler2D sampler7;
+#endif
 
 const float channel_minimum = 1.0 / 255.0;
 
@@ -41,19 +51,44 @@ layout(location = 3) in vec4 col;
 layout(location = 4) in vec2 hue;
 #endif
 
+#if defined(MULTI_TEXTURE)
+layout(location = 5) flat in uint slot;
+#endif
+
 layout(location = 0) out vec4 col_out;
 
+vec4 sample_texture()
+{{
+#if defined(MULTI_TEXTURE)
+    // derivatives must be taken outside of non-uniform control flow
+    vec2 ddx = dFdx(uv);
+    vec2 ddy = dFdy(uv);
+    switch (slot)
+    {{
+    case 1u: return textureGrad(sampler1, uv, ddx, ddy);
+    case 2u: return textureGrad(sampler2, uv, ddx, ddy);
+    case 3u: return textureGrad(sampler3, uv, ddx, ddy);
+    case 4u: return textureGrad(sampler4, uv, ddx, ddy);
+    case 5u: return textureGrad(sampler5, uv, ddx, ddy);
+    case 6u: return textureGrad(sampler6, uv, ddx, ddy);
+    case 7u: return textureGrad(sampler7, uv, ddx, ddy);
+    default: return textureGrad(sampler0, uv, ddx, ddy);
+    }}
+#else
+    return texture(sampler0, uv);
+#endif
+}}
 
 vec4 vb_zero()
 {{
-    vec4 color = texture(sampler0, uv);
+    vec4 color = sample_texture();
     color.rgb *= color.a;
     return color;
 }}
 
 vec4 vb_zero_pmul()
 {{
-    return texture(sampler0, uv); // pass through
+    return sample_texture(); // pass through
 }}
 
 vec4 vb_one()
@@ -81,13 +116,13 @@ vec4 add_common(vec4 color)
 
 vec4 vb_add()
 {{
-    vec4 color = texture(sampler0, uv);
+    vec4 color = sample_texture();
     return add_common(color);
 }}
 
 vec4 vb_add_pmul()
 {{
-    vec4 color = texture(sampler0, uv);
+    vec4 color = sample_texture();
 
     // cancel out alpha multiplication
     if (color.a < channel_minimum)
@@ -101,14 +136,14 @@ vec4 vb_add_pmul()
 
 vec4 vb_mul()
 {{
-    vec4 color = texture(sampler0, uv) * col;
+    vec4 color = sample_texture() * col;
     color.rgb *= color.a;
     return color;
 }}
 
 vec4 vb_mul_pmul()
 {{
-    vec4 color = texture(sampler0, uv) * col;
+    vec4 color = sample_texture() * col;
     color.rgb *= col.a; // need to multiply with texture alpha
     return color;
 }}
@@ -116,7 +151,7 @@ vec4 vb_mul_pmul()
 #if defined(VERTEX_HUE)
 vec4 vb_hue()
 {{
-    vec4 color = texture(sampler0, uv);
+    vec4 color = sample_texture();
     vec3 RCPSQRT3 = vec3(inversesqrt(3.0));
     color.rgb = color.rgb * hue.y + cross(RCPSQRT3,color.rgb) * hue.x + RCPSQRT3 * dot(RCPSQRT3,color.rgb) * (1.0 - hue.y); //hue
     float avg = (color.r + color.g + color.b) / 3.0;
@@ -130,7 +165,7 @@ vec4 vb_hue()
 
 vec4 vb_hue_pmul()
 {{
-    vec4 color = texture(sampler0, uv);
+    vec4 color = sample_texture();
     vec3 RCPSQRT3 = vec3(inversesqrt(3.0));
     color.rgb = color.rgb * hue.y + cross(RCPSQRT3,color.rgb) * hue.x + RCPSQRT3 * dot(RCPSQRT3,color.rgb) * (1.0 - hue.y); //hue
     float avg = (color.r + color.g + color.b) / 3.0;
@@ -227,6 +262,8 @@ const constexpr GLchar default_vertex[]{R"(
 #version 410 core
 
 #define VVAL{}
+#define VTEX{}
+#define {}
 
 uniform view_proj_buffer
 {{
@@ -242,6 +279,9 @@ uniform world_buffer
 layout(location = 0) in vec3 pos_in;
 layout(location = 1) in vec2 uv_in;
 layout(location = 2) in vec4 col_in;
+#if defined(VTEXMULTI_TEXTURE)
+layout(location = 3) in uint slot_in;
+#endif
 
 layout(location = 0) out vec4 sxy;
 layout(location = 1) out vec4 pos;
@@ -251,6 +291,9 @@ layout(location = 3) out vec4 col;
 #if defined(VVALVERTEX_HUE)
 layout(location = 4) out vec2 hue;
 #endif
+#if defined(VTEXMULTI_TEXTURE)
+layout(location = 5) flat out uint slot;
+#endif
 
 #define PI 3.1415926538
 
@@ -266,6 +309,9 @@ void main()
     pos = pos_world;
     uv = uv_in;
     col = col_in;
+#if defined(VTEXMULTI_TEXTURE)
+    slot = slot_in;
+#endif
 #if defined(VVALVERTEX_HUE)
     float hue_angle = (col.r*2) * PI;
     hue = vec2(sin(hue_angle), cos(hue_angle));
@@ -276,6 +322,80 @@ void main()
 
 const constexpr std::string_view dvert_sv{default_vertex};
 
+// Instanced Sprite Vertex Shader
+const constexpr GLchar default_vertex_instance[]{R"(
+#version 410 core
+
+#define VVAL{}
+
+uniform view_proj_buffer
+{{
+    mat4 view_proj;
+}};
+
+layout(location = 0) in vec3 pos_in;
+layout(location = 1) in vec4 rect_in;
+layout(location = 2) in vec4 uv_in;
+layout(location = 3) in vec4 col_in;
+layout(location = 4) in vec3 transform_in; // scale.x, scale.y, rotation
+
+layout(location = 0) out vec4 sxy;
+layout(location = 1) out vec4 pos;
+layout(location = 2) out vec2 uv;
+layout(location = 3) out vec4 col;
+
+#if defined(VVALVERTEX_HUE)
+layout(location = 4) out vec2 hue;
+#endif
+
+#define PI 3.1415926538
+
+void main()
+{{
+    // corners in the same order as Sprite: (l, t) (r, t) (r, b) (l, b)
+    bool right = (gl_VertexID == 1 || gl_VertexID == 2);
+    bool bottom = (gl_VertexID >= 2);
+    vec2 corner = vec2(right ? rect_in.z : rect_in.x, bottom ? rect_in.w : rect_in.y) * transform_in.xy;
+    float sinv = sin(transform_in.z);
+    float cosv = cos(transform_in.z);
+    corner = vec2(corner.x * cosv - corner.y * sinv, corner.x * sinv + corner.y * cosv);
+    vec4 pos_world = vec4(pos_in.xy + corner, pos_in.z, 1.0);
+
+    gl_Position = view_proj * pos_world;
+    sxy = view_proj * pos_world;
+    pos = pos_world;
+    uv = vec2(right ? uv_in.z : uv_in.x, bottom ? uv_in.w : uv_in.y);
+    col = col_in;
+#if defined(VVALVERTEX_HUE)
+    float hue_angle = (col.r*2) * PI;
+    hue = vec2(sin(hue_angle), cos(hue_angle));
+#endif
+}}
+)"};
+
+const constexpr std::string_view dvert_instance_sv{default_vertex_instance};
+
+// Fused Post Effect Chain
+// Every stage defines `vec4 post_effect_stage(vec4 color, vec2 uv)` and keeps its own main,
+// inputs, outputs and the declarations below inside `#ifndef POST_EFFECT_CHAIN`, so the same
+// file still works as a standalone post effect. Stages after the first only see the running
+// color, sampling screen_texture there reads the unprocessed image.
+const constexpr GLchar post_effect_chain_header[]{R"(#version 410 core
+
+#define POST_EFFECT_CHAIN
+
+uniform sampler2D screen_texture;
+uniform engine_data
+{
+    vec4 screen_texture_size;
+    vec4 viewport;
+};
+
+layout(location = 2) in vec2 uv;
+
+layout(location = 0) out vec4 col_out;
+)"};
+
 #define IDX(x) (size_t)static_cast<uint8_t>(x)
 
 namespace Core::Graphics
@@ -297,88 +417,64 @@ namespace Core::Graphics
         "NO_PREMUL_ALPHA",
         "PREMUL_ALPHA",
     };
-
-    static bool compileShaderMacro(const GLchar* data, GLint size, GLenum shadertype, GLuint& shader)
-    {
-        shader = glCreateShader(shadertype);
-        glShaderSource(shader, 1, &data, &size);
-        glCompileShader(shader);
-
-        GLint result;
-        glGetShaderiv(shader, GL_COMPILE_STATUS, &result);
-        if (result == GL_FALSE)
-        {
-            GLchar log[1024];
-            int32_t log_len;
-            glGetShaderInfoLog(shader, 1024, &log_len, log);
-            spdlog::error("[core] Failed to compile shader: {}", log);
-            glDeleteShader(shader);
-            return false;
-        }
-
-        return true;
-    }
-    static bool compileVertexShaderMacro(const GLchar* data, GLint size, GLuint& shader)
-    {
-        return compileShaderMacro(data, size, GL_VERTEX_SHADER, shader);
-    }
-    static bool compileFragmentShaderMacro(const GLchar* data, GLint size, GLuint& shader)
-    {
-        return compileShaderMacro(data, size, GL_FRAGMENT_SHADER, shader);
-    }
+    const constexpr char* texture_count_state[2]{
+        "SINGLE_TEXTURE",
+        "MULTI_TEXTURE",
+    };
+    const constexpr char* world_matrix_state[2]{
+        "NO_WORLD_MATRIX",
+        "WORLD_MATRIX",
+    };
 
     bool PostEffectShader_OpenGL::createResources()
     {
-        GLuint opengl_frag = 0;
-        GLuint opengl_vert = 0;
-        std::string s_vert = std::format(dvert_sv, "");
-            
-        
-        if (!opengl_frag)
+        std::string s_vert = std::format(dvert_sv, "", "", world_matrix_state[0]);
+
+        if (!m_chain.empty())
         {
-            if (is_path)
+            std::string s_frag(post_effect_chain_header);
+            for (size_t i = 0; i < m_chain.size(); i += 1)
             {
                 std::vector<uint8_t> src;
-                if (!GFileManager().loadEx(source, src))
-                    return false;
-                if (!compileFragmentShaderMacro((const GLchar*)src.data(), src.size(), opengl_frag))
-                    return false;
-                if (!compileVertexShaderMacro(s_vert.c_str(), s_vert.length(), opengl_vert))
+                if (!GFileManager().loadEx(m_chain[i], src))
+                {
+                    spdlog::error("[core] Unable to load post effect chain stage '{}'", m_chain[i]);
                     return false;
+                }
+                std::string stage((char const*)src.data(), src.size());
+                if (auto const pos = stage.find("#version"); pos != std::string::npos)
+                {
+                    stage.replace(pos, 1, "//"); // only the chain header declares a version
+                }
+                // compile errors report the stage number as the source string
+                s_frag.append(std::format("#define post_effect_stage post_effect_stage_{}\n#line 1 {}\n", i, i + 1));
+                s_frag.append(stage);
+                s_frag.append("\n#undef post_effect_stage\n");
             }
-            else
+            s_frag.append("\nvoid main()\n{\n    vec4 color = texture(screen_texture, uv);\n");
+            for (size_t i = 0; i < m_chain.size(); i += 1)
             {
-                if (!compileFragmentShaderMacro((const GLchar*)source.data(), source.size(), opengl_frag))
-                    return false;
-                if (!compileVertexShaderMacro(s_vert.c_str(), s_vert.length(), opengl_vert))
-                    return false;
+                s_frag.append(std::format("    color = post_effect_stage_{}(color, uv);\n", i));
             }
+            s_frag.append("    col_out = color;\n}\n");
+            opengl_prgm = m_device->getProgramCache().createProgram(s_vert, s_frag);
         }
-
-        // Link Program
-
-        opengl_prgm = glCreateProgram();
-        glAttachShader(opengl_prgm, opengl_frag);
-        glAttachShader(opengl_prgm, opengl_vert);
-        glLinkProgram(opengl_prgm);
-
-        GLint result;
-        glGetProgramiv(opengl_prgm, GL_LINK_STATUS, &result);
-        if (result == GL_FALSE)
+        else if (is_path)
+        {
+            std::vector<uint8_t> src;
+            if (!GFileManager().loadEx(source, src))
+                return false;
+            opengl_prgm = m_device->getProgramCache().createProgram(s_vert, std::string_view((char const*)src.data(), src.size()));
+        }
+        else
+        {
+            opengl_prgm = m_device->getProgramCache().createProgram(s_vert, source);
+        }
+        if (opengl_prgm == 0)
         {
-            GLchar log[1024];
-            int32_t log_len;
-            glGetProgramInfoLog(opengl_prgm, 1024, &log_len, log);
-            spdlog::error("[core] Failed to link shader: {}", log);
-            glDeleteShader(opengl_frag);
-            glDeleteShader(opengl_vert);
-            glDeleteProgram(opengl_prgm);
             return false;
         }
 
-        glDeleteShader(opengl_frag);
-        glDeleteShader(opengl_vert);
-
         // Uniform Blocks
 
         GLint amt_uniform_blocks = 0;
@@ -404,7 +500,6 @@ namespace Core::Graphics
             local_buffer.binding = block + block_offs;
             local_buffer.buffer.resize(datasize);
             local_buffer.variable.reserve(vars);
-            glGenBuffers(1, &local_buffer.opengl_buffer);
 
             m_buffer_map.emplace(name, std::move(local_buffer));
 
@@ -492,36 +587,73 @@ namespace Core::Graphics
         return true;
     }
 
+    static GLuint linkRendererProgram(ProgramCache_OpenGL& cache, std::string const& vert, std::string const& frag)
+    {
+        GLuint program = cache.createProgram(vert, frag);
+        if (program == 0)
+        {
+            return 0;
+        }
+
+        GLuint idx_view_proj_buffer = glGetUniformBlockIndex(program, "view_proj_buffer");
+        GLuint idx_camera_data = glGetUniformBlockIndex(program, "camera_data");
+        GLuint idx_fog_data = glGetUniformBlockIndex(program, "fog_data");
+
+        glUniformBlockBinding(program, idx_view_proj_buffer, 0);
+        glUniformBlockBinding(program, idx_camera_data, 2);
+        glUniformBlockBinding(program, idx_fog_data, 3);
+
+        GLuint idx_world_buffer = glGetUniformBlockIndex(program, "world_buffer");
+        if (idx_world_buffer != GL_INVALID_INDEX)
+        {
+            glUniformBlockBinding(program, idx_world_buffer, 1);
+        }
+
+        return program;
+    }
+
     bool Renderer_OpenGL::createShaders()
     {
-        GLuint vert = 0;
+        ProgramCache_OpenGL& cache = m_device->getProgramCache();
+        ProgramCacheStatistics const last = cache.getStatistics();
 
         for (int i = 0; i < IDX(VertexColorBlendState::MAX_COUNT); i++)
         for (int j = 0; j < IDX(FogState::MAX_COUNT); j++)
         for (int k = 0; k < IDX(TextureAlphaType::MAX_COUNT); k++)
         {
-            GLuint frag = 0;
-            std::string s_frag = std::format(dfrag_sv, vertex_blend_state[i], fog_state[j], pmul_alpha_state[k]);
-            compileFragmentShaderMacro(s_frag.c_str(), s_frag.length(), frag);
-            std::string s_vert = std::format(dvert_sv, vertex_blend_state[i]);
-            compileVertexShaderMacro(s_vert.c_str(), s_vert.length(), vert);
-            _programs[i][j][k] = glCreateProgram();
-            glAttachShader(_programs[i][j][k], vert);
-            glAttachShader(_programs[i][j][k], frag);
-            glLinkProgram(_programs[i][j][k]);
-
-            glDeleteShader(frag);
-            glDeleteShader(vert);
-
-            GLuint idx_view_proj_buffer = glGetUniformBlockIndex(_programs[i][j][k], "view_proj_buffer");
-            GLuint idx_camera_data = glGetUniformBlockIndex(_programs[i][j][k], "camera_data");
-            GLuint idx_fog_data = glGetUniformBlockIndex(_programs[i][j][k], "fog_data");
-
-            glUniformBlockBinding(_programs[i][j][k], idx_view_proj_buffer, 0);
-            glUniformBlockBinding(_programs[i][j][k], idx_camera_data, 2);
-            glUniformBlockBinding(_programs[i][j][k], idx_fog_data, 3);
+            std::string s_frag = std::format(dfrag_sv, vertex_blend_state[i], fog_state[j], pmul_alpha_state[k], texture_count_state[0]);
+            std::string s_vert = std::format(dvert_sv, vertex_blend_state[i], texture_count_state[0], world_matrix_state[0]);
+            _programs[i][j][k] = linkRendererProgram(cache, s_vert, s_frag);
+
+            // mesh buffers are drawn with their own transform
+            std::string s_vert_mesh = std::format(dvert_sv, vertex_blend_state[i], texture_count_state[0], world_matrix_state[1]);
+            _programs_mesh[i][j][k] = linkRendererProgram(cache, s_vert_mesh, s_frag);
+
+            // instanced sprites share the fragment shader
+            std::string s_vert_instance = std::format(dvert_instance_sv, vertex_blend_state[i]);
+            _programs_instance[i][j][k] = linkRendererProgram(cache, s_vert_instance, s_frag);
+
+            // multi-texture batches select the sampler by the per-vertex slot
+            s_frag = std::format(dfrag_sv, vertex_blend_state[i], fog_state[j], pmul_alpha_state[k], texture_count_state[1]);
+            s_vert = std::format(dvert_sv, vertex_blend_state[i], texture_count_state[1], world_matrix_state[0]);
+            _programs_multi[i][j][k] = linkRendererProgram(cache, s_vert, s_frag);
+
+            if (!_programs[i][j][k] || !_programs_instance[i][j][k] || !_programs_multi[i][j][k] || !_programs_mesh[i][j][k])
+            {
+                return false;
+            }
+
+            for (GLint t = 0; t < DrawCommand::texture_slot_count; t++)
+            {
+                std::string name = std::format("sampler{}", t);
+                glProgramUniform1i(_programs_multi[i][j][k], glGetUniformLocation(_programs_multi[i][j][k], name.c_str()), t);
+            }
         }
 
+        ProgramCacheStatistics const& now = cache.getStatistics();
+        spdlog::info("[core] Renderer shaders ready: {} programs loaded from cache in {:.2f}ms, {} compiled from source in {:.2f}ms",
+            now.loaded - last.loaded, (now.load_time - last.load_time) * 1000.0,
+            now.compiled - last.compiled, (now.compile_time - last.compile_time) * 1000.0);
 
         return true;
     }
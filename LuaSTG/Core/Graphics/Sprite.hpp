@@ -32,6 +32,9 @@ namespace Core::Graphics
 		virtual void draw(Vector2F const& pos, float scale, float rotation) = 0;
 		virtual void draw(Vector2F const& pos, Vector2F const& scale) = 0;
 		virtual void draw(Vector2F const& pos, Vector2F const& scale, float rotation) = 0;
+		// Same as draw(pos, scale, rotation), but submitted as one instance, scaled and rotated on the GPU,
+		// falls back to a quad when an instance would split the renderer's current batch
+		virtual void drawInstance(Vector2F const& pos, Vector2F const& scale, float rotation) = 0;
 
 		virtual bool clone(ISprite** pp_sprite) = 0;
 
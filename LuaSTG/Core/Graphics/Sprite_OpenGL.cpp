@@ -201,6 +201,41 @@ namespace Core::Graphics
 		
 		m_renderer->drawQuad(vert);
 	}
+	void Sprite_OpenGL::drawInstance(Vector2F const& pos, Vector2F const& scale, float rotation)
+	{
+		// Instances carry a single color, per-vertex colors need the regular path
+		if (m_color[0] != m_color[1] || m_color[0] != m_color[2] || m_color[0] != m_color[3])
+		{
+			draw(pos, scale, rotation);
+			return;
+		}
+
+		m_renderer->setTexture(m_texture.get());
+		if (!m_renderer->canBatchInstance())
+		{
+			draw(pos, scale, rotation); // joins the quads before it
+			return;
+		}
+
+		IRenderer::DrawInstance inst;
+		inst.x = pos.x;
+		inst.y = pos.y;
+		inst.z = m_z;
+		inst.l = m_pos_rc.a.x;
+		inst.t = m_pos_rc.a.y;
+		inst.r = m_pos_rc.b.x;
+		inst.b = m_pos_rc.b.y;
+		inst.u0 = m_uv.a.x;
+		inst.v0 = m_uv.a.y;
+		inst.u1 = m_uv.b.x;
+		inst.v1 = m_uv.b.y;
+		inst.color = m_color[0].color();
+		inst.sx = scale.x;
+		inst.sy = scale.y;
+		inst.rotation = rotation;
+
+		m_renderer->drawInstance(inst);
+	}
 
 	bool Sprite_OpenGL::clone(ISprite** pp_sprite)
 	{
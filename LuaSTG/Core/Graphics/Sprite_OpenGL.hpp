@@ -65,6 +65,7 @@ namespace Core::Graphics
 		void draw(Vector2F const& pos, float scale, float rotation);
 		void draw(Vector2F const& pos, Vector2F const& scale);
 		void draw(Vector2F const& pos, Vector2F const& scale, float rotation);
+		void drawInstance(Vector2F const& pos, Vector2F const& scale, float rotation);
 
 		bool clone(ISprite** pp_sprite);
 
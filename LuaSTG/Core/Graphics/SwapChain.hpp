@@ -3,6 +3,8 @@
 #include "Core/Graphics/Window.hpp"
 #include "Core/Graphics/Format.hpp"
 #include "Core/Graphics/Device.hpp"
+#include <algorithm>
+#include <cmath>
 
 namespace Core::Graphics
 {
@@ -14,6 +16,21 @@ namespace Core::Graphics
 		Format format{ Format::B8G8R8A8_UNORM };
 	};
 
+	// Pixel size of a canvas or render target rendered at a fraction of its logical size
+	inline Vector2U getScaledRenderSize(Vector2U size, float scale)
+	{
+		return Vector2U(
+			std::max(1u, (uint32_t)std::lround((float)size.x * scale)),
+			std::max(1u, (uint32_t)std::lround((float)size.y * scale)));
+	}
+
+	enum class FrameCaptureFormat
+	{
+		PNG, // numbered image files in a directory
+		QOI, // same, faster to encode
+		Pipe, // raw RGBA frames written to the standard input of a process
+	};
+
 	struct ISwapChainEventListener
 	{
 		virtual void onSwapChainCreate() = 0;
@@ -28,13 +45,30 @@ namespace Core::Graphics
 		virtual bool setWindowMode(Vector2U size) = 0;
 		virtual bool setCanvasSize(Vector2U size) = 0;
 		virtual Vector2U getCanvasSize() = 0;
+		// Dynamic resolution, the canvas is rendered at getRenderSize and upscaled to the window on present,
+		// getCanvasSize stays the logical size scripts work in
+		virtual bool setRenderScale(float scale) = 0;
+		virtual float getRenderScale() = 0;
+		virtual Vector2U getRenderSize() = 0;
 
 		virtual void clearRenderAttachment() = 0;
 		virtual void applyRenderAttachment() = 0;
 		virtual void setVSync(bool enable) = 0;
 		virtual bool present() = 0;
+		// Present on a dedicated thread, overlapping the swap with the next frame's update
+		virtual bool setPipelinedPresent(bool enable) = 0;
+		virtual bool isPipelinedPresent() = 0;
+		// Time the last pipelined present ran in parallel with the work thread
+		virtual double getPresentOverlapTime() = 0;
 
 		virtual bool saveSnapshotToFile(StringView path) = 0;
+		// Returns right away, see ITexture2D::saveToFileAsync
+		virtual bool saveSnapshotToFileAsync(StringView path, uint64_t* p_id) = 0;
+
+		// Records every presented frame at the canvas size, target is a directory or, for Pipe, a command line
+		virtual bool beginFrameCapture(FrameCaptureFormat format, StringView target) = 0;
+		virtual void endFrameCapture() = 0;
+		virtual bool isFrameCapturing() = 0;
 
 		static bool create(IWindow* p_window, IDevice* p_device, ISwapChain** pp_swapchain);
 	};
@@ -0,0 +1,172 @@
+﻿#include "Core/Graphics/SwapChain_Null.hpp"
+#include "Core/i18n.hpp"
+#include "spdlog/spdlog.h"
+
+namespace Core::Graphics
+{
+	void SwapChain_Null::dispatchEvent(EventType t)
+	{
+		// callback
+		m_is_dispatch_event = true;
+		switch (t)
+		{
+		case EventType::SwapChainCreate:
+			for (auto& v : m_eventobj)
+			{
+				if (v) v->onSwapChainCreate();
+			}
+			break;
+		case EventType::SwapChainDestroy:
+			for (auto& v : m_eventobj)
+			{
+				if (v) v->onSwapChainDestroy();
+			}
+			break;
+		}
+		m_is_dispatch_event = false;
+		// Dealing with delayed objects
+		removeEventListener(nullptr);
+		for (auto& v : m_eventobj_late)
+		{
+			m_eventobj.emplace_back(v);
+		}
+		m_eventobj_late.clear();
+	}
+	void SwapChain_Null::addEventListener(ISwapChainEventListener* e)
+	{
+		removeEventListener(e);
+		if (m_is_dispatch_event)
+		{
+			m_eventobj_late.emplace_back(e);
+		}
+		else
+		{
+			m_eventobj.emplace_back(e);
+		}
+	}
+	void SwapChain_Null::removeEventListener(ISwapChainEventListener* e)
+	{
+		if (m_is_dispatch_event)
+		{
+			for (auto& v : m_eventobj)
+			{
+				if (v == e)
+				{
+					v = nullptr; // doesn't break traversal
+				}
+			}
+		}
+		else
+		{
+			for (auto it = m_eventobj.begin(); it != m_eventobj.end();)
+			{
+				if (*it == e)
+					it = m_eventobj.erase(it);
+				else
+					it++;
+			}
+		}
+	}
+
+	bool SwapChain_Null::setWindowMode(Vector2U size)
+	{
+		if (size.x < 1 || size.y < 1)
+		{
+			i18n_log_error_fmt("[core].SwapChain_OpenGL.create_swapchain_failed_invalid_size_fmt", size.x, size.y);
+			assert(false); return false;
+		}
+
+		dispatchEvent(EventType::SwapChainDestroy);
+		m_canvas_size = size;
+		dispatchEvent(EventType::SwapChainCreate);
+
+		return true;
+	}
+
+	bool SwapChain_Null::setCanvasSize(Vector2U size)
+	{
+		if (size.x == 0 || size.y == 0)
+		{
+			i18n_log_error_fmt("[core].SwapChain_OpenGL.resize_canvas_failed_invalid_size_fmt",
+				size.x, size.y);
+			assert(false); return false;
+		}
+
+		dispatchEvent(EventType::SwapChainDestroy);
+		m_canvas_size = size;
+		dispatchEvent(EventType::SwapChainCreate);
+
+		return true;
+	}
+
+	bool SwapChain_Null::setRenderScale(float scale)
+	{
+		if (!(scale > 0.0f && scale <= 2.0f))
+		{
+			spdlog::error("[core] Invalid render scale {}", scale);
+			return false;
+		}
+		if (getScaledRenderSize(m_canvas_size, scale) == getRenderSize())
+		{
+			m_render_scale = scale;
+			return true;
+		}
+
+		dispatchEvent(EventType::SwapChainDestroy);
+		m_render_scale = scale;
+		dispatchEvent(EventType::SwapChainCreate);
+
+		return true;
+	}
+
+	bool SwapChain_Null::present()
+	{
+		m_present_count += 1;
+		return true;
+	}
+
+	bool SwapChain_Null::saveSnapshotToFile(StringView path)
+	{
+		spdlog::error("[core] Cannot save snapshot to '{}', the null device has no pixel data", path);
+		return false;
+	}
+	bool SwapChain_Null::saveSnapshotToFileAsync(StringView path, uint64_t* p_id)
+	{
+		std::ignore = p_id;
+		return saveSnapshotToFile(path);
+	}
+	bool SwapChain_Null::beginFrameCapture(FrameCaptureFormat format, StringView target)
+	{
+		std::ignore = format;
+		spdlog::error("[core] Cannot capture frames to '{}', the null device has no pixel data", target);
+		return false;
+	}
+
+	SwapChain_Null::SwapChain_Null(Window_SDL* p_window, Device_Null* p_device)
+		: m_window(p_window)
+		, m_device(p_device)
+	{
+		assert(p_window);
+		assert(p_device);
+	}
+	SwapChain_Null::~SwapChain_Null()
+	{
+		spdlog::info("[core] Null SwapChain presented {} frames", m_present_count);
+		assert(m_eventobj.size() == 0);
+		assert(m_eventobj_late.size() == 0);
+	}
+
+	bool SwapChain_Null::create(Window_SDL* p_window, Device_Null* p_device, SwapChain_Null** pp_swapchain)
+	{
+		try
+		{
+			*pp_swapchain = new SwapChain_Null(p_window, p_device);
+			return true;
+		}
+		catch (...)
+		{
+			*pp_swapchain = nullptr;
+			return false;
+		}
+	}
+}
@@ -0,0 +1,65 @@
+﻿#pragma once
+#include "Core/Object.hpp"
+#include "Core/Graphics/SwapChain.hpp"
+#include "Core/Graphics/Window_SDL.hpp"
+#include "Core/Graphics/Device_Null.hpp"
+#include <vector>
+
+namespace Core::Graphics
+{
+	// Swap chain of the null device, presenting only counts frames
+	class SwapChain_Null : public Object<ISwapChain>
+	{
+	private:
+		ScopeObject<Window_SDL> m_window;
+		ScopeObject<Device_Null> m_device;
+		Vector2U m_canvas_size{ 640,480 };
+		float m_render_scale{ 1.0f };
+		uint64_t m_present_count{ 0 };
+
+	private:
+		enum class EventType
+		{
+			SwapChainCreate,
+			SwapChainDestroy,
+		};
+		bool m_is_dispatch_event{ false };
+		std::vector<ISwapChainEventListener*> m_eventobj;
+		std::vector<ISwapChainEventListener*> m_eventobj_late;
+		void dispatchEvent(EventType t);
+	public:
+		void addEventListener(ISwapChainEventListener* e);
+		void removeEventListener(ISwapChainEventListener* e);
+
+		bool setWindowMode(Vector2U size);
+
+		bool setCanvasSize(Vector2U size);
+		Vector2U getCanvasSize() { return m_canvas_size; }
+		bool setRenderScale(float scale);
+		float getRenderScale() { return m_render_scale; }
+		Vector2U getRenderSize() { return getScaledRenderSize(m_canvas_size, m_render_scale); }
+
+		void clearRenderAttachment() {}
+		void applyRenderAttachment() {}
+		void setVSync(bool enable) { std::ignore = enable; }
+		bool present();
+		bool setPipelinedPresent(bool enable) { return !enable; }
+		bool isPipelinedPresent() { return false; }
+		double getPresentOverlapTime() { return 0.0; }
+
+		bool saveSnapshotToFile(StringView path);
+		bool saveSnapshotToFileAsync(StringView path, uint64_t* p_id);
+
+		bool beginFrameCapture(FrameCaptureFormat format, StringView target);
+		void endFrameCapture() {}
+		bool isFrameCapturing() { return false; }
+
+		uint64_t getPresentCount() const noexcept { return m_present_count; }
+
+	public:
+		SwapChain_Null(Window_SDL* p_window, Device_Null* p_device);
+		~SwapChain_Null();
+	public:
+		static bool create(Window_SDL* p_window, Device_Null* p_device, SwapChain_Null** pp_swapchain);
+	};
+}
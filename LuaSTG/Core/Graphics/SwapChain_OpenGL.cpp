@@ -9,6 +9,7 @@
 #include "SDL.h"
 #include "spdlog/spdlog.h"
 #include "stb_image_write.h"
+#include <chrono>
 
 //#define _log(x) OutputDebugStringA(x "\n")
 #define _log(x)
@@ -71,6 +72,19 @@ static bool compileFragmentShaderMacro(const GLchar* data, GLint size, GLuint& s
 {
 	return compileShaderMacro(data, size, GL_FRAGMENT_SHADER, shader);
 }
+static void applySwapInterval(bool vsync)
+{
+	// applies to the context current on the calling thread
+	if (vsync)
+	{
+		if (SDL_GL_SetSwapInterval(-1))
+			SDL_GL_SetSwapInterval(1);
+	}
+	else
+	{
+		SDL_GL_SetSwapInterval(0);
+	}
+}
 
 namespace Core::Graphics
 {
@@ -181,47 +195,45 @@ namespace Core::Graphics
 			spdlog::error("[core] (SwapChain) glGenRenderbuffers failed");
 			return false;
 		}
-		glBindRenderbuffer(GL_RENDERBUFFER, rdr_depthstencilbuffer);
-		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_STENCIL, m_canvas_size.x, m_canvas_size.y);
-
-		glGenTextures(1, &rdr_tex);
-		if (rdr_tex == 0) {
-			spdlog::error("[core] (SwapChain) glGenTextures failed");
-			return false;
-		}
-		glBindTexture(GL_TEXTURE_2D, rdr_tex);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_canvas_size.x, m_canvas_size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
-
-		glGenFramebuffers(1, &rdr_fbo);
-		if (rdr_fbo == 0) {
-			spdlog::error("[core] (SwapChain) glGenFramebuffers failed");
-			return false;
-		}
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, rdr_fbo);
-		glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rdr_depthstencilbuffer);
-		glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, rdr_tex, 0);
-		GLenum DrawBuffers[1] = {GL_COLOR_ATTACHMENT0};
-		glDrawBuffers(1, DrawBuffers);
+		Vector2U const render_size = getRenderSize();
 
-		GLenum status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+		glBindRenderbuffer(GL_RENDERBUFFER, rdr_depthstencilbuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_STENCIL, render_size.x, render_size.y);
 
-		if(status != GL_FRAMEBUFFER_COMPLETE)
+		// the depth stencil buffer is only used while rendering, both canvases share it
+		for (uint32_t i = 0; i < 2; i += 1)
 		{
-			spdlog::error("[core] Failed to create swapchain framebuffer: {}, {}", glGetError(), status);
-			assert(false);
-			return false;
-		}
+			glGenTextures(1, &rdr_texs[i]);
+			if (rdr_texs[i] == 0) {
+				spdlog::error("[core] (SwapChain) glGenTextures failed");
+				return false;
+			}
+			glBindTexture(GL_TEXTURE_2D, rdr_texs[i]);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, render_size.x, render_size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
 
-		glDrawBuffers(1, DrawBuffers);
+			glGenFramebuffers(1, &rdr_fbos[i]);
+			if (rdr_fbos[i] == 0) {
+				spdlog::error("[core] (SwapChain) glGenFramebuffers failed");
+				return false;
+			}
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, rdr_fbos[i]);
+			glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rdr_depthstencilbuffer);
+			glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, rdr_texs[i], 0);
+			GLenum DrawBuffers[1] = {GL_COLOR_ATTACHMENT0};
+			glDrawBuffers(1, DrawBuffers);
 
-		status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+			GLenum status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
 
-		if(status != GL_FRAMEBUFFER_COMPLETE)
-		{
-			spdlog::error("[core] Failed to create swapchain framebuffer: {}, {}", glGetError(), status);
-			assert(false);
-			return false;
+			if(status != GL_FRAMEBUFFER_COMPLETE)
+			{
+				spdlog::error("[core] Failed to create swapchain framebuffer: {}, {}", glGetError(), status);
+				assert(false);
+				return false;
+			}
 		}
+		rdr_index = 0;
+		rdr_fbo = rdr_fbos[0];
+		rdr_tex = rdr_texs[0];
 
 		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 	
@@ -255,8 +267,24 @@ namespace Core::Graphics
 	{
 		_log("destroySwapChainRenderTarget");
 
-		glDeleteFramebuffers(1, &rdr_fbo);
+		waitPresent(); // the present thread may still be reading the canvas
+		glDeleteFramebuffers(2, rdr_fbos);
 		glDeleteRenderbuffers(1, &rdr_depthstencilbuffer);
+		// dynamic resolution recreates all of these whenever the render scale changes
+		glDeleteTextures(2, rdr_texs);
+		rdr_fbos[0] = rdr_fbos[1] = 0;
+		rdr_texs[0] = rdr_texs[1] = 0;
+		glDeleteProgram(prgm);
+		glDeleteVertexArrays(1, &ex_vao);
+		glDeleteBuffers(1, &ex_vbo);
+		glDeleteBuffers(1, &ex_ibo);
+		rdr_fbo = 0;
+		rdr_depthstencilbuffer = 0;
+		rdr_tex = 0;
+		prgm = 0;
+		ex_vao = 0;
+		ex_vbo = 0;
+		ex_ibo = 0;
 	}
 	bool SwapChain_OpenGL::createRenderAttachment()
 	{
@@ -276,6 +304,7 @@ namespace Core::Graphics
 	{
 		//_log("applyRenderAttachment");
 
+		// the presented frame reads the other canvas, present() waits for it before handing this one over
 		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, rdr_fbo);
 	}
 	void SwapChain_OpenGL::clearRenderAttachment()
@@ -353,40 +382,64 @@ namespace Core::Graphics
 		return true;
 	}
 
-	void SwapChain_OpenGL::setVSync(bool enable)
+	bool SwapChain_OpenGL::setRenderScale(float scale)
 	{
-		m_swap_chain_vsync = enable;
-		if (enable)
+		_log("setRenderScale");
+
+		if (!(scale > 0.0f && scale <= 2.0f))
 		{
-			if (SDL_GL_SetSwapInterval(-1))
-				SDL_GL_SetSwapInterval(1);
+			spdlog::error("[core] Invalid render scale {}", scale);
+			return false;
 		}
-		else
+		if (getScaledRenderSize(m_canvas_size, scale) == getRenderSize())
 		{
-			SDL_GL_SetSwapInterval(0);
+			m_render_scale = scale;
+			return true;
 		}
+
+		dispatchEvent(EventType::SwapChainDestroy);
+
+		destroySwapChainRenderTarget();
+
+		m_render_scale = scale;
+
+		if (!createSwapChainRenderTarget()) return false;
+
+		dispatchEvent(EventType::SwapChainCreate);
+
+		return true;
 	}
-	bool SwapChain_OpenGL::present()
+
+	void SwapChain_OpenGL::setVSync(bool enable)
+	{
+		m_swap_chain_vsync = enable;
+		applySwapInterval(enable); // the present thread picks it up with the next frame
+	}
+	Vector2I SwapChain_OpenGL::getDrawableSize()
 	{
 		// Vector2U wsize = m_window->getSize();
 		Vector2I wsize{};
 		SDL_GL_GetDrawableSize(m_window->GetWindow(), &wsize.x, &wsize.y);
-		Vector2F scale_dim = Vector2F((float) wsize.x / m_canvas_size.x, (float) wsize.y / m_canvas_size.y);
+		return wsize;
+	}
+	void SwapChain_OpenGL::presentToWindow(GLuint read_fbo, GLuint vao, Vector2U canvas_size, Vector2U render_size, Vector2I wsize, std::vector<GLuint> const& overlays, GLuint program, GLuint vertex_buffer, GLuint index_buffer)
+	{
+		Vector2F scale_dim = Vector2F((float) wsize.x / canvas_size.x, (float) wsize.y / canvas_size.y);
 		float scale = std::min(scale_dim.x, scale_dim.y);
 		Vector2F d;
 
 		if (scale_dim.x > scale_dim.y)
 		{
-			d.x = ((float)wsize.x - m_canvas_size.x * scale) * 0.5;
+			d.x = ((float)wsize.x - canvas_size.x * scale) * 0.5;
 			d.y = 0;
 		}
 		else
 		{
 			d.x = 0;
-			d.y = ((float)wsize.y - m_canvas_size.y * scale) * 0.5;
+			d.y = ((float)wsize.y - canvas_size.y * scale) * 0.5;
 		}
 		
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, rdr_fbo);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, read_fbo);
 		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 		glViewport(0, 0, wsize.x, wsize.y);
 		glScissor(0, 0, wsize.x, wsize.y);
@@ -394,19 +447,20 @@ namespace Core::Graphics
 		glClearDepth(1.f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+		// the letterbox follows the logical canvas size, a canvas rendered at a lower resolution is upscaled here
 		glBlitFramebuffer(
-			0, 0, m_canvas_size.x, m_canvas_size.y,
-			d.x, scale * m_canvas_size.y + d.y, scale * m_canvas_size.x + d.x, d.y,
+			0, 0, render_size.x, render_size.y,
+			d.x, scale * canvas_size.y + d.y, scale * canvas_size.x + d.x, d.y,
 			GL_COLOR_BUFFER_BIT, GL_LINEAR
 		);
 
-		if (!ex_fbos.empty())
+		if (!overlays.empty())
 		{
-			glUseProgram(prgm);
-			glBindVertexArray(ex_vao);
-			glBindBuffer(GL_ARRAY_BUFFER, ex_vbo);
+			glUseProgram(program);
+			glBindVertexArray(vao);
+			glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
 			glBufferData(GL_ARRAY_BUFFER, sizeof(vertex_data), &vertex_data, GL_STATIC_DRAW);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ex_ibo);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
 			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(idx_data), idx_data, GL_STATIC_DRAW);
 			glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
 			glEnableVertexAttribArray(0);
@@ -418,7 +472,7 @@ namespace Core::Graphics
 			glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);  
 			glBlendEquation(GL_FUNC_ADD);
 
-			for (auto& tex : ex_fbos)
+			for (auto& tex : overlays)
 			{
 				// glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
 				
@@ -441,6 +495,39 @@ namespace Core::Graphics
 		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
 		SDL_GL_SwapWindow(reinterpret_cast<SDL_Window*>(m_window->getNativeHandle()));
+	}
+	bool SwapChain_OpenGL::present()
+	{
+		m_frame_capture.capture(rdr_tex, getRenderSize());
+
+		if (m_present_thread.joinable())
+		{
+			waitPresent(); // at most one frame in flight, it was presenting from the canvas rendered next
+			GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			glFlush(); // the fence must reach the GPU before the present thread waits on it
+			{
+				std::lock_guard<std::mutex> lock(m_present_mutex);
+				m_present_job.fence = fence;
+				m_present_job.canvas_texture = rdr_tex;
+				m_present_job.canvas_size = m_canvas_size;
+				m_present_job.render_size = getRenderSize();
+				m_present_job.window_size = getDrawableSize();
+				m_present_job.overlays = ex_fbos;
+				m_present_job.program = prgm;
+				m_present_job.vertex_buffer = ex_vbo;
+				m_present_job.index_buffer = ex_ibo;
+				m_present_job.vsync = m_swap_chain_vsync;
+				m_present_job.pending = true;
+			}
+			m_present_cv.notify_all();
+			rdr_index ^= 1;
+			rdr_fbo = rdr_fbos[rdr_index];
+			rdr_tex = rdr_texs[rdr_index];
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, rdr_fbo);
+			return true;
+		}
+
+		presentToWindow(rdr_fbo, ex_vao, m_canvas_size, getRenderSize(), getDrawableSize(), ex_fbos, prgm, ex_vbo, ex_ibo);
 
 		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, rdr_fbo);
 
@@ -451,16 +538,157 @@ namespace Core::Graphics
 		return true;
 	}
 
+	void SwapChain_OpenGL::presentThreadMain()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+
+		SDL_GL_MakeCurrent(m_window->GetWindow(), m_present_context);
+
+		// framebuffers and vertex arrays are not shared between contexts
+		GLuint read_fbo = 0;
+		GLuint vao = 0;
+		glGenFramebuffers(1, &read_fbo);
+		glGenVertexArrays(1, &vao);
+		int vsync = -1;
+
+		std::unique_lock<std::mutex> lock(m_present_mutex);
+		while (true)
+		{
+			m_present_cv.wait(lock, [this] { return m_present_job.pending || m_present_quit; });
+			if (m_present_quit)
+			{
+				break;
+			}
+			PresentJob job = m_present_job;
+			lock.unlock();
+
+			auto const start = Clock::now();
+			if (vsync != (int)job.vsync)
+			{
+				applySwapInterval(job.vsync);
+				vsync = (int)job.vsync;
+			}
+			glWaitSync(job.fence, 0, GL_TIMEOUT_IGNORED);
+			glDeleteSync(job.fence);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, read_fbo);
+			glFramebufferTexture(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, job.canvas_texture, 0);
+			glReadBuffer(GL_COLOR_ATTACHMENT0);
+			presentToWindow(read_fbo, vao, job.canvas_size, job.render_size, job.window_size, job.overlays, job.program, job.vertex_buffer, job.index_buffer);
+			GLsync done = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			glFlush();
+			double const busy = std::chrono::duration<double>(Clock::now() - start).count();
+
+			lock.lock();
+			m_present_done_fence = done;
+			m_present_busy_time = busy;
+			m_present_job.pending = false;
+			m_present_cv.notify_all();
+		}
+		lock.unlock();
+
+		glDeleteVertexArrays(1, &vao);
+		glDeleteFramebuffers(1, &read_fbo);
+		SDL_GL_MakeCurrent(m_window->GetWindow(), nullptr);
+	}
+	void SwapChain_OpenGL::waitPresent()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+
+		if (!m_present_thread.joinable())
+		{
+			return;
+		}
+		auto const start = Clock::now();
+		std::unique_lock<std::mutex> lock(m_present_mutex);
+		m_present_cv.wait(lock, [this] { return !m_present_job.pending; });
+		if (m_present_done_fence)
+		{
+			// the next frame may overwrite what the present thread read
+			glWaitSync(m_present_done_fence, 0, GL_TIMEOUT_IGNORED);
+			glDeleteSync(m_present_done_fence);
+			m_present_done_fence = nullptr;
+			double const wait = std::chrono::duration<double>(Clock::now() - start).count();
+			m_present_overlap_time = std::max(0.0, m_present_busy_time - wait);
+		}
+	}
+	bool SwapChain_OpenGL::setPipelinedPresent(bool enable)
+	{
+		if (enable == m_present_thread.joinable())
+		{
+			return true;
+		}
+		if (enable)
+		{
+#ifdef __APPLE__
+			// Cocoa only allows window calls, SDL_GL_SwapWindow included, from the main thread
+			spdlog::warn("[core] Pipelined present is not supported on this platform, presenting on the main thread");
+			return false;
+#else
+			SDL_Window* window = m_window->GetWindow();
+			SDL_GLContext main_context = SDL_GL_GetCurrentContext();
+			SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+			m_present_context = SDL_GL_CreateContext(window); // also makes it current
+			SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+			SDL_GL_MakeCurrent(window, main_context);
+			if (!m_present_context)
+			{
+				spdlog::error("[core] (GetError = {}) Failed to create shared context for the present thread", SDL_GetError());
+				return false;
+			}
+			m_present_quit = false;
+			m_present_job.pending = false;
+			m_present_overlap_time = 0.0;
+			try
+			{
+				m_present_thread = std::thread(&SwapChain_OpenGL::presentThreadMain, this);
+			}
+			catch (std::exception const& e)
+			{
+				spdlog::error("[core] Failed to start present thread ({})", e.what());
+				SDL_GL_DeleteContext(m_present_context);
+				m_present_context = nullptr;
+				return false;
+			}
+			spdlog::info("[core] Pipelined present enabled");
+#endif
+		}
+		else
+		{
+			waitPresent();
+			{
+				std::lock_guard<std::mutex> lock(m_present_mutex);
+				m_present_quit = true;
+			}
+			m_present_cv.notify_all();
+			m_present_thread.join();
+			SDL_GL_DeleteContext(m_present_context);
+			m_present_context = nullptr;
+			m_present_overlap_time = 0.0;
+			spdlog::info("[core] Pipelined present disabled");
+		}
+		return true;
+	}
+
 	bool SwapChain_OpenGL::saveSnapshotToFile(StringView path)
 	{
 		std::string spath(path);
 
-		std::unique_ptr<uint8_t> data(new uint8_t[m_canvas_size.x * m_canvas_size.y * 4]);
+		// at the render size, dynamic resolution doesn't upscale snapshots
+		Vector2U const size = getRenderSize();
+		std::unique_ptr<uint8_t> data(new uint8_t[size.x * size.y * 4]);
 
 		glBindTexture(GL_TEXTURE_2D, rdr_tex);
 		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.get());
 
-		return (bool)stbi_write_png(spath.c_str(), m_canvas_size.x, m_canvas_size.y, 4, data.get(), m_canvas_size.x * 4);
+		return (bool)stbi_write_png(spath.c_str(), size.x, size.y, 4, data.get(), size.x * 4);
+	}
+	bool SwapChain_OpenGL::saveSnapshotToFileAsync(StringView path, uint64_t* p_id)
+	{
+		return m_device->getImageSaveQueue().readback(rdr_tex, getRenderSize(), path, p_id);
+	}
+	bool SwapChain_OpenGL::beginFrameCapture(FrameCaptureFormat format, StringView target)
+	{
+		return m_frame_capture.begin(format, target, m_canvas_size);
 	}
 
 	bool SwapChain_OpenGL::addFramebuffer(GLuint &fbo, GLuint &tex)
@@ -511,6 +739,8 @@ namespace Core::Graphics
 	}
 	SwapChain_OpenGL::~SwapChain_OpenGL()
 	{
+		m_frame_capture.end();
+		setPipelinedPresent(false);
 		m_window->removeEventListener(this);
 		m_device->removeEventListener(this);
 		destroySwapChainRenderTarget();
@@ -3,7 +3,11 @@
 #include "Core/Graphics/SwapChain.hpp"
 #include "Core/Graphics/Window_SDL.hpp"
 #include "Core/Graphics/Device_OpenGL.hpp"
+#include "Core/Graphics/FrameCapture_OpenGL.hpp"
 #include "glad/gl.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 namespace Core::Graphics
@@ -28,9 +32,13 @@ namespace Core::Graphics
 
 		// GLuint sw_fbo = 0;
 		// GLuint sw_tex = 0;
-		GLuint rdr_fbo = 0;
+		GLuint rdr_fbo = 0; // the canvas being rendered, one of rdr_fbos
 		GLuint rdr_depthstencilbuffer = 0;
 		GLuint rdr_tex = 0;
+		// Two canvases, with pipelined present frame N+1 renders into one while N is presented from the other
+		GLuint rdr_fbos[2] = {};
+		GLuint rdr_texs[2] = {};
+		uint32_t rdr_index = 0;
 		GLuint rdr_vao = 0;
 		GLuint rdr_vbo = 0;
 		GLuint rdr_ibo = 0;
@@ -38,12 +46,45 @@ namespace Core::Graphics
 		GLuint ex_vao = 0;
 		GLuint ex_vbo = 0;
 		GLuint ex_ibo = 0;
-		GLuint prgm;
+		GLuint prgm = 0;
 
 		bool m_swap_chain_vsync{ false };
 
+		FrameCapture_OpenGL m_frame_capture;
+
 		bool m_init{ false };
 
+	private:
+		// Pipelined present, the present thread owns a context sharing objects with the main one
+		struct PresentJob
+		{
+			GLsync fence{ nullptr }; // rendering of the frame on the main context
+			GLuint canvas_texture{ 0 };
+			Vector2U canvas_size;
+			Vector2U render_size;
+			Vector2I window_size; // queried on the main thread, window calls other than the swap stay there
+			std::vector<GLuint> overlays;
+			GLuint program{ 0 };
+			GLuint vertex_buffer{ 0 };
+			GLuint index_buffer{ 0 };
+			bool vsync{ false };
+			bool pending{ false };
+		};
+		SDL_GLContext m_present_context{ nullptr };
+		std::thread m_present_thread;
+		std::mutex m_present_mutex;
+		std::condition_variable m_present_cv;
+		PresentJob m_present_job;
+		GLsync m_present_done_fence{ nullptr }; // blit of the last frame on the present context
+		bool m_present_quit{ false };
+		double m_present_busy_time{ 0.0 };
+		double m_present_overlap_time{ 0.0 };
+
+		void presentThreadMain();
+		Vector2I getDrawableSize();
+		void presentToWindow(GLuint read_fbo, GLuint vao, Vector2U canvas_size, Vector2U render_size, Vector2I wsize, std::vector<GLuint> const& overlays, GLuint program, GLuint vertex_buffer, GLuint index_buffer);
+		void waitPresent();
+
 	private:
 		void onDeviceCreate();
 		void onDeviceDestroy();
@@ -56,6 +97,7 @@ namespace Core::Graphics
 
 	private:
 		Vector2U m_canvas_size{ 640,480 };
+		float m_render_scale{ 1.0f };
 	private:
 		bool createSwapChainRenderTarget();
 		void destroySwapChainRenderTarget();
@@ -83,16 +125,29 @@ namespace Core::Graphics
 
 		bool setCanvasSize(Vector2U size);
 		Vector2U getCanvasSize() { return m_canvas_size; }
+		bool setRenderScale(float scale);
+		float getRenderScale() { return m_render_scale; }
+		Vector2U getRenderSize() { return getScaledRenderSize(m_canvas_size, m_render_scale); }
 
 		void clearRenderAttachment();
 		void applyRenderAttachment();
 		// void waitFrameLatency();
 		void setVSync(bool enable);
 		bool present();
+		bool setPipelinedPresent(bool enable);
+		bool isPipelinedPresent() { return m_present_thread.joinable(); }
+		double getPresentOverlapTime() { return m_present_overlap_time; }
 
 		bool saveSnapshotToFile(StringView path);
+		bool saveSnapshotToFileAsync(StringView path, uint64_t* p_id);
+
+		bool beginFrameCapture(FrameCaptureFormat format, StringView target);
+		void endFrameCapture() { m_frame_capture.end(); }
+		bool isFrameCapturing() { return m_frame_capture.isCapturing(); }
 
 		bool addFramebuffer(GLuint &fbo, GLuint &tex);
+		// The present thread reads the overlay textures, call before resizing or drawing into them
+		void waitOverlays() { waitPresent(); }
 
 	public:
 		SwapChain_OpenGL(Window_SDL* p_window, Device_OpenGL* p_device);
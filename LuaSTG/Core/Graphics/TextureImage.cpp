@@ -0,0 +1,816 @@
+﻿#include "Core/Graphics/TextureImage.hpp"
+#include "spdlog/spdlog.h"
+#include "stb_image.h"
+#include "qoi.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+namespace Core::Graphics
+{
+	namespace
+	{
+		// Both containers are little endian
+		template<typename T>
+		T read(uint8_t const* p)
+		{
+			T value{};
+			std::memcpy(&value, p, sizeof(T));
+			return value;
+		}
+
+		constexpr uint8_t ktx2_identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+		constexpr size_t ktx2_header_size = 80; // header and index, the level index follows
+		constexpr size_t ktx2_level_index_size = 24;
+
+		constexpr uint8_t dds_magic[4] = { 'D', 'D', 'S', ' ' };
+		constexpr size_t dds_header_size = 128; // magic and DDS_HEADER
+		constexpr size_t dds_header_dx10_size = 20;
+
+		bool isKTX2(uint8_t const* data, size_t size)
+		{
+			return size >= sizeof(ktx2_identifier) && std::memcmp(data, ktx2_identifier, sizeof(ktx2_identifier)) == 0;
+		}
+		bool isDDS(uint8_t const* data, size_t size)
+		{
+			return size >= sizeof(dds_magic) && std::memcmp(data, dds_magic, sizeof(dds_magic)) == 0;
+		}
+
+		Vector2U getLevelSize(Vector2U size, size_t level)
+		{
+			return Vector2U(std::max<uint32_t>(1, size.x >> level), std::max<uint32_t>(1, size.y >> level));
+		}
+
+		Format getFormatFromVkFormat(uint32_t vk_format)
+		{
+			switch (vk_format)
+			{
+			case 37: // VK_FORMAT_R8G8B8A8_UNORM
+			case 43: // VK_FORMAT_R8G8B8A8_SRGB
+				return Format::R8G8B8A8_UNORM;
+			case 44: // VK_FORMAT_B8G8R8A8_UNORM
+			case 50: // VK_FORMAT_B8G8R8A8_SRGB
+				return Format::B8G8R8A8_UNORM;
+			case 133: // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+			case 134: // VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+				return Format::BC1_UNORM;
+			case 137: // VK_FORMAT_BC3_UNORM_BLOCK
+			case 138: // VK_FORMAT_BC3_SRGB_BLOCK
+				return Format::BC3_UNORM;
+			case 145: // VK_FORMAT_BC7_UNORM_BLOCK
+			case 146: // VK_FORMAT_BC7_SRGB_BLOCK
+				return Format::BC7_UNORM;
+			default:
+				return Format::Unknown;
+			}
+		}
+		Format getFormatFromDxgiFormat(uint32_t dxgi_format)
+		{
+			switch (dxgi_format)
+			{
+			case 28: // DXGI_FORMAT_R8G8B8A8_UNORM
+			case 29: // DXGI_FORMAT_R8G8B8A8_UNORM_SRGB
+				return Format::R8G8B8A8_UNORM;
+			case 87: // DXGI_FORMAT_B8G8R8A8_UNORM
+			case 91: // DXGI_FORMAT_B8G8R8A8_UNORM_SRGB
+				return Format::B8G8R8A8_UNORM;
+			case 71: // DXGI_FORMAT_BC1_UNORM
+			case 72: // DXGI_FORMAT_BC1_UNORM_SRGB
+				return Format::BC1_UNORM;
+			case 77: // DXGI_FORMAT_BC3_UNORM
+			case 78: // DXGI_FORMAT_BC3_UNORM_SRGB
+				return Format::BC3_UNORM;
+			case 98: // DXGI_FORMAT_BC7_UNORM
+			case 99: // DXGI_FORMAT_BC7_UNORM_SRGB
+				return Format::BC7_UNORM;
+			default:
+				return Format::Unknown;
+			}
+		}
+
+		bool parseKTX2(uint8_t const* data, size_t size, TextureImage& image)
+		{
+			if (size < ktx2_header_size)
+			{
+				spdlog::error("[core] KTX2: file too small");
+				return false;
+			}
+			uint32_t const vk_format = read<uint32_t>(data + 12);
+			uint32_t const width = read<uint32_t>(data + 20);
+			uint32_t const height = read<uint32_t>(data + 24);
+			uint32_t const depth = read<uint32_t>(data + 28);
+			uint32_t const layer_count = read<uint32_t>(data + 32);
+			uint32_t const face_count = read<uint32_t>(data + 36);
+			uint32_t const level_count = std::max<uint32_t>(1, read<uint32_t>(data + 40)); // 0 asks the loader to generate mipmaps
+			uint32_t const supercompression = read<uint32_t>(data + 44);
+			if (width == 0 || height == 0 || depth != 0 || layer_count > 1 || face_count != 1)
+			{
+				spdlog::error("[core] KTX2: only 2D textures are supported");
+				return false;
+			}
+			if (supercompression != 0)
+			{
+				spdlog::error("[core] KTX2: supercompression scheme {} is not supported", supercompression);
+				return false;
+			}
+			Format const format = getFormatFromVkFormat(vk_format);
+			if (format == Format::Unknown)
+			{
+				spdlog::error("[core] KTX2: VkFormat {} is not supported", vk_format);
+				return false;
+			}
+			if (level_count > 32 || size < ktx2_header_size + (size_t)level_count * ktx2_level_index_size)
+			{
+				spdlog::error("[core] KTX2: invalid level index");
+				return false;
+			}
+
+			image.format = format;
+			image.size = Vector2U(width, height);
+			image.levels.clear();
+			for (uint32_t i = 0; i < level_count; i += 1)
+			{
+				uint8_t const* index = data + ktx2_header_size + (size_t)i * ktx2_level_index_size;
+				uint64_t const offset = read<uint64_t>(index);
+				uint64_t const length = read<uint64_t>(index + 8);
+				TextureImage::Level level;
+				level.size = getLevelSize(image.size, i);
+				level.size_in_bytes = getLevelSizeInBytes(format, level.size);
+				if (length < level.size_in_bytes || offset > size || size - offset < level.size_in_bytes)
+				{
+					spdlog::error("[core] KTX2: level {} out of range", i);
+					return false;
+				}
+				level.data = data + offset;
+				image.levels.push_back(level);
+			}
+			return true;
+		}
+
+		bool parseDDS(uint8_t const* data, size_t size, TextureImage& image)
+		{
+			constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+			constexpr uint32_t DDSD_DEPTH = 0x800000;
+			constexpr uint32_t DDPF_FOURCC = 0x4;
+			constexpr uint32_t DDPF_RGB = 0x40;
+			constexpr uint32_t DDSCAPS2_CUBEMAP = 0x200;
+			constexpr uint32_t FOURCC_DX10 = 0x30315844; // 'DX10'
+			constexpr uint32_t FOURCC_DXT1 = 0x31545844; // 'DXT1'
+			constexpr uint32_t FOURCC_DXT5 = 0x35545844; // 'DXT5'
+
+			if (size < dds_header_size || read<uint32_t>(data + 4) != 124)
+			{
+				spdlog::error("[core] DDS: invalid header");
+				return false;
+			}
+			uint32_t const flags = read<uint32_t>(data + 8);
+			uint32_t const height = read<uint32_t>(data + 12);
+			uint32_t const width = read<uint32_t>(data + 16);
+			uint32_t const mip_count = read<uint32_t>(data + 28);
+			uint32_t const pf_flags = read<uint32_t>(data + 80);
+			uint32_t const pf_fourcc = read<uint32_t>(data + 84);
+			uint32_t const pf_bit_count = read<uint32_t>(data + 88);
+			uint32_t const pf_r_mask = read<uint32_t>(data + 92);
+			uint32_t const pf_a_mask = read<uint32_t>(data + 104);
+			uint32_t const caps2 = read<uint32_t>(data + 112);
+			if (width == 0 || height == 0 || (flags & DDSD_DEPTH) || (caps2 & DDSCAPS2_CUBEMAP))
+			{
+				spdlog::error("[core] DDS: only 2D textures are supported");
+				return false;
+			}
+
+			Format format = Format::Unknown;
+			size_t offset = dds_header_size;
+			if ((pf_flags & DDPF_FOURCC) && pf_fourcc == FOURCC_DX10)
+			{
+				if (size < dds_header_size + dds_header_dx10_size)
+				{
+					spdlog::error("[core] DDS: invalid header");
+					return false;
+				}
+				uint32_t const dxgi_format = read<uint32_t>(data + 128);
+				uint32_t const dimension = read<uint32_t>(data + 132);
+				uint32_t const array_size = read<uint32_t>(data + 140);
+				if (dimension != 3 || array_size > 1) // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+				{
+					spdlog::error("[core] DDS: only 2D textures are supported");
+					return false;
+				}
+				format = getFormatFromDxgiFormat(dxgi_format);
+				offset += dds_header_dx10_size;
+			}
+			else if ((pf_flags & DDPF_FOURCC) && pf_fourcc == FOURCC_DXT1)
+			{
+				format = Format::BC1_UNORM;
+			}
+			else if ((pf_flags & DDPF_FOURCC) && pf_fourcc == FOURCC_DXT5)
+			{
+				format = Format::BC3_UNORM;
+			}
+			else if ((pf_flags & DDPF_RGB) && pf_bit_count == 32 && pf_a_mask == 0xFF000000u)
+			{
+				if (pf_r_mask == 0x000000FFu)
+					format = Format::R8G8B8A8_UNORM;
+				else if (pf_r_mask == 0x00FF0000u)
+					format = Format::B8G8R8A8_UNORM;
+			}
+			if (format == Format::Unknown)
+			{
+				spdlog::error("[core] DDS: pixel format is not supported");
+				return false;
+			}
+
+			uint32_t const level_count = (flags & DDSD_MIPMAPCOUNT) ? std::max<uint32_t>(1, mip_count) : 1;
+			if (level_count > 32)
+			{
+				spdlog::error("[core] DDS: invalid mipmap count");
+				return false;
+			}
+			image.format = format;
+			image.size = Vector2U(width, height);
+			image.levels.clear();
+			for (uint32_t i = 0; i < level_count; i += 1)
+			{
+				TextureImage::Level level;
+				level.size = getLevelSize(image.size, i);
+				level.size_in_bytes = getLevelSizeInBytes(format, level.size);
+				if (size - offset < level.size_in_bytes)
+				{
+					spdlog::error("[core] DDS: level {} out of range", i);
+					return false;
+				}
+				level.data = data + offset;
+				offset += level.size_in_bytes;
+				image.levels.push_back(level);
+			}
+			return true;
+		}
+
+		// Block decoders, each writes a 4x4 block of RGBA8 pixels
+
+		using Block = uint8_t[16][4];
+
+		void decodeColorBlock(uint8_t const* data, Block& block, bool bc1)
+		{
+			uint16_t const c0 = read<uint16_t>(data);
+			uint16_t const c1 = read<uint16_t>(data + 2);
+			uint32_t const indices = read<uint32_t>(data + 4);
+			auto const expand565 = [](uint16_t c, uint8_t* p)
+			{
+				uint32_t const r = (c >> 11) & 0x1F;
+				uint32_t const g = (c >> 5) & 0x3F;
+				uint32_t const b = c & 0x1F;
+				p[0] = (uint8_t)((r << 3) | (r >> 2));
+				p[1] = (uint8_t)((g << 2) | (g >> 4));
+				p[2] = (uint8_t)((b << 3) | (b >> 2));
+				p[3] = 255;
+			};
+			uint8_t palette[4][4];
+			expand565(c0, palette[0]);
+			expand565(c1, palette[1]);
+			if (!bc1 || c0 > c1)
+			{
+				for (int c = 0; c < 3; c += 1)
+				{
+					palette[2][c] = (uint8_t)((2 * palette[0][c] + palette[1][c]) / 3);
+					palette[3][c] = (uint8_t)((palette[0][c] + 2 * palette[1][c]) / 3);
+				}
+				palette[2][3] = 255;
+				palette[3][3] = 255;
+			}
+			else
+			{
+				// BC1 with one bit alpha, the last entry is transparent black
+				for (int c = 0; c < 3; c += 1)
+				{
+					palette[2][c] = (uint8_t)((palette[0][c] + palette[1][c]) / 2);
+					palette[3][c] = 0;
+				}
+				palette[2][3] = 255;
+				palette[3][3] = 0;
+			}
+			for (int i = 0; i < 16; i += 1)
+			{
+				std::memcpy(block[i], palette[(indices >> (2 * i)) & 0x3], 4);
+			}
+		}
+		void decodeAlphaBlock(uint8_t const* data, Block& block)
+		{
+			uint32_t const a0 = data[0];
+			uint32_t const a1 = data[1];
+			uint8_t palette[8];
+			palette[0] = (uint8_t)a0;
+			palette[1] = (uint8_t)a1;
+			if (a0 > a1)
+			{
+				for (uint32_t i = 1; i < 7; i += 1)
+					palette[i + 1] = (uint8_t)(((7 - i) * a0 + i * a1) / 7);
+			}
+			else
+			{
+				for (uint32_t i = 1; i < 5; i += 1)
+					palette[i + 1] = (uint8_t)(((5 - i) * a0 + i * a1) / 5);
+				palette[6] = 0;
+				palette[7] = 255;
+			}
+			uint64_t indices = 0;
+			std::memcpy(&indices, data + 2, 6);
+			for (int i = 0; i < 16; i += 1)
+			{
+				block[i][3] = palette[(indices >> (3 * i)) & 0x7];
+			}
+		}
+
+		struct BC7Mode
+		{
+			uint8_t subset_count;
+			uint8_t partition_bits;
+			uint8_t rotation_bits;
+			uint8_t index_selection_bits;
+			uint8_t color_bits;
+			uint8_t alpha_bits;
+			uint8_t endpoint_p_bits; // one per endpoint
+			uint8_t shared_p_bits; // one per subset
+			uint8_t index_bits;
+			uint8_t index2_bits;
+		};
+		constexpr BC7Mode bc7_modes[8] = {
+			{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+			{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+			{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+			{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+			{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+			{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+			{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+			{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+		};
+		constexpr uint8_t bc7_partition2[64][16] = {
+			{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1 },
+			{ 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1 },
+			{ 0, 1, 1, 1, 0, 1, 1, 1, 0, 1, 1, 1, 0, 1, 1, 1 },
+			{ 0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 1, 1, 1 },
+			{ 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 1 },
+			{ 0, 0, 1, 1, 0, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1 },
+			{ 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1 },
+			{ 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 1 },
+			{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 1 },
+			{ 0, 0, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 },
+			{ 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 1, 1, 1, 1, 1, 1 },
+			{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 1, 1 },
+			{ 0, 0, 0, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 },
+			{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1 },
+			{ 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 },
+			{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1 },
+			{ 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 1, 1, 1, 1 },
+			{ 0, 1, 1, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0 },
+			{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0 },
+			{ 0, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0, 1, 0, 0, 0, 0 },
+			{ 0, 0, 1, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0 },
+			{ 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0, 1, 1, 1, 0 },
+			{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0 },
+			{ 0, 1, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 0, 1 },
+			{ 0, 0, 1, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0 },
+			{ 0, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0 },
+			{ 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0 },
+			{ 0, 0, 1, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 1, 0, 0 },
+			{ 0, 0, 0, 1, 0, 1, 1, 1, 1, 1, 1, 0, 1, 0, 0, 0 },
+			{ 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0 },
+			{ 0, 1, 1, 1, 0, 0, 0, 1, 1, 0, 0, 0, 1, 1, 1, 0 },
+			{ 0, 0, 1, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 1, 0, 0 },
+			{ 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1 },
+			{ 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 0, 0, 1, 1, 1, 1 },
+			{ 0, 1, 0, 1, 1, 0, 1, 0, 0, 1, 0, 1, 1, 0, 1, 0 },
+			{ 0, 0, 1, 1, 0, 0, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0 },
+			{ 0, 0, 1, 1, 1, 1, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0 },
+			{ 0, 1, 0, 1, 0, 1, 0, 1, 1, 0, 1, 0, 1, 0, 1, 0 },
+			{ 0, 1, 1, 0, 1, 0, 0, 1, 0, 1, 1, 0, 1, 0, 0, 1 },
+			{ 0, 1, 0, 1, 1, 0, 1, 0, 1, 0, 1, 0, 0, 1, 0, 1 },
+			{ 0, 1, 1, 1, 0, 0, 1, 1, 1, 1, 0, 0, 1, 1, 1, 0 },
+			{ 0, 0, 0, 1, 0, 0, 1, 1, 1, 1, 0, 0, 1, 0, 0, 0 },
+			{ 0, 0, 1, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 1, 0, 0 },
+			{ 0, 0, 1, 1, 1, 0, 1, 1, 1, 1, 0, 1, 1, 1, 0, 0 },
+			{ 0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0 },
+			{ 0, 0, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0, 1, 1 },
+			{ 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1 },
+			{ 0, 0, 0, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0, 0 },
+			{ 0, 1, 0, 0, 1, 1, 1, 0, 0, 1, 0, 0, 0, 0, 0, 0 },
+			{ 0, 0, 1, 0, 0, 1, 1, 1, 0, 0, 1, 0, 0, 0, 0, 0 },
+			{ 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 1, 1, 0, 0, 1, 0 },
+			{ 0, 0, 0, 0, 0, 1, 0, 0, 1, 1, 1, 0, 0, 1, 0, 0 },
+			{ 0, 1, 1, 0, 1, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 1 },
+			{ 0, 0, 1, 1, 0, 1, 1, 0, 1, 1, 0, 0, 1, 0, 0, 1 },
+			{ 0, 1, 1, 0, 0, 0, 1, 1, 1, 0, 0, 1, 1, 1, 0, 0 },
+			{ 0, 0, 1, 1, 1, 0, 0, 1, 1, 1, 0, 0, 0, 1, 1, 0 },
+			{ 0, 1, 1, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 0, 0, 1 },
+			{ 0, 1, 1, 0, 0, 0, 1, 1, 0, 0, 1, 1, 1, 0, 0, 1 },
+			{ 0, 1, 1, 1, 1, 1, 1, 0, 1, 0, 0, 0, 0, 0, 0, 1 },
+			{ 0, 0, 0, 1, 1, 0, 0, 0, 1, 1, 1, 0, 0, 1, 1, 1 },
+			{ 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1 },
+			{ 0, 0, 1, 1, 0, 0, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0 },
+			{ 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 1, 0, 1, 1, 1, 0 },
+			{ 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 1, 1, 1 },
+		};
+		constexpr uint8_t bc7_partition3[64][16] = {
+			{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2 },
+			{ 0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1 },
+			{ 0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+			{ 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1 },
+			{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2 },
+			{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2 },
+			{ 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1 },
+			{ 0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+			{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2 },
+			{ 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2 },
+			{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+			{ 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2 },
+			{ 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2 },
+			{ 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2 },
+			{ 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2 },
+			{ 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0 },
+			{ 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2 },
+			{ 0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0 },
+			{ 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2 },
+			{ 0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1 },
+			{ 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2 },
+			{ 0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1 },
+			{ 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2 },
+			{ 0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0 },
+			{ 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0 },
+			{ 0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2 },
+			{ 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0 },
+			{ 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1 },
+			{ 0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2 },
+			{ 0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2 },
+			{ 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1 },
+			{ 0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1 },
+			{ 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2 },
+			{ 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1 },
+			{ 0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2 },
+			{ 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0 },
+			{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0 },
+			{ 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0 },
+			{ 0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0 },
+			{ 0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1 },
+			{ 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1 },
+			{ 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+			{ 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1 },
+			{ 0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2 },
+			{ 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1 },
+			{ 0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1 },
+			{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1 },
+			{ 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1 },
+			{ 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2 },
+			{ 0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1 },
+			{ 0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2 },
+			{ 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2 },
+			{ 0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2 },
+			{ 0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2 },
+			{ 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2 },
+			{ 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2 },
+			{ 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2 },
+			{ 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2 },
+			{ 0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2 },
+			{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2 },
+			{ 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1 },
+			{ 0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2 },
+			{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2 },
+			{ 0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0 },
+		};
+		constexpr uint8_t bc7_anchor2[64] = {
+			15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+			15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+			15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+			6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15,
+		};
+		constexpr uint8_t bc7_anchor3_1[64] = {
+			3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3,
+			3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+			8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15,
+			3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3,
+		};
+		constexpr uint8_t bc7_anchor3_2[64] = {
+			15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8,
+			15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+			15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8,
+			15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8,
+		};
+		constexpr uint8_t bc7_weight2[4] = { 0, 21, 43, 64 };
+		constexpr uint8_t bc7_weight3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+		constexpr uint8_t bc7_weight4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		class BitReader
+		{
+		private:
+			uint8_t const* m_data;
+			uint32_t m_position{};
+		public:
+			uint32_t read(uint32_t count)
+			{
+				uint32_t value = 0;
+				for (uint32_t i = 0; i < count; i += 1, m_position += 1)
+				{
+					value |= (uint32_t)((m_data[m_position >> 3] >> (m_position & 7)) & 1) << i;
+				}
+				return value;
+			}
+		public:
+			explicit BitReader(uint8_t const* data) : m_data(data) {}
+		};
+
+		uint8_t interpolateBC7(uint32_t e0, uint32_t e1, uint32_t index, uint32_t index_bits)
+		{
+			uint32_t const weight = index_bits == 2 ? bc7_weight2[index] : (index_bits == 3 ? bc7_weight3[index] : bc7_weight4[index]);
+			return (uint8_t)(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+		}
+		void decodeBC7Block(uint8_t const* data, Block& block)
+		{
+			BitReader bits(data);
+			uint32_t mode = 0;
+			while (mode < 8 && bits.read(1) == 0)
+			{
+				mode += 1;
+			}
+			if (mode == 8)
+			{
+				std::memset(block, 0, sizeof(Block)); // reserved, decodes to transparent black
+				return;
+			}
+			BC7Mode const& m = bc7_modes[mode];
+			uint32_t const partition = bits.read(m.partition_bits);
+			uint32_t const rotation = bits.read(m.rotation_bits);
+			uint32_t const index_selection = bits.read(m.index_selection_bits);
+
+			// Endpoints are stored channel by channel, then the p-bits
+			uint32_t const endpoint_count = 2u * m.subset_count;
+			uint32_t endpoints[6][4] = {};
+			for (uint32_t c = 0; c < 3; c += 1)
+				for (uint32_t e = 0; e < endpoint_count; e += 1)
+					endpoints[e][c] = bits.read(m.color_bits);
+			if (m.alpha_bits)
+			{
+				for (uint32_t e = 0; e < endpoint_count; e += 1)
+					endpoints[e][3] = bits.read(m.alpha_bits);
+			}
+			uint32_t color_bits = m.color_bits;
+			uint32_t alpha_bits = m.alpha_bits;
+			if (m.endpoint_p_bits || m.shared_p_bits)
+			{
+				uint32_t p_bits[6] = {};
+				if (m.endpoint_p_bits)
+				{
+					for (uint32_t e = 0; e < endpoint_count; e += 1)
+						p_bits[e] = bits.read(1);
+				}
+				else
+				{
+					for (uint32_t s = 0; s < m.subset_count; s += 1)
+						p_bits[2 * s] = p_bits[2 * s + 1] = bits.read(1);
+				}
+				for (uint32_t e = 0; e < endpoint_count; e += 1)
+				{
+					for (uint32_t c = 0; c < 3; c += 1)
+						endpoints[e][c] = (endpoints[e][c] << 1) | p_bits[e];
+					if (alpha_bits)
+						endpoints[e][3] = (endpoints[e][3] << 1) | p_bits[e];
+				}
+				color_bits += 1;
+				if (alpha_bits)
+					alpha_bits += 1;
+			}
+			for (uint32_t e = 0; e < endpoint_count; e += 1)
+			{
+				for (uint32_t c = 0; c < 3; c += 1)
+				{
+					uint32_t const v = endpoints[e][c] << (8 - color_bits);
+					endpoints[e][c] = v | (v >> color_bits);
+				}
+				if (alpha_bits)
+				{
+					uint32_t const v = endpoints[e][3] << (8 - alpha_bits);
+					endpoints[e][3] = v | (v >> alpha_bits);
+				}
+				else
+				{
+					endpoints[e][3] = 255;
+				}
+			}
+
+			// The anchor index of each subset is stored with one bit less
+			uint8_t const* subsets = nullptr;
+			uint32_t anchors[3] = { 0, 0, 0 };
+			static constexpr uint8_t single_subset[16] = {};
+			switch (m.subset_count)
+			{
+			case 2:
+				subsets = bc7_partition2[partition];
+				anchors[1] = bc7_anchor2[partition];
+				break;
+			case 3:
+				subsets = bc7_partition3[partition];
+				anchors[1] = bc7_anchor3_1[partition];
+				anchors[2] = bc7_anchor3_2[partition];
+				break;
+			default:
+				subsets = single_subset;
+				break;
+			}
+			uint32_t indices[16] = {};
+			uint32_t indices2[16] = {};
+			for (uint32_t i = 0; i < 16; i += 1)
+			{
+				bool const anchor = (i == anchors[subsets[i]]);
+				indices[i] = bits.read(m.index_bits - (anchor ? 1 : 0));
+			}
+			if (m.index2_bits)
+			{
+				for (uint32_t i = 0; i < 16; i += 1)
+					indices2[i] = bits.read(m.index2_bits - (i == 0 ? 1 : 0));
+			}
+
+			for (uint32_t i = 0; i < 16; i += 1)
+			{
+				uint32_t const* e0 = endpoints[2 * subsets[i]];
+				uint32_t const* e1 = endpoints[2 * subsets[i] + 1];
+				uint32_t color_index = indices[i];
+				uint32_t color_index_bits = m.index_bits;
+				uint32_t alpha_index = indices[i];
+				uint32_t alpha_index_bits = m.index_bits;
+				if (m.index2_bits)
+				{
+					// Modes 4 and 5 keep a second index set, mode 4 picks which one colors use
+					alpha_index = indices2[i];
+					alpha_index_bits = m.index2_bits;
+					if (index_selection)
+					{
+						std::swap(color_index, alpha_index);
+						std::swap(color_index_bits, alpha_index_bits);
+					}
+				}
+				for (uint32_t c = 0; c < 3; c += 1)
+					block[i][c] = interpolateBC7(e0[c], e1[c], color_index, color_index_bits);
+				block[i][3] = interpolateBC7(e0[3], e1[3], alpha_index, alpha_index_bits);
+				if (rotation)
+				{
+					std::swap(block[i][3], block[i][rotation - 1]);
+				}
+			}
+		}
+
+		void decompressLevel(Format format, uint8_t const* data, Vector2U size, uint8_t* pixels)
+		{
+			size_t const block_size = (format == Format::BC1_UNORM) ? 8 : 16;
+			uint32_t const block_x = (size.x + 3) / 4;
+			uint32_t const block_y = (size.y + 3) / 4;
+			Block block;
+			for (uint32_t by = 0; by < block_y; by += 1)
+			{
+				for (uint32_t bx = 0; bx < block_x; bx += 1)
+				{
+					uint8_t const* source = data + ((size_t)by * block_x + bx) * block_size;
+					switch (format)
+					{
+					case Format::BC1_UNORM:
+						decodeColorBlock(source, block, true);
+						break;
+					case Format::BC3_UNORM:
+						decodeColorBlock(source + 8, block, false);
+						decodeAlphaBlock(source, block);
+						break;
+					case Format::BC7_UNORM:
+						decodeBC7Block(source, block);
+						break;
+					default:
+						assert(false);
+						return;
+					}
+					// Edge blocks are clipped to the level
+					uint32_t const w = std::min<uint32_t>(4, size.x - bx * 4);
+					uint32_t const h = std::min<uint32_t>(4, size.y - by * 4);
+					for (uint32_t y = 0; y < h; y += 1)
+					{
+						uint8_t* row = pixels + (((size_t)by * 4 + y) * size.x + (size_t)bx * 4) * 4;
+						std::memcpy(row, block[y * 4], (size_t)w * 4);
+					}
+				}
+			}
+		}
+	}
+
+	bool isBlockCompressed(Format format)
+	{
+		switch (format)
+		{
+		case Format::BC1_UNORM:
+		case Format::BC3_UNORM:
+		case Format::BC7_UNORM:
+			return true;
+		default:
+			return false;
+		}
+	}
+	size_t getLevelSizeInBytes(Format format, Vector2U size)
+	{
+		size_t const block_count = (size_t)((size.x + 3) / 4) * (size_t)((size.y + 3) / 4);
+		switch (format)
+		{
+		case Format::R8_UNORM:
+			return (size_t)size.x * (size_t)size.y;
+		case Format::R8G8B8A8_UNORM:
+		case Format::B8G8R8A8_UNORM:
+			return (size_t)size.x * (size_t)size.y * 4;
+		case Format::BC1_UNORM:
+			return block_count * 8;
+		case Format::BC3_UNORM:
+		case Format::BC7_UNORM:
+			return block_count * 16;
+		default:
+			return 0;
+		}
+	}
+
+	uint8_t* decodeImageRGBA8(uint8_t const* data, size_t size, Vector2U& out_size)
+	{
+		Vector2I image_size;
+		uint8_t* pixels = nullptr;
+		if (size >= 4 && data[0] == 'q' && data[1] == 'o' && data[2] == 'i' && data[3] == 'f')
+		{
+			qoi_desc desc;
+			pixels = (uint8_t*)qoi_decode(data, (int)size, &desc, 4);
+			image_size.x = (int)desc.width;
+			image_size.y = (int)desc.height;
+		}
+		else
+		{
+			pixels = stbi_load_from_memory(data, (int)size, &image_size.x, &image_size.y, NULL, 4);
+		}
+		if (pixels)
+		{
+			// image size will never be negative
+			out_size.x = (uint32_t)image_size.x;
+			out_size.y = (uint32_t)image_size.y;
+		}
+		return pixels;
+	}
+
+	bool isTextureContainer(uint8_t const* data, size_t size)
+	{
+		return isKTX2(data, size) || isDDS(data, size);
+	}
+	bool parseTextureContainer(uint8_t const* data, size_t size, TextureImage& image)
+	{
+		if (isKTX2(data, size))
+			return parseKTX2(data, size, image);
+		if (isDDS(data, size))
+			return parseDDS(data, size, image);
+		return false;
+	}
+
+	bool loadTextureImage(uint8_t const* data, size_t size, TextureImage& image)
+	{
+		if (isTextureContainer(data, size))
+		{
+			image.storage.reset();
+			return parseTextureContainer(data, size, image);
+		}
+		Vector2U image_size;
+		image.storage.reset(decodeImageRGBA8(data, size, image_size));
+		if (!image.storage)
+		{
+			return false;
+		}
+		image.format = Format::R8G8B8A8_UNORM;
+		image.size = image_size;
+		image.levels.clear();
+		image.levels.push_back(TextureImage::Level{ image_size, image.storage.get(), getLevelSizeInBytes(image.format, image_size) });
+		return true;
+	}
+
+	bool decompressTextureImage(TextureImage const& source, size_t level_count, TextureImage& target)
+	{
+		assert(isBlockCompressed(source.format) && level_count <= source.levels.size());
+		size_t total = 0;
+		for (size_t i = 0; i < level_count; i += 1)
+		{
+			total += getLevelSizeInBytes(Format::R8G8B8A8_UNORM, source.levels[i].size);
+		}
+		target.storage.reset(static_cast<uint8_t*>(std::malloc(total)));
+		if (!target.storage)
+		{
+			return false;
+		}
+		target.format = Format::R8G8B8A8_UNORM;
+		target.size = source.size;
+		target.levels.clear();
+		uint8_t* pixels = target.storage.get();
+		for (size_t i = 0; i < level_count; i += 1)
+		{
+			TextureImage::Level const& level = source.levels[i];
+			decompressLevel(source.format, level.data, level.size, pixels);
+			size_t const bytes = getLevelSizeInBytes(Format::R8G8B8A8_UNORM, level.size);
+			target.levels.push_back(TextureImage::Level{ level.size, pixels, bytes });
+			pixels += bytes;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,45 @@
+﻿#pragma once
+#include "Core/Type.hpp"
+#include "Core/Graphics/Format.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace Core::Graphics
+{
+	// Pixels of a texture ready for upload, level 0 first
+	struct TextureImage
+	{
+		struct Level
+		{
+			Vector2U size;
+			uint8_t const* data{};
+			size_t size_in_bytes{};
+		};
+
+		Format format{ Format::Unknown };
+		Vector2U size;
+		std::vector<Level> levels;
+		// Owns the pixels of decoded images, levels of container files point into the file data
+		std::unique_ptr<uint8_t, decltype(&std::free)> storage{ nullptr, &std::free };
+	};
+
+	bool isBlockCompressed(Format format);
+	// Block compressed formats round up to whole 4x4 blocks
+	size_t getLevelSizeInBytes(Format format, Vector2U size);
+
+	// Decodes PNG, JPEG, QOI and so on into RGBA8, returns nullptr on failure, free with std::free
+	uint8_t* decodeImageRGBA8(uint8_t const* data, size_t size, Vector2U& out_size);
+
+	// KTX2 and DDS files store their mip chain (RGBA8, BGRA8, BC1, BC3 or BC7), the levels are uploaded as they are
+	bool isTextureContainer(uint8_t const* data, size_t size);
+	bool parseTextureContainer(uint8_t const* data, size_t size, TextureImage& image);
+
+	// Containers are used in place (data must outlive the image), other files are decoded into a single RGBA8 level
+	bool loadTextureImage(uint8_t const* data, size_t size, TextureImage& image);
+
+	// CPU fallback for drivers without the block compressed format, decodes the first level_count levels into RGBA8
+	bool decompressTextureImage(TextureImage const& source, size_t level_count, TextureImage& target);
+}
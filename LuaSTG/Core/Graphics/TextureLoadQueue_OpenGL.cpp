@@ -0,0 +1,148 @@
+﻿#include "Core/Graphics/TextureLoadQueue_OpenGL.hpp"
+#include "Core/Graphics/Device_OpenGL.hpp"
+#include "Core/FileManager.hpp"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+namespace Core::Graphics
+{
+	void TextureLoadQueue_OpenGL::worker()
+	{
+		while (true)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_cv.wait(lock, [this] { return m_quit || !m_jobs.empty(); });
+				if (m_quit)
+				{
+					return;
+				}
+				job = std::move(m_jobs.front());
+				m_jobs.pop_front();
+			}
+			Image image;
+			image.id = job.id;
+			image.path = std::move(job.path);
+			image.mipmap = job.mipmap;
+			image.valid = loadTextureImage(job.source.data(), job.source.size(), image.image);
+			if (image.valid && isBlockCompressed(image.image.format) && !Texture2D_OpenGL::isFormatSupported(image.image.format))
+			{
+				// The CPU fallback is slow, do it here rather than during the upload
+				TextureImage decompressed;
+				image.valid = decompressTextureImage(image.image, job.mipmap ? image.image.levels.size() : 1, decompressed);
+				image.image = std::move(decompressed);
+			}
+			image.source = std::move(job.source); // moving keeps the buffer, the levels stay valid
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_images.emplace_back(std::move(image));
+			}
+		}
+	}
+
+	bool TextureLoadQueue_OpenGL::load(StringView path, bool mipmap, uint64_t* p_id)
+	{
+		assert(p_id);
+		Job job;
+		// The file manager isn't thread safe, only decoding moves to the workers
+		if (!GFileManager().loadEx(path, job.source))
+		{
+			spdlog::error("[core] Unable to load file '{}'", path);
+			return false;
+		}
+		job.id = m_next_id++;
+		job.path = path;
+		job.mipmap = mipmap;
+		*p_id = job.id;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_threads.empty())
+			{
+				size_t const count = std::clamp<size_t>(std::thread::hardware_concurrency() / 2, 1, max_thread_count);
+				for (size_t i = 0; i < count; i += 1)
+				{
+					m_threads.emplace_back(&TextureLoadQueue_OpenGL::worker, this);
+				}
+			}
+			m_jobs.emplace_back(std::move(job));
+		}
+		m_cv.notify_one();
+		return true;
+	}
+	void TextureLoadQueue_OpenGL::update(double budget)
+	{
+		using Clock = std::chrono::steady_clock;
+		auto const start = Clock::now();
+		while (true)
+		{
+			Image image;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (m_images.empty())
+				{
+					return;
+				}
+				image = std::move(m_images.front());
+				m_images.pop_front();
+			}
+
+			Result result;
+			result.id = image.id;
+			if (!image.valid)
+			{
+				spdlog::error("[core] Unable to parse file '{}'", image.path);
+			}
+			else
+			{
+				try
+				{
+					result.texture.attach(new Texture2D_OpenGL(m_device, image.path, image.mipmap, image.image));
+				}
+				catch (...)
+				{
+					spdlog::error("[core] Unable to create texture from '{}'", image.path);
+				}
+			}
+			m_results.emplace_back(std::move(result));
+
+			// Upload and mipmap generation are the expensive part left on this thread
+			if (std::chrono::duration<double>(Clock::now() - start).count() >= budget)
+			{
+				return;
+			}
+		}
+	}
+	bool TextureLoadQueue_OpenGL::popResult(uint64_t* p_id, ITexture2D** pp_texture)
+	{
+		assert(p_id && pp_texture);
+		if (m_results.empty())
+		{
+			return false;
+		}
+		Result& result = m_results.front();
+		*p_id = result.id;
+		*pp_texture = result.texture.get();
+		if (*pp_texture)
+		{
+			(*pp_texture)->retain();
+		}
+		m_results.pop_front();
+		return true;
+	}
+
+	TextureLoadQueue_OpenGL::~TextureLoadQueue_OpenGL()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_quit = true;
+		}
+		m_cv.notify_all();
+		for (auto& thread : m_threads)
+		{
+			thread.join();
+		}
+	}
+}
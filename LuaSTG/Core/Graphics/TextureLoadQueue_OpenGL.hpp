@@ -0,0 +1,71 @@
+﻿#pragma once
+#include "Core/Object.hpp"
+#include "Core/Graphics/Device.hpp"
+#include "Core/Graphics/TextureImage.hpp"
+#include "Core/Type.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Core::Graphics
+{
+	class Device_OpenGL;
+
+	// Texture loading split in two stages: images are decoded on a small pool of worker
+	// threads, the main thread creates the GL textures within a time budget every frame
+	class TextureLoadQueue_OpenGL
+	{
+	private:
+		static constexpr size_t max_thread_count = 4;
+
+		struct Job
+		{
+			uint64_t id{};
+			std::string path;
+			bool mipmap{};
+			std::vector<uint8_t> source;
+		};
+		struct Image
+		{
+			uint64_t id{};
+			std::string path;
+			bool mipmap{};
+			bool valid{};
+			std::vector<uint8_t> source; // container levels point into it
+			TextureImage image;
+		};
+		struct Result
+		{
+			uint64_t id{};
+			ScopeObject<ITexture2D> texture;
+		};
+
+		Device_OpenGL* m_device;
+		uint64_t m_next_id{ 1 };
+		std::deque<Result> m_results;
+
+		// Shared with the worker threads
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		std::deque<Job> m_jobs;
+		std::deque<Image> m_images;
+		bool m_quit{ false };
+		std::vector<std::thread> m_threads;
+
+		void worker();
+
+	public:
+		bool load(StringView path, bool mipmap, uint64_t* p_id);
+		void update(double budget);
+		bool popResult(uint64_t* p_id, ITexture2D** pp_texture);
+
+	public:
+		TextureLoadQueue_OpenGL(Device_OpenGL* p_device) : m_device(p_device) {}
+		TextureLoadQueue_OpenGL(TextureLoadQueue_OpenGL const&) = delete;
+		~TextureLoadQueue_OpenGL();
+	};
+}
@@ -231,18 +231,22 @@ namespace Core::Graphics
     {
         // Create a window
 
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1);
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-        SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
-        SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
-        SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
-        SDL_GL_SetAttribute(SDL_GL_ALPHA_SIZE, 8);
-        SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+        bool const opengl = (sdl_window_flags & SDL_WINDOW_OPENGL) != 0;
+        if (opengl)
+        {
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1);
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+            SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
+            SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
+            SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
+            SDL_GL_SetAttribute(SDL_GL_ALPHA_SIZE, 8);
+            SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
 #ifndef NDEBUG
-        spdlog::debug("GL DEBUGGER ENABLED");
-        SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+            spdlog::debug("GL DEBUGGER ENABLED");
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
 #endif
+        }
 
         sdl_window = SDL_CreateWindow(
             sdl_window_text.c_str(),
@@ -257,6 +261,13 @@ namespace Core::Graphics
         }
         m_monitor_idx = SDL_GetWindowDisplayIndex(sdl_window);
 
+        if (!opengl)
+        {
+            // Null graphics device, nothing will ever draw to this window
+            dispatchEvent(EventType::WindowCreate);
+            return true;
+        }
+
         SDL_GLContext context = SDL_GL_CreateContext(sdl_window);
 
         int version = gladLoadGL((GLADloadfunc) SDL_GL_GetProcAddress);
@@ -887,6 +898,8 @@ namespace Core::Graphics
     {
         InitializeConfigure config;
         config.loadFromFile("config.json");
+        if (config.target_graphics_device == "null")
+            sdl_window_flags = SDL_WINDOW_HIDDEN;
         if (!createWindow())
             throw std::runtime_error("createWindow failed");
     }
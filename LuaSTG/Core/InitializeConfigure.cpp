@@ -13,6 +13,10 @@ namespace Core
     #define SET(name) j[#name] = p.name;
 
         SET(target_graphics_device);
+        SET(renderer_batch_vertex_capacity);
+        SET(renderer_batch_index_capacity);
+        SET(renderer_batch_command_capacity);
+        SET(glyph_cache_page_budget);
 
         SET(canvas_width);
         SET(canvas_height);
@@ -25,6 +29,7 @@ namespace Core
         SET(window_cursor_enable);
         
         SET(target_frame_rate);
+        SET(frame_pacing_hybrid_enable);
 
         SET(music_channel_volume);
         SET(sound_effect_channel_volume);
@@ -48,6 +53,10 @@ namespace Core
     #define GET(name) if (j.contains(#name)) { j.at(#name).get_to(p.name); }
 
         GET(target_graphics_device);
+        GET(renderer_batch_vertex_capacity);
+        GET(renderer_batch_index_capacity);
+        GET(renderer_batch_command_capacity);
+        GET(glyph_cache_page_budget);
         
         GET(canvas_width);
         GET(canvas_height);
@@ -60,6 +69,7 @@ namespace Core
         GET(window_cursor_enable);
         
         GET(target_frame_rate);
+        GET(frame_pacing_hybrid_enable);
         
         GET(music_channel_volume);
         GET(sound_effect_channel_volume);
@@ -77,6 +87,15 @@ namespace Core
         GET(debug_track_window_focus);
 
     #undef GET
+
+        // the renderer batch grows by doubling, it can't start from nothing
+        InitializeConfigure const defaults;
+        if (p.renderer_batch_vertex_capacity <= 0)
+            p.renderer_batch_vertex_capacity = defaults.renderer_batch_vertex_capacity;
+        if (p.renderer_batch_index_capacity <= 0)
+            p.renderer_batch_index_capacity = defaults.renderer_batch_index_capacity;
+        if (p.renderer_batch_command_capacity <= 0)
+            p.renderer_batch_command_capacity = defaults.renderer_batch_command_capacity;
     }
 
     inline bool from_file(nlohmann::json& j, std::string_view const path)
@@ -112,6 +131,10 @@ namespace Core
     void InitializeConfigure::reset()
     {
         target_graphics_device.clear();
+        renderer_batch_vertex_capacity = 32768;
+        renderer_batch_index_capacity = 32768;
+        renderer_batch_command_capacity = 2048;
+        glyph_cache_page_budget = 4;
 
         canvas_width = 640;
         canvas_height = 480;
@@ -124,6 +147,7 @@ namespace Core
         window_cursor_enable = true;
 
         target_frame_rate = 60;
+        frame_pacing_hybrid_enable = false;
 
         music_channel_volume = 1.0f;
         sound_effect_channel_volume = 1.0f;
@@ -7,6 +7,10 @@ namespace Core
     struct InitializeConfigure
     {
         std::string target_graphics_device;
+        int renderer_batch_vertex_capacity = 32768;
+        int renderer_batch_index_capacity = 32768;
+        int renderer_batch_command_capacity = 2048;
+        int glyph_cache_page_budget = 4; // 1024x1024 single channel atlas pages per vector font
 
         int canvas_width = 640;
         int canvas_height = 480;
@@ -19,6 +23,7 @@ namespace Core
         bool window_cursor_enable = true;
 
         int target_frame_rate = 60;
+        bool frame_pacing_hybrid_enable = false; // spin the last moment before a frame, costs a core
 
         float music_channel_volume = 1.0f;
         float sound_effect_channel_volume = 1.0f;
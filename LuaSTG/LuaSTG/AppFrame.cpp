@@ -192,6 +192,7 @@ void AppFrame::Shutdown()noexcept
     }
 
     m_stRenderTargetStack.clear();
+    m_AsyncSaveRequest.clear(); // the Lua callbacks went with the Lua state
     m_ResourceMgr.ClearAllResource();
     spdlog::info("[luastg] Resources freed");
     
@@ -308,6 +309,8 @@ bool AppFrame::onUpdate()
         // Run frame function
         imgui::cancelSetCursor();
         m_GameObjectPool->DebugNextFrame();
+        DispatchAsyncSaveCallback();
+        m_ResourceMgr.UpdateAsyncLoad();
         if (!SafeCallGlobalFunction(LuaSTG::LuaEngine::G_CALLBACK_EngineUpdate, 1))
         {
             result = false;
@@ -328,6 +331,7 @@ bool AppFrame::onRender()
 {
     m_bRenderStarted = true;
 
+    UpdateDynamicResolution();
     GetRenderTargetManager()->BeginRenderTargetStack();
 
     // Run render function
@@ -3,6 +3,7 @@
 #include "Core/Graphics/Font.hpp"
 #include "GameResource/ResourceManager.h"
 #include "GameObject/GameObjectPool.h"
+#include <unordered_map>
 
 namespace LuaSTGPlus
 {
@@ -32,6 +33,11 @@ namespace LuaSTGPlus
         // Target framerate
         uint32_t target_fps{ 60 };
 
+        // Dynamic resolution - scale the canvas and auto-size render targets to hold the target framerate
+        bool dynamic_resolution{ false };
+        float dynamic_resolution_min_scale{ 0.5f };
+        float dynamic_resolution_max_scale{ 1.0f };
+
         // Window title
         std::string window_title{ LUASTG_INFO };
 
@@ -114,6 +120,9 @@ namespace LuaSTGPlus
         /// If an error occurs while the script is running, this function is responsible for intercepting the error and issuing an error message.
         /// The caller is responsible for maintaining stack balance.
         bool SafeCallGlobalFunctionB(const char* name, int argc = 0, int retc = 0)noexcept;
+
+        /// Call the Lua callbacks of finished asynchronous saves, callback(success, path)
+        void DispatchAsyncSaveCallback()noexcept;
         
         /// Execute files in package
         /// This function is used by the scripting system
@@ -192,6 +201,12 @@ namespace LuaSTGPlus
         // Get current average FPS
         double GetFPS() const noexcept { return m_fAvgFPS; }
 
+        // Let the render scale follow the frame time, within [min_scale, max_scale]
+        void SetDynamicResolution(bool enable, float min_scale, float max_scale);
+
+        // Current fraction of the canvas size that is rendered
+        float GetRenderScale();
+
         // Read a text file from a resource package.  
         // It is possible to read other files, but you may get meaningless results.
         int LoadTextFile(lua_State* L, const char* path, const char *packname) noexcept;
@@ -215,6 +230,9 @@ namespace LuaSTGPlus
 
         void SnapShot(const char* path)noexcept;
         void SaveTexture(const char* tex_name, const char* path)noexcept;
+        /// Read back on the GPU and write the file on a worker thread, callback is a registry reference (or LUA_NOREF) owned by the request
+        bool SnapShotAsync(const char* path, int callback)noexcept;
+        bool SaveTextureAsync(const char* tex_name, const char* path, int callback)noexcept;
 
         // ---------- Draw common shapes ----------
 
@@ -229,8 +247,26 @@ namespace LuaSTGPlus
     private:
         std::vector<Core::ScopeObject<IResourceTexture>> m_stRenderTargetStack;
         std::set<IResourceTexture*> m_AutoSizeRenderTarget;
-        Core::Vector2U m_AutoSizeRenderTargetSize;
+        struct AsyncSaveRequest
+        {
+            std::string path;
+            int callback;
+        };
+        std::unordered_map<uint64_t, AsyncSaveRequest> m_AsyncSaveRequest;
+        Core::Vector2U m_AutoSizeRenderTargetSize; // logical size, before the render scale
+        struct DynamicResolutionState
+        {
+            double frame_time{}; // smoothed, 0 until the first sample at the current scale
+            uint32_t over_budget_frames{};
+            uint32_t under_budget_frames{};
+            uint32_t cooldown_frames{};
+        } m_DynamicResolution;
     private:
+        // Dynamic resolution
+
+        void UpdateDynamicResolution();
+        float GetRenderTargetViewportScale(IResourceTexture* rt);
+
         // Render target stack
 
         bool BeginRenderTargetStack() override;
@@ -244,8 +280,9 @@ namespace LuaSTGPlus
 
         void AddAutoSizeRenderTarget(IResourceTexture* rt) override;
         void RemoveAutoSizeRenderTarget(IResourceTexture* rt) override;
-        Core::Vector2U GetAutoSizeRenderTargetSize() override;
+        Core::Vector2U GetAutoSizeRenderTargetSize() override; // scaled by the render scale
         bool ResizeAutoSizeRenderTarget(Core::Vector2U size) override;
+        Core::Vector2U GetAutoSizeRenderTargetLogicalSize();
 
     public:
         // Event listener
@@ -185,15 +185,11 @@ namespace LuaSTGPlus
             return false;
         }
 
-        // First, cache all glyphs
+        // First, cache all glyphs, drawText uploads them
         if (!pGlyphManager->cacheString(u8_str))
         {
             //return false; // Ignore unavailable glyphs
         }
-        if (!pGlyphManager->flush())
-        {
-            return false;
-        }
         
         int iLineCount = 1;
         float fLineWidth = 0.f;
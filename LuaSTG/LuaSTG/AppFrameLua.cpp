@@ -107,6 +107,36 @@ namespace LuaSTGPlus
         return true;
     }
     
+    void AppFrame::DispatchAsyncSaveCallback() noexcept
+    {
+        auto* device = GetAppModel()->getDevice();
+        device->updateAsyncSave();
+        Core::Graphics::ImageSaveResult result;
+        while (device->popAsyncSaveResult(&result))
+        {
+            auto it = m_AsyncSaveRequest.find(result.id);
+            if (it == m_AsyncSaveRequest.end())
+                continue;
+            AsyncSaveRequest request = std::move(it->second);
+            m_AsyncSaveRequest.erase(it);
+            if (request.callback == LUA_NOREF)
+                continue;
+            lua_pushcfunction(L, &StackTraceback);                                      // ... trace
+            int tStacktraceIndex = lua_gettop(L);
+            lua_rawgeti(L, LUA_REGISTRYINDEX, request.callback);                        // ... trace f
+            luaL_unref(L, LUA_REGISTRYINDEX, request.callback);
+            lua_pushboolean(L, result.success);                                         // ... trace f success
+            lua_pushlstring(L, request.path.data(), request.path.size());               // ... trace f success path
+            if (0 != lua_pcall(L, 2, 0, tStacktraceIndex))                              // ... trace errmsg
+            {
+                char const* errmsg = lua_tostring(L, -1);
+                spdlog::error("[luajit] Error when calling save callback for '{}':{}", request.path, errmsg ? errmsg : "(error object is a nil value)");
+                lua_pop(L, 1);                                                          // ... trace
+            }
+            lua_pop(L, 1);                                                              // ...
+        }
+    }
+
     bool AppFrame::UnsafeCallGlobalFunction(const char* name, int retc) noexcept
     {
         lua_getglobal(L, name); // ... f
@@ -150,4 +150,49 @@ namespace LuaSTGPlus
             return;
         }
     }
+    bool AppFrame::SnapShotAsync(const char* path, int callback) noexcept
+    {
+        uint64_t id = 0;
+        if (!GetAppModel()->getSwapChain()->saveSnapshotToFileAsync(path, &id))
+        {
+            spdlog::error("[luastg] SnapShot: Failed to save screenshot to '{}'", path);
+            luaL_unref(L, LUA_REGISTRYINDEX, callback);
+            return false;
+        }
+        try
+        {
+            m_AsyncSaveRequest.emplace(id, AsyncSaveRequest{ path, callback });
+        }
+        catch (...)
+        {
+            luaL_unref(L, LUA_REGISTRYINDEX, callback);
+        }
+        return true;
+    }
+    bool AppFrame::SaveTextureAsync(const char* tex_name, const char* path, int callback) noexcept
+    {
+        uint64_t id = 0;
+        Core::ScopeObject<IResourceTexture> resTex = LRES.FindTexture(tex_name);
+        if (!resTex)
+        {
+            spdlog::error("[luastg] SaveTexture: Texture not found: '{}'", tex_name);
+            luaL_unref(L, LUA_REGISTRYINDEX, callback);
+            return false;
+        }
+        if (!resTex->GetTexture()->saveToFileAsync(path, &id))
+        {
+            spdlog::error("[luastg] SaveTexture: Failed to save texture '{}' to '{}'", tex_name, path);
+            luaL_unref(L, LUA_REGISTRYINDEX, callback);
+            return false;
+        }
+        try
+        {
+            m_AsyncSaveRequest.emplace(id, AsyncSaveRequest{ path, callback });
+        }
+        catch (...)
+        {
+            luaL_unref(L, LUA_REGISTRYINDEX, callback);
+        }
+        return true;
+    }
 };
@@ -2,10 +2,19 @@
 
 namespace LuaSTGPlus
 {
+    float AppFrame::GetRenderTargetViewportScale(IResourceTexture* rt)
+    {
+        // Auto-size render targets are allocated at the render scale, but still addressed in canvas units
+        if (!rt || rt->IsAutoResize())
+            return GetAppModel()->getSwapChain()->getRenderScale();
+        return 1.0f;
+    }
+
     bool AppFrame::BeginRenderTargetStack()
     {
         m_stRenderTargetStack.clear();
         GetAppModel()->getSwapChain()->applyRenderAttachment();
+        GetRenderer2D()->setViewportScale(GetRenderTargetViewportScale(nullptr));
         return true;
     }
     bool AppFrame::EndRenderTargetStack()
@@ -16,7 +25,10 @@ namespace LuaSTGPlus
             spdlog::error("[luastg] Rendering finished and rendertarget stack wasn't empty, did you forget to call lstg.PopRenderTarget?");
             m_stRenderTargetStack.clear();
             GetAppModel()->getSwapChain()->applyRenderAttachment();
+            GetRenderer2D()->setViewportScale(GetRenderTargetViewportScale(nullptr));
         }
+        // Transient render targets don't keep their content across frames
+        m_ResourceMgr.GetRenderTargetPool().EndFrame();
         return true;
     }
     bool AppFrame::PushRenderTarget(IResourceTexture* rt)
@@ -32,9 +44,17 @@ namespace LuaSTGPlus
             return false;
         }
 
-        GetRenderer2D()->setRenderAttachment(
-            rt->GetRenderTarget()
-        );
+        // Transient render targets take a texture from the pool here
+        Core::Graphics::IRenderTarget* p_rt = rt->GetRenderTarget();
+        if (!p_rt)
+        {
+            spdlog::error("[luastg] PushRenderTarget: unable to acquire render target '{}'", rt->GetResName());
+            return false;
+        }
+
+        GetRenderer2D()->setRenderAttachment(p_rt);
+        GetRenderer2D()->setViewportScale(GetRenderTargetViewportScale(rt));
+        GetRenderer2D()->beginGpuZone(rt->GetResName());
 
         m_stRenderTargetStack.push_back(rt);
 
@@ -54,6 +74,7 @@ namespace LuaSTGPlus
             return false;
         }
 
+        GetRenderer2D()->endGpuZone();
         m_stRenderTargetStack.pop_back();
 
         if (!m_stRenderTargetStack.empty())
@@ -62,10 +83,12 @@ namespace LuaSTGPlus
             GetRenderer2D()->setRenderAttachment(
                 rt->GetRenderTarget()
             );
+            GetRenderer2D()->setViewportScale(GetRenderTargetViewportScale(rt));
         }
         else
         {
             GetAppModel()->getSwapChain()->applyRenderAttachment();
+            GetRenderer2D()->setViewportScale(GetRenderTargetViewportScale(nullptr));
         }
 
         return true;
@@ -81,6 +104,8 @@ namespace LuaSTGPlus
         if (!m_stRenderTargetStack.empty())
         {
             IResourceTexture* rt = m_stRenderTargetStack.back().get();
+            if (rt->IsAutoResize())
+                return GetAutoSizeRenderTargetLogicalSize();
             return rt->GetTexture()->getSize();
         }
         else
@@ -101,7 +126,7 @@ namespace LuaSTGPlus
         if (m_AutoSizeRenderTarget.contains(rt))
             m_AutoSizeRenderTarget.erase(rt);
     }
-    Core::Vector2U AppFrame::GetAutoSizeRenderTargetSize()
+    Core::Vector2U AppFrame::GetAutoSizeRenderTargetLogicalSize()
     {
         if (m_AutoSizeRenderTargetSize.x == 0 || m_AutoSizeRenderTargetSize.y == 0)
         {
@@ -110,13 +135,18 @@ namespace LuaSTGPlus
         }
         return m_AutoSizeRenderTargetSize;
     }
+    Core::Vector2U AppFrame::GetAutoSizeRenderTargetSize()
+    {
+        return Core::Graphics::getScaledRenderSize(GetAutoSizeRenderTargetLogicalSize(), GetAppModel()->getSwapChain()->getRenderScale());
+    }
     bool AppFrame::ResizeAutoSizeRenderTarget(Core::Vector2U size)
     {
         m_AutoSizeRenderTargetSize = size;
+        Core::Vector2U const render_size = GetAutoSizeRenderTargetSize();
         int failed_count = 0;
         for (auto* rt : m_AutoSizeRenderTarget)
         {
-            if (!rt->ResizeRenderTarget(size))
+            if (!rt->ResizeRenderTarget(render_size))
             {
                 failed_count += 1;
             }
@@ -130,6 +160,96 @@ namespace LuaSTGPlus
     }
     void AppFrame::onSwapChainDestroy() {}
 
+    void AppFrame::SetDynamicResolution(bool enable, float min_scale, float max_scale)
+    {
+        min_scale = std::clamp(min_scale, 0.25f, 1.0f);
+        max_scale = std::clamp(max_scale, min_scale, 1.0f);
+        m_Setting.dynamic_resolution = enable;
+        m_Setting.dynamic_resolution_min_scale = min_scale;
+        m_Setting.dynamic_resolution_max_scale = max_scale;
+        m_DynamicResolution = {};
+        if (!m_pAppModel)
+            return; // applied on the first frame
+        auto* swapchain = GetAppModel()->getSwapChain();
+        if (enable)
+            swapchain->setRenderScale(std::clamp(swapchain->getRenderScale(), min_scale, max_scale));
+        else
+            swapchain->setRenderScale(1.0f);
+    }
+    float AppFrame::GetRenderScale()
+    {
+        if (!m_pAppModel)
+            return 1.0f;
+        return GetAppModel()->getSwapChain()->getRenderScale();
+    }
+    void AppFrame::UpdateDynamicResolution()
+    {
+        // Hysteresis: drop quickly when over budget, climb back slowly once there is clear headroom
+        constexpr double over_budget_ratio = 0.9;
+        constexpr double under_budget_ratio = 0.7;
+        constexpr uint32_t over_budget_frame_count = 8;
+        constexpr uint32_t under_budget_frame_count = 90;
+        constexpr uint32_t cooldown_frame_count = 30;
+        constexpr float scale_down_step = 0.1f;
+        constexpr float scale_up_step = 0.05f;
+
+        if (!m_Setting.dynamic_resolution)
+            return;
+        auto& state = m_DynamicResolution;
+        if (state.cooldown_frames > 0)
+        {
+            // The first frames at a new size pay for the reallocation
+            state.cooldown_frames -= 1;
+            return;
+        }
+
+        // GPU time of the last frame, CPU time when the driver can't measure it; present and
+        // frame rate waiting are left out, with vsync they fill the budget whatever the scale
+        double frame_time = GetAppModel()->getFrameRenderStatistics().render_time;
+        if (frame_time <= 0.0)
+        {
+            auto const statistics = GetAppModel()->getFrameStatistics();
+            frame_time = statistics.update_time + statistics.render_time;
+        }
+        if (frame_time <= 0.0)
+            return;
+        state.frame_time = (state.frame_time > 0.0) ? (state.frame_time * 0.9 + frame_time * 0.1) : frame_time;
+
+        double const budget = 1.0 / (double)m_Setting.target_fps;
+        if (state.frame_time > budget * over_budget_ratio)
+        {
+            state.over_budget_frames += 1;
+            state.under_budget_frames = 0;
+        }
+        else if (state.frame_time < budget * under_budget_ratio)
+        {
+            state.under_budget_frames += 1;
+            state.over_budget_frames = 0;
+        }
+        else
+        {
+            state.over_budget_frames = 0;
+            state.under_budget_frames = 0;
+        }
+
+        auto* swapchain = GetAppModel()->getSwapChain();
+        float const old_scale = swapchain->getRenderScale();
+        float new_scale = old_scale;
+        if (state.over_budget_frames >= over_budget_frame_count)
+            new_scale = old_scale - scale_down_step;
+        else if (state.under_budget_frames >= under_budget_frame_count)
+            new_scale = old_scale + scale_up_step;
+        new_scale = std::clamp(new_scale, m_Setting.dynamic_resolution_min_scale, m_Setting.dynamic_resolution_max_scale);
+        if (new_scale == old_scale)
+            return;
+
+        spdlog::debug("[luastg] Dynamic resolution: {:.2f} -> {:.2f} (frame time {:.2f}ms, budget {:.2f}ms)",
+            old_scale, new_scale, state.frame_time * 1000.0, budget * 1000.0);
+        swapchain->setRenderScale(new_scale); // resizes the auto-size render targets through onSwapChainCreate
+        state = {};
+        state.cooldown_frames = cooldown_frame_count;
+    }
+
     IRenderTargetManager* AppFrame::GetRenderTargetManager()
     {
         return dynamic_cast<IRenderTargetManager*>(this);
@@ -158,7 +278,7 @@ namespace LuaSTGPlus
             // 分割 32 份，圆周上 32 个点以及中心点，共 32 个三角形，需要 32 * 3 个索引
             IRenderer::DrawVertex* vert = nullptr;
             IRenderer::DrawIndex* vidx = nullptr;
-            uint16_t vidx_offset = 0;
+            IRenderer::DrawIndex vidx_offset = 0;
             r2d->drawRequest(32 + 1, 32 * 3, &vert, &vidx, &vidx_offset);
             // 计算顶点
             vert[0] = IRenderer::DrawVertex(x, y, 0.5f, 0.0f, 0.0f, color.color());
@@ -221,7 +341,7 @@ namespace LuaSTGPlus
             // 分割 36 份，椭圆周上 36 个点以及中心点，共 36 个三角形，需要 36 * 3 个索引
             IRenderer::DrawVertex* vert = nullptr;
             IRenderer::DrawIndex* vidx = nullptr;
-            uint16_t vidx_offset = 0;
+            IRenderer::DrawIndex vidx_offset = 0;
             r2d->drawRequest(36 + 1, 36 * 3, &vert, &vidx, &vidx_offset);
             // 计算顶点
             vert[0] = IRenderer::DrawVertex(x, y, 0.5f, 0.0f, 0.0f, color.color());
@@ -433,6 +433,10 @@ static int lib_ShowFrameStatistics(lua_State* L)
                 ImGui::Text("Update : %.3fms", info.update_time  * 1000.0);
                 ImGui::Text("Render : %.3fms", info.render_time  * 1000.0);
                 ImGui::Text("Present: %.3fms", info.present_time * 1000.0);
+                if (LAPP.GetAppModel()->getSwapChain()->isPipelinedPresent())
+                {
+                    ImGui::Text("Present (Overlapped): %.3fms", info.present_overlap_time * 1000.0);
+                }
                 ImGui::Text("Total  : %.3fms", info.total_time   * 1000.0);
             
                 ImGui::SliderFloat("Timeline Height", &height, 256.0f, 512.0f);
@@ -491,6 +495,44 @@ static int lib_ShowFrameStatistics(lua_State* L)
                 }
             }
 
+            // frame pacing
+
+            if (ImGui::CollapsingHeader("Frame Pacing"))
+            {
+                auto* frc = LAPP.GetAppModel()->getFrameRateController();
+                bool hybrid = frc->getFramePacingMode() == Core::FramePacingMode::Hybrid;
+                if (ImGui::Checkbox("Hybrid Sleep/Spin", &hybrid))
+                {
+                    frc->setFramePacingMode(hybrid ? Core::FramePacingMode::Hybrid : Core::FramePacingMode::Sleep);
+                }
+
+                auto const info = frc->getFrameTimeStatistics();
+                ImGui::Text("P50        : %.3fms", info.p50 * 1000.0);
+                ImGui::Text("P99        : %.3fms", info.p99 * 1000.0);
+                ImGui::Text("Max        : %.3fms", info.max * 1000.0);
+                ImGui::Text("Spin Budget: %.3fms", info.spin_budget * 1000.0);
+
+                auto const& histogram = frc->getFrameTimeHistogram();
+                static std::vector<double> arr_bucket_x;
+                static std::vector<double> arr_bucket_y;
+                arr_bucket_x.clear();
+                arr_bucket_y.clear();
+                for (size_t i = 0; i < Core::FrameTimeHistogram::bucket_count; i += 1)
+                {
+                    if (histogram.bucket[i] > 0)
+                    {
+                        arr_bucket_x.push_back(((double)i + 0.5) * Core::FrameTimeHistogram::bucket_width * 1000.0);
+                        arr_bucket_y.push_back((double)histogram.bucket[i]);
+                    }
+                }
+                if (ImPlot::BeginPlot("##Frame Time Histogram", ImVec2(-1, 256.0f), 0))
+                {
+                    ImPlot::SetupAxes("ms", "frames", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+                    ImPlot::PlotBars("Frames", arr_bucket_x.data(), arr_bucket_y.data(), (int)arr_bucket_x.size(), Core::FrameTimeHistogram::bucket_width * 1000.0);
+                    ImPlot::EndPlot();
+                }
+            }
+
             // gpu time
 
             if (ImGui::CollapsingHeader("GPU Time"))
@@ -499,6 +541,12 @@ static int lib_ShowFrameStatistics(lua_State* L)
 
                 ImGui::Text("Render : %.3fms", info.render_time * 1000.0);
 
+                auto const& zones = LAPP.GetAppModel()->getRenderer()->getGpuZones();
+                for (auto const& zone : zones)
+                {
+                    ImGui::Text("%*s%s : %.3fms", (int)(zone.depth * 2), "", zone.name.c_str(), zone.time * 1000.0);
+                }
+
                 ImGui::SliderFloat("Timeline Height##GPU Time", &height_gpu, 256.0f, 512.0f);
                 ImGui::Checkbox("Auto-Fit Y Axis##GPU Time", &auto_fit_gpu);
 
@@ -542,6 +590,32 @@ static int lib_ShowFrameStatistics(lua_State* L)
                 }
             }
 
+            // renderer
+
+            if (ImGui::CollapsingHeader("Renderer"))
+            {
+            #ifdef LUASTG_RENDERER_STATISTICS
+                using FlushCause = Core::Graphics::RendererFrameStatistics::FlushCause;
+                auto info = LAPP.GetAppModel()->getRenderer()->getFrameStatistics();
+
+                ImGui::Text("Flush (Buffer Full) : %llu", info.flush[(size_t)FlushCause::BufferFull]);
+                ImGui::Text("Flush (State Change) : %llu", info.flush[(size_t)FlushCause::StateChange]);
+                ImGui::Text("Flush (Render Target) : %llu", info.flush[(size_t)FlushCause::RenderTarget]);
+                ImGui::Text("Flush (Explicit) : %llu", info.flush[(size_t)FlushCause::Explicit]);
+                ImGui::Text("Draw Call : %llu", info.draw);
+                ImGui::Text("Vertex : %llu", info.vertex);
+                ImGui::Text("Index : %llu", info.index);
+                ImGui::Text("Texture Bind : %llu (%llu skipped)", info.texture_bind, info.texture_bind_skipped);
+                ImGui::Text("Sampler Bind : %llu (%llu skipped)", info.sampler_bind, info.sampler_bind_skipped);
+                ImGui::Text("Program Switch : %llu (%llu skipped)", info.program_switch, info.program_switch_skipped);
+                ImGui::Text("Vertex Array Bind Skipped : %llu", info.vertex_array_bind_skipped);
+                ImGui::Text("Blend State Skipped : %llu", info.blend_state_skipped);
+                ImGui::Text("Post Effect : %llu", info.post_effect);
+            #else
+                ImGui::TextUnformatted("Renderer statistics are not available in release builds");
+            #endif
+            }
+
             // memory
 
             // if (ImGui::CollapsingHeader("Memory Usage"))
@@ -965,6 +1039,13 @@ namespace imgui
         auto* device = APP.GetAppModel()->getDevice();
         auto* L = APP.GetLuaEngine();
         
+        if (device->getNativeRendererHandle() == nullptr)
+        {
+            // Null graphics device, there is nothing to draw the GUI with
+            spdlog::info("[imgui] No renderer available, debug GUI disabled");
+            return;
+        }
+        
         IMGUI_CHECKVERSION();
         ImGui::CreateContext();
         ImPlot::CreateContext();
@@ -986,7 +1067,10 @@ namespace imgui
     }
     void unbindEngine()
     {
-        if (g_ImGuiBindEngine)
+        if (!g_ImGuiBindEngine)
+        {
+            return;
+        }
         {
             auto& io = ImGui::GetIO();
             if (io.WantSaveIniSettings)
@@ -1062,6 +1146,8 @@ namespace imgui
                 // Core::Vector2U csize = LAPP.GetAppModel()->getSwapChain()->getCanvasSize();
                 // ImGui_ImplSDL2_NewFrame((int)wsize.x, (int)wsize.y, (int)csize.x, (int)csize.y);
 
+                // 呈现线程可能仍在读取上一帧的界面纹理
+                ((Core::Graphics::SwapChain_OpenGL*)LAPP.GetAppModel()->getSwapChain())->waitOverlays();
                 glBindTexture(GL_TEXTURE_2D, g_GLTex);
                 glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, LAPP.GetAppModel()->getWindow()->getSize().x, LAPP.GetAppModel()->getWindow()->getSize().y, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
                 ImGui_ImplSDL2_NewFrame();
@@ -1083,6 +1169,7 @@ namespace imgui
             engine.GetAppModel()->getRenderer()->endBatch();
             
             // 绘制GUI数据
+            ((Core::Graphics::SwapChain_OpenGL*)engine.GetAppModel()->getSwapChain())->waitOverlays();
             glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_GLFramebuffer);
             glClearColor(0.f, 0.f, 0.f, 0.f);
             glClear(GL_COLOR_BUFFER_BIT);
@@ -462,10 +462,10 @@ bool GameObjectBentLaser::Render(const char* tex_name, BlendMode blend, Core::Co
 	// 顶点总共需要：节点数 * 2
 	// 索引总共需要：(节点数 - 1) * 3 * 2
 	// 两个节点之间组成一个四边形
-	uint16_t const node_count = (uint16_t)m_Queue.Size();
+	uint32_t const node_count = (uint32_t)m_Queue.Size();
 	IRenderer::DrawVertex* p_vertex = nullptr;
 	IRenderer::DrawIndex* p_index = nullptr;
-	uint16_t index_offset = 0;
+	IRenderer::DrawIndex index_offset = 0;
 	if (!p_renderer->drawRequest(
 		node_count * 2,
 		(node_count - 1) * 6,
@@ -549,7 +549,7 @@ bool GameObjectBentLaser::Render(const char* tex_name, BlendMode blend, Core::Co
 	// |  \ \| |  \ \| |  \ \|
 	// 1<--3 3 3<--5 5 5<--7 7
 	IRenderer::DrawIndex* p_vidx = p_index;
-	uint16_t quad_offset = 0;
+	IRenderer::DrawIndex quad_offset = 0;
 	for (size_t i = 0; i < (node_count - 1u); i += 1)
 	{
 		// 0-2-3
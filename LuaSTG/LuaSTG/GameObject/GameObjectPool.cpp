@@ -354,6 +354,57 @@ namespace LuaSTGPlus
 
         lua_pop(G_L, 1);
     }
+    void GameObjectPool::_RenderObject(int otidx, GameObject* p)
+    {
+        m_pCurrentObject = p;
+    #ifdef USING_ADVANCE_GAMEOBJECT_CLASS
+        if (!p->luaclass.IsDefaultRender)
+        {
+    #endif // USING_ADVANCE_GAMEOBJECT_CLASS
+            _GameObjectCallback(G_L, otidx, p, LGOBJ_CC_RENDER);
+    #ifdef USING_ADVANCE_GAMEOBJECT_CLASS
+        }
+        else
+        {
+            p->Render();
+        }
+    #endif // USING_ADVANCE_GAMEOBJECT_CLASS
+    }
+    static void _GetRenderStateKey(GameObject* p, uint32_t& blend, void const*& texture)
+    {
+        blend = 0;
+        texture = nullptr;
+        if (!p->res)
+            return;
+        switch (p->res->GetType())
+        {
+        case ResourceType::Sprite:
+        {
+            auto* res = static_cast<IResourceSprite*>(p->res);
+            blend = (uint32_t)res->GetBlendMode();
+            texture = res->GetSprite()->getTexture();
+            break;
+        }
+        case ResourceType::Animation:
+        {
+            auto* res = static_cast<IResourceAnimation*>(p->res);
+            blend = (uint32_t)res->GetBlendMode();
+            texture = res->GetSpriteByTimer((int)p->ani_timer)->GetSprite()->getTexture();
+            break;
+        }
+        case ResourceType::Particle:
+            // 一个粒子资源只绑定一个精灵，直接用资源区分
+            blend = p->ps ? (uint32_t)p->ps->GetBlendMode() : 0;
+            texture = p->res;
+            break;
+        default:
+            return;
+        }
+    #ifdef USING_ADVANCE_GAMEOBJECT_CLASS
+        if (p->luaclass.IsRenderClass)
+            blend = (uint32_t)p->blendmode;
+    #endif // USING_ADVANCE_GAMEOBJECT_CLASS
+    }
     void GameObjectPool::DoRender()
     {
         GetObjectTable(G_L); // ot
@@ -364,27 +415,49 @@ namespace LuaSTGPlus
     #ifdef USING_MULTI_GAME_WORLD
         lua_Integer world = GetWorldFlag();
     #endif // USING_MULTI_GAME_WORLD
-        for (auto& p : m_RenderList)
+        auto it = m_RenderList.begin();
+        while (it != m_RenderList.end())
         {
+            lua_Number const layer = (*it)->layer;
+            bool const sorted = !m_StateSortedLayers.empty() && m_StateSortedLayers.contains(layer);
+            if (sorted)
+            {
+                m_RenderSortBuffer.clear();
+            }
+            for (; it != m_RenderList.end() && (*it)->layer == layer; ++it)
+            {
+                GameObject* p = *it;
     #ifdef USING_MULTI_GAME_WORLD
-            if (!p->hide && CheckWorld(p->world, world))  // 只渲染可见对象
+                if (!p->hide && CheckWorld(p->world, world))  // 只渲染可见对象
     #else // USING_MULTI_GAME_WORLD
-            if (!p->hide)  // 只渲染可见对象
+                if (!p->hide)  // 只渲染可见对象
     #endif // USING_MULTI_GAME_WORLD
-            {
-                m_pCurrentObject = p;
-    #ifdef USING_ADVANCE_GAMEOBJECT_CLASS
-                if (!p->luaclass.IsDefaultRender)
                 {
-    #endif // USING_ADVANCE_GAMEOBJECT_CLASS
-                    _GameObjectCallback(G_L, ot_idx, p, LGOBJ_CC_RENDER);
-    #ifdef USING_ADVANCE_GAMEOBJECT_CLASS
+                    if (sorted)
+                    {
+                        _RenderSortItem item{ 0, nullptr, p };
+                        _GetRenderStateKey(p, item.blend, item.texture);
+                        m_RenderSortBuffer.push_back(item);
+                    }
+                    else
+                    {
+                        _RenderObject(ot_idx, p);
+                    }
                 }
-                else
+            }
+            if (sorted)
+            {
+                // 稳定排序，状态相同的对象保持原有的 uid 顺序
+                std::stable_sort(m_RenderSortBuffer.begin(), m_RenderSortBuffer.end(), [](_RenderSortItem const& a, _RenderSortItem const& b) -> bool
                 {
-                    p->Render();
+                    if (a.blend != b.blend)
+                        return a.blend < b.blend;
+                    return std::less<void const*>()(a.texture, b.texture);
+                });
+                for (auto& item : m_RenderSortBuffer)
+                {
+                    _RenderObject(ot_idx, item.object);
                 }
-    #endif // USING_ADVANCE_GAMEOBJECT_CLASS
             }
         }
         m_pCurrentObject = nullptr;
@@ -392,6 +465,13 @@ namespace LuaSTGPlus
 
         lua_pop(G_L, 1);
     }
+    void GameObjectPool::SetLayerStateSorting(lua_Number layer, bool enable)
+    {
+        if (enable)
+            m_StateSortedLayers.insert(layer);
+        else
+            m_StateSortedLayers.erase(layer);
+    }
     void GameObjectPool::BoundCheck()
     {
         ZoneScopedN("LOBJMGR.BoundCheck");
@@ -39,6 +39,15 @@ namespace LuaSTGPlus
             }
         };
         std::set<GameObject*, _less_render> m_RenderList;
+        // 开启状态排序的图层，图层内对象按 (混合模式, 纹理) 稳定排序后渲染
+        struct _RenderSortItem
+        {
+            uint32_t blend;
+            void const* texture;
+            GameObject* object;
+        };
+        std::set<lua_Number> m_StateSortedLayers;
+        std::vector<_RenderSortItem> m_RenderSortBuffer;
         std::pair<GameObject, GameObject> m_UpdateLinkList;
         std::array<std::pair<GameObject, GameObject>, LOBJPOOL_GROUPN> m_ColliLinkList = {};
 
@@ -92,6 +101,7 @@ namespace LuaSTGPlus
         GameObject* _TableToGameObject(lua_State* L, int idx);
 
         void _GameObjectCallback(lua_State* L, int otidx, GameObject* p, int cbidx);
+        void _RenderObject(int otidx, GameObject* p);
 
     public:
         void DebugNextFrame();
@@ -117,6 +127,13 @@ namespace LuaSTGPlus
         /// @brief 执行对象的Render函数
         void DoRender();
         
+        /// @brief 设置图层内的对象是否按渲染状态 (混合模式, 纹理) 排序，用于减少批次
+        /// @note 只应该用于绘制顺序无关紧要的图层，例如加法混合的子弹
+        void SetLayerStateSorting(lua_Number layer, bool enable);
+        
+        /// @brief 获取图层是否按渲染状态排序
+        bool GetLayerStateSorting(lua_Number layer) const noexcept { return m_StateSortedLayers.contains(layer); }
+        
         // TODO: double -> float ???
         /// @brief 获取舞台边界
         Core::RectF GetBound() noexcept
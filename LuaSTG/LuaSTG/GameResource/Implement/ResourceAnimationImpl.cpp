@@ -1,5 +1,6 @@
 #include "GameResource/Implement/ResourceAnimationImpl.hpp"
 #include "GameResource/Implement/ResourceSpriteImpl.hpp"
+#include "GameResource/TextureAtlas.hpp"
 #include "AppFrame.h"
 
 namespace LuaSTGPlus
@@ -16,7 +17,11 @@ namespace LuaSTGPlus
 		, m_bRectangle(rect)
 		, m_is_sprite_cloned(true)
 	{
-		// 分割纹理
+		// 分割纹理，整张网格都在原纹理内时使用图集页面
+		Core::RectF rc_all(x, y, x + w * n, y + h * m);
+		Core::Graphics::ITexture2D* p_texture = TextureAtlas::MapTextureRect(tex.get(), rc_all);
+		x = rc_all.a.x;
+		y = rc_all.a.y;
 		m_sprites.reserve(m * n);
 		for (int j = 0; j < m; ++j)  // 行
 		{
@@ -25,7 +30,7 @@ namespace LuaSTGPlus
 				Core::ScopeObject<Core::Graphics::ISprite> p_sprite_core;
 				if (!Core::Graphics::ISprite::create(
 					LAPP.GetAppModel()->getRenderer(),
-					tex->GetTexture(),
+					p_texture,
 					~p_sprite_core
 				))
 				{
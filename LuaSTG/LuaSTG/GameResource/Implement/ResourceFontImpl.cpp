@@ -286,6 +286,9 @@ namespace LuaSTGPlus
 			return false;
 		}
 
+		bool isEvictionPending() { return false; }
+		Core::Graphics::GlyphCacheStatistics getCacheStatistics() { return {}; }
+
 	public:
 		hgeFont(std::string_view path, bool mipmap)
 			: m_line_height(0.0f)
@@ -455,6 +458,9 @@ namespace LuaSTGPlus
 			return false;
 		}
 
+		bool isEvictionPending() { return false; }
+		Core::Graphics::GlyphCacheStatistics getCacheStatistics() { return {}; }
+
 	public:
 		f2dFont(std::string_view path, std::string_view raw_texture_path, bool mipmap)
 			: m_line_height(0.0f)
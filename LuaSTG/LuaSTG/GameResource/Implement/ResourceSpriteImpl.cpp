@@ -34,7 +34,7 @@ namespace LuaSTGPlus
 		pSprite->setZ(z);
 		// 渲染
 		LAPP.updateGraph2DBlendMode(GetBlendMode());
-		pSprite->draw(Core::Vector2F(x, y), Core::Vector2F(hscale, vscale), rot);
+		pSprite->drawInstance(Core::Vector2F(x, y), Core::Vector2F(hscale, vscale), rot);
 		// 恢复状态
 		pSprite->setZ(z_backup);
 	}
@@ -1,10 +1,46 @@
 #include "GameResource/Implement/ResourceTextureImpl.hpp"
 #include "AppFrame.h"
+#include <algorithm>
 
 namespace LuaSTGPlus
 {
+	bool ResourceTextureImpl::AcquireTransient()
+	{
+		if (m_rt)
+		{
+			return true;
+		}
+		Core::Vector2U size = m_transient_size;
+		if (size.x == 0 || size.y == 0)
+		{
+			size = LAPP.GetRenderTargetManager()->GetAutoSizeRenderTargetSize();
+		}
+		if (!LRES.GetRenderTargetPool().Acquire(this, size, ~m_rt))
+		{
+			return false;
+		}
+		m_texture = m_rt->getTexture();
+		return true;
+	}
+	void ResourceTextureImpl::ReleaseTransient()
+	{
+		if (m_is_transient && m_rt)
+		{
+			LRES.GetRenderTargetPool().Release(m_rt.get());
+			m_rt.reset();
+			m_texture.reset();
+		}
+	}
+
 	bool ResourceTextureImpl::ResizeRenderTarget(Core::Vector2U size)
 	{
+		if (m_is_transient)
+		{
+			// 下次使用时按新尺寸取得
+			m_transient_size = size;
+			ReleaseTransient();
+			return true;
+		}
 		if (!m_rt)
 		{
 			if (!LAPP.GetAppModel()->getDevice()->createRenderTarget(size, ~m_rt))
@@ -66,8 +102,19 @@ namespace LuaSTGPlus
 		}
 		LAPP.GetRenderTargetManager()->AddAutoSizeRenderTarget(this);
 	}
+	// 临时渲染附件容器
+	ResourceTextureImpl::ResourceTextureImpl(const char* name, int w, int h, bool transient)
+		: ResourceBaseImpl(ResourceType::Texture, name)
+		, m_transient_size((uint32_t)std::max(w, 0), (uint32_t)std::max(h, 0))
+		, m_is_rendertarget(true)
+		, m_is_auto_resize(false)
+		, m_is_transient(transient)
+	{
+		assert(transient);
+	}
 	ResourceTextureImpl::~ResourceTextureImpl()
 	{
+		ReleaseTransient();
 		if (m_is_auto_resize)
 			LAPP.GetRenderTargetManager()->RemoveAutoSizeRenderTarget(this);
 	}
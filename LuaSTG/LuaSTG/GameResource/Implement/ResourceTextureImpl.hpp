@@ -9,18 +9,31 @@ namespace LuaSTGPlus
 	private:
 		Core::ScopeObject<Core::Graphics::ITexture2D> m_texture;
 		Core::ScopeObject<Core::Graphics::IRenderTarget> m_rt;
+		Core::ScopeObject<Core::Graphics::ITexture2D> m_atlas_page;
+		Core::Vector2U m_atlas_offset;
 		// Core::ScopeObject<Core::Graphics::IDepthStencilBuffer> m_ds;
+		Core::Vector2U m_transient_size; // 为 0 时跟随自动调整大小的渲染附件
 		bool m_is_rendertarget{ false };
 		bool m_is_auto_resize{ false };
+		bool m_is_transient{ false };
 		bool m_enable_depthbuffer{ false };
+	private:
+		bool AcquireTransient();
 	public:
 		bool ResizeRenderTarget(Core::Vector2U size);
 	public:
-		Core::Graphics::ITexture2D* GetTexture() { return m_texture.get(); }
-		Core::Graphics::IRenderTarget* GetRenderTarget() { return m_rt.get(); }
+		Core::Graphics::ITexture2D* GetTexture() { if (m_is_transient) AcquireTransient(); return m_texture.get(); }
+		Core::Graphics::IRenderTarget* GetRenderTarget() { if (m_is_transient) AcquireTransient(); return m_rt.get(); }
 		// Core::Graphics::IDepthStencilBuffer* GetDepthStencilBuffer() { return m_ds.get(); }
 		bool IsRenderTarget() { return m_is_rendertarget; }
-		bool HasDepthStencilBuffer() { return m_rt->DepthStencilBufferEnabled(); }
+		bool HasDepthStencilBuffer() { return GetRenderTarget()->DepthStencilBufferEnabled(); }
+		bool IsAutoResize() { return m_is_auto_resize || (m_is_transient && (m_transient_size.x == 0 || m_transient_size.y == 0)); }
+		bool IsTransient() { return m_is_transient; }
+		bool IsTransientAcquired() { return m_is_transient && m_rt; }
+		void ReleaseTransient();
+		Core::Graphics::ITexture2D* GetAtlasTexture() { return m_atlas_page.get(); }
+		Core::Vector2U GetAtlasOffset() { return m_atlas_offset; }
+		void SetAtlasRegion(Core::Graphics::ITexture2D* p_page, Core::Vector2U offset) { m_atlas_page = p_page; m_atlas_offset = offset; }
 	public:
 		// 纹理容器
 		ResourceTextureImpl(const char* name, Core::Graphics::ITexture2D* p_texture);
@@ -28,6 +41,8 @@ namespace LuaSTGPlus
 		ResourceTextureImpl(const char* name, int w, int h);
 		// 自动调整大小的渲染附件容器
 		ResourceTextureImpl(const char* name);
+		// 临时渲染附件容器，宽高为 0 时自动调整大小
+		ResourceTextureImpl(const char* name, int w, int h, bool transient);
 		~ResourceTextureImpl();
 	};
 }
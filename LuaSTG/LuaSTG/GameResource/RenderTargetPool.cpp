@@ -0,0 +1,101 @@
+#include "GameResource/RenderTargetPool.hpp"
+#include "AppFrame.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+namespace LuaSTGPlus
+{
+	bool RenderTargetPool::Acquire(IResourceTexture* p_owner, Core::Vector2U size, Core::Graphics::IRenderTarget** pp_rt) noexcept
+	{
+		assert(p_owner && pp_rt);
+		for (auto& v : m_entries)
+		{
+			if (!v.owner && v.size == size)
+			{
+				v.owner = p_owner;
+				v.idle_frames = 0;
+				m_in_use += 1;
+				m_peak_in_use = std::max(m_peak_in_use, m_in_use);
+				*pp_rt = v.rt.get();
+				v.rt->retain();
+				return true;
+			}
+		}
+
+		Entry entry;
+		if (!LAPP.GetAppModel()->getDevice()->createRenderTarget(size, ~entry.rt))
+		{
+			spdlog::error("[luastg] RenderTargetPool: Failed to create render target ({}x{})", size.x, size.y);
+			return false;
+		}
+		entry.size = size;
+		entry.owner = p_owner;
+		try
+		{
+			m_entries.emplace_back(std::move(entry));
+		}
+		catch (...)
+		{
+			return false;
+		}
+		m_created += 1;
+		m_in_use += 1;
+		m_peak_in_use = std::max(m_peak_in_use, m_in_use);
+		*pp_rt = m_entries.back().rt.get();
+		m_entries.back().rt->retain();
+		return true;
+	}
+	void RenderTargetPool::Release(Core::Graphics::IRenderTarget* p_rt) noexcept
+	{
+		for (auto& v : m_entries)
+		{
+			if (v.rt.get() == p_rt && v.owner)
+			{
+				v.owner = nullptr;
+				m_in_use -= 1;
+				return;
+			}
+		}
+	}
+	void RenderTargetPool::EndFrame() noexcept
+	{
+		// 临时渲染目标的内容不会保留到下一帧
+		for (auto& v : m_entries)
+		{
+			if (v.owner)
+			{
+				v.owner->ReleaseTransient(); // 会调用 Release
+			}
+		}
+		assert(m_in_use == 0);
+		for (auto& v : m_entries)
+		{
+			v.idle_frames += 1;
+		}
+		std::erase_if(m_entries, [](Entry const& v) { return v.idle_frames > max_idle_frames; });
+		m_last_peak_in_use = m_peak_in_use;
+		m_peak_in_use = 0;
+	}
+	void RenderTargetPool::Clear() noexcept
+	{
+		for (auto& v : m_entries)
+		{
+			if (v.owner)
+			{
+				v.owner->ReleaseTransient();
+			}
+		}
+		m_entries.clear();
+		m_in_use = 0;
+	}
+
+	uint64_t RenderTargetPool::GetMemoryUsage() const noexcept
+	{
+		uint64_t total = 0;
+		for (auto const& v : m_entries)
+		{
+			total += (uint64_t)v.size.x * (uint64_t)v.size.y * bytes_per_pixel;
+		}
+		return total;
+	}
+}
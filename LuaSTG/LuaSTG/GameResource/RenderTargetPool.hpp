@@ -0,0 +1,43 @@
+#pragma once
+#include "GameResource/ResourceTexture.hpp"
+#include <vector>
+
+namespace LuaSTGPlus
+{
+	// 临时渲染目标池，按尺寸复用渲染目标
+	// 临时渲染目标在使用时从池中取得渲染目标，归还后同一帧内就可以被其他临时渲染目标复用
+	class RenderTargetPool
+	{
+	public:
+		static constexpr uint32_t max_idle_frames = 120; // 连续闲置超过这么多帧的渲染目标会被销毁
+		static constexpr uint32_t bytes_per_pixel = 8; // RGBA8 颜色 + D24S8 深度模板
+
+		struct Entry
+		{
+			Core::ScopeObject<Core::Graphics::IRenderTarget> rt;
+			Core::Vector2U size;
+			IResourceTexture* owner{ nullptr }; // 正在使用的临时渲染目标，空闲时为 nullptr
+			uint32_t idle_frames{ 0 };
+		};
+	private:
+		std::vector<Entry> m_entries;
+		uint32_t m_in_use{ 0 };
+		uint32_t m_peak_in_use{ 0 };
+		uint32_t m_last_peak_in_use{ 0 };
+		uint32_t m_created{ 0 }; // 累计创建次数，持续增长说明复用失败
+	public:
+		// 取得一个指定尺寸的空闲渲染目标，没有时创建
+		bool Acquire(IResourceTexture* p_owner, Core::Vector2U size, Core::Graphics::IRenderTarget** pp_rt) noexcept;
+		// 归还渲染目标，内容在下次被取得前保持不变
+		void Release(Core::Graphics::IRenderTarget* p_rt) noexcept;
+		// 一帧结束，归还所有仍在使用的渲染目标并销毁长时间闲置的渲染目标
+		void EndFrame() noexcept;
+		void Clear() noexcept;
+
+		std::vector<Entry> const& GetEntries() const noexcept { return m_entries; }
+		uint32_t GetInUseCount() const noexcept { return m_in_use; }
+		uint32_t GetPeakInUseCount() const noexcept { return m_last_peak_in_use; }
+		uint32_t GetCreatedCount() const noexcept { return m_created; }
+		uint64_t GetMemoryUsage() const noexcept;
+	};
+}
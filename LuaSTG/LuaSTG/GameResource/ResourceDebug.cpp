@@ -1,4 +1,5 @@
 ﻿#include "GameResource/ResourceManager.h"
+#include "Core/Graphics/TextureImage.hpp"
 #ifdef USING_DEAR_IMGUI
 #include "imgui.h"
 #endif
@@ -26,6 +27,32 @@ static std::string bytes_count_to_string(unsigned long long size)
 	return std::string(buffer, count);
 }
 
+static char const* format_to_string(Core::Graphics::Format format)
+{
+	switch (format)
+	{
+	case Core::Graphics::Format::R8_UNORM: return "R8";
+	case Core::Graphics::Format::R8G8B8A8_UNORM: return "RGBA8";
+	case Core::Graphics::Format::B8G8R8A8_UNORM: return "BGRA8";
+	case Core::Graphics::Format::BC1_UNORM: return "BC1";
+	case Core::Graphics::Format::BC3_UNORM: return "BC3";
+	case Core::Graphics::Format::BC7_UNORM: return "BC7";
+	default: return "Unknown";
+	}
+}
+
+// 同样的纹理以 RGBA8 储存时的显存占用
+static unsigned long long rgba8_memory_usage(Core::Graphics::ITexture2D* p_tex)
+{
+	auto const block = Core::Vector2U(4, 4);
+	auto const format_size = Core::Graphics::getLevelSizeInBytes(p_tex->getFormat(), block);
+	if (format_size == 0)
+	{
+		return p_tex->getMemoryUsage();
+	}
+	return (unsigned long long)p_tex->getMemoryUsage() * Core::Graphics::getLevelSizeInBytes(Core::Graphics::Format::R8G8B8A8_UNORM, block) / format_size;
+}
+
 namespace LuaSTGPlus
 {
 	void ResourceMgr::ShowResourceManagerDebugWindow(bool* p_open)
@@ -85,10 +112,21 @@ namespace LuaSTGPlus
 				if (show_info)
 				{
 					ImGui::Text("Size: %u x %u", size.x, size.y);
+					ImGui::Text("Format: %s", format_to_string(p_res->GetTexture()->getFormat()));
 					ImGui::Text("RenderTarget: %s", p_res->IsRenderTarget() ? "Yes" : "Not");
 					ImGui::Text("Dynamic: %s", p_res->IsRenderTarget() ? "Yes" : "Not");
-					unsigned long long mem_usage = size.x * size.y * 4;
+					unsigned long long mem_usage = p_res->GetTexture()->getMemoryUsage();
 					ImGui::Text("Adapter Memory Usage (Approximate): %s", bytes_count_to_string(mem_usage).c_str());
+					unsigned long long const rgba8_mem_usage = rgba8_memory_usage(p_res->GetTexture());
+					if (rgba8_mem_usage > mem_usage)
+					{
+						ImGui::Text("Saved Compared To RGBA8: %s", bytes_count_to_string(rgba8_mem_usage - mem_usage).c_str());
+					}
+					if (p_res->GetAtlasTexture())
+					{
+						auto const offset = p_res->GetAtlasOffset();
+						ImGui::Text("Atlas: %p at (%u, %u)", p_res->GetAtlasTexture()->getNativeHandle(), offset.x, offset.y);
+					}
 				}
 				ImGui::Image(
 					p_res->GetTexture()->getNativeHandle(),
@@ -131,9 +169,20 @@ namespace LuaSTGPlus
 					if (ImGui::BeginTabItem("Texture"))
 					{
 						static unsigned long long total_texture_memory_usage = 0;
+						unsigned long long total_texture_memory_saved = 0;
+						for (auto& v : p_pool->m_TexturePool)
+						{
+							// 临时渲染目标不是块压缩格式，也不要在这里取得
+							if (!v.second->IsTransient())
+							{
+								auto* p_res = v.second->GetTexture();
+								total_texture_memory_saved += rgba8_memory_usage(p_res) - p_res->getMemoryUsage();
+							}
+						}
 
 						ImGui::Text("Total Resources: %u", p_pool->m_TexturePool.size());
 						ImGui::Text("Total Adapter Memory Usage (Approximate): %s", bytes_count_to_string(total_texture_memory_usage).c_str());
+						ImGui::Text("Saved By Block Compression: %s", bytes_count_to_string(total_texture_memory_saved).c_str());
 
 						total_texture_memory_usage = 0;
 
@@ -145,13 +194,21 @@ namespace LuaSTGPlus
 						{
 							if (filter.PassFilter(v.second->GetResName().data()))
 							{
+								// 未取得纹理的临时渲染目标不占用显存，也不要在这里取得
+								if (v.second->IsTransient() && !v.second->IsTransientAcquired())
+								{
+									ImGui::BulletText("%d. %s (transient, not acquired)", res_i, v.second->GetResName().data());
+									res_i += 1;
+									continue;
+								}
 								auto* p_res = v.second->GetTexture();
-								auto const p_tex_size = p_res->getSize();
-								unsigned long long mem_usage = p_tex_size.x * p_tex_size.y * 4;
+								// 临时渲染目标的显存计入渲染目标池
+								unsigned long long mem_usage = v.second->IsTransient() ? 0 : p_res->getMemoryUsage();
 								if (ImGui::TreeNode(*v.second,
-									"%d. %s",
+									"%d. %s%s",
 									res_i,
-									v.second->GetResName().data()
+									v.second->GetResName().data(),
+									v.second->IsTransient() ? " (transient)" : ""
 								))
 								{
 									static float preview_scale = 1.0f;
@@ -167,6 +224,63 @@ namespace LuaSTGPlus
 						ImGui::EndTabItem();
 					}
 
+					if (ImGui::BeginTabItem("Texture Atlas"))
+					{
+						auto const& pages = p_pool->m_TextureAtlas.GetPages();
+						ImGui::Text("Enable: %s (max texture size %u)", GetTextureAtlasEnable() ? "Yes" : "Not", GetTextureAtlasMaxSize());
+						ImGui::Text("Total Pages: %u", (unsigned int)pages.size());
+
+						static float preview_scale = 0.25f;
+						draw_preview_scaling(preview_scale);
+
+						int page_i = 0;
+						for (auto const& page : pages)
+						{
+							double const page_area = (double)TextureAtlas::page_size * (double)TextureAtlas::page_size;
+							if (ImGui::TreeNode(&page,
+								"%d. %u textures, %.1f%% used",
+								page_i,
+								page.texture_count,
+								100.0 * (double)page.used_area / page_area
+							))
+							{
+								ImGui::Text("Skyline Nodes: %u", (unsigned int)page.skyline.size());
+								draw_texture0(page.texture.get(), preview_scale);
+								ImGui::TreePop();
+							}
+							page_i += 1;
+						}
+
+						ImGui::EndTabItem();
+					}
+
+					if (ImGui::BeginTabItem("Render Target Pool"))
+					{
+						// 渲染目标池由全局和关卡资源池共用
+						auto const& rt_pool = GetRenderTargetPool();
+						auto const& entries = rt_pool.GetEntries();
+						ImGui::Text("Total Render Targets: %u", (unsigned int)entries.size());
+						ImGui::Text("In Use: %u (last frame peak %u)", rt_pool.GetInUseCount(), rt_pool.GetPeakInUseCount());
+						ImGui::Text("Created: %u", rt_pool.GetCreatedCount());
+						ImGui::Text("Total Adapter Memory Usage (Approximate): %s", bytes_count_to_string(rt_pool.GetMemoryUsage()).c_str());
+
+						int entry_i = 0;
+						for (auto const& entry : entries)
+						{
+							if (entry.owner)
+							{
+								ImGui::BulletText("%d. %u x %u, used by %s", entry_i, entry.size.x, entry.size.y, entry.owner->GetResName().data());
+							}
+							else
+							{
+								ImGui::BulletText("%d. %u x %u, free (idle %u frames)", entry_i, entry.size.x, entry.size.y, entry.idle_frames);
+							}
+							entry_i += 1;
+						}
+
+						ImGui::EndTabItem();
+					}
+
 					if (ImGui::BeginTabItem("Sprite"))
 					{
 						ImGui::Text("Total Resources: %u", p_pool->m_SpritePool.size());
@@ -395,9 +509,18 @@ namespace LuaSTGPlus
 
 									ImGui::Text("Size: %u x %u (x %u)", p_tex0->getSize().x, p_tex0->getSize().y, mgr->getTextureCount());
 									ImGui::Text("Dynamic: Yes");
-									unsigned long long mem_usage = p_tex0->getSize().x * p_tex0->getSize().y * 4 * mgr->getTextureCount();
-									ImGui::Text("Memory Usage (Approximate): %s", bytes_count_to_string(mem_usage).c_str());
-									ImGui::Text("Adapter Memory Usage (Approximate): %s", bytes_count_to_string(mem_usage).c_str());
+									ImGui::Text("Format: %s", format_to_string(p_tex0->getFormat()));
+									auto const stats = mgr->getCacheStatistics();
+									unsigned long long adapter_mem_usage = 0;
+									for (uint32_t tidx = 0; tidx < mgr->getTextureCount(); tidx += 1)
+									{
+										adapter_mem_usage += mgr->getTexture(tidx)->getMemoryUsage();
+									}
+									ImGui::Text("Memory Usage: %s", bytes_count_to_string(stats.memory_usage).c_str());
+									ImGui::Text("Adapter Memory Usage: %s", bytes_count_to_string(adapter_mem_usage).c_str());
+									ImGui::Text("Pages: %u / %u", stats.page_count, stats.page_budget);
+									ImGui::Text("Glyph Cache: %llu hit, %llu miss, %llu evicted",
+										(unsigned long long)stats.hit, (unsigned long long)stats.miss, (unsigned long long)stats.eviction);
 
 									static float preview_scale = 1.0f;
 									draw_preview_scaling(preview_scale);
@@ -1,4 +1,5 @@
 ﻿#include "GameResource/ResourceManager.h"
+#include "AppFrame.h"
 
 namespace LuaSTGPlus
 {
@@ -13,10 +14,76 @@ namespace LuaSTGPlus
 	void ResourceMgr::ClearAllResource() noexcept {
 		m_GlobalResourcePool.Clear();
 		m_StageResourcePool.Clear();
+		m_RenderTargetPool.Clear();
 		m_ActivedPool = ResourcePoolType::Global;
 		m_GlobalImageScaleFactor = 1.0f;
 	}
 
+	// 异步加载
+
+	bool ResourceMgr::AddAsyncTextureLoad(ResourcePoolType t, uint64_t id, const char* name, const char* path) noexcept {
+		try {
+			if (m_AsyncTextureLoad.empty()) {
+				// 新一轮加载
+				m_AsyncLoadTotal = 0;
+				m_AsyncLoadDone = 0;
+				m_AsyncLoadFailed = 0;
+			}
+			m_AsyncTextureLoad.emplace(id, AsyncTextureLoad{ t, GetResourcePool(t)->m_ClearCount, name, path });
+			m_AsyncLoadTotal += 1;
+			return true;
+		}
+		catch (...) {
+			return false;
+		}
+	}
+
+	bool ResourceMgr::IsAsyncTextureLoadPending(ResourcePoolType t, std::string_view name) const noexcept {
+		for (auto const& [id, v] : m_AsyncTextureLoad) {
+			if (v.pool == t && v.name == name)
+				return true;
+		}
+		return false;
+	}
+
+	void ResourceMgr::UpdateAsyncLoad() noexcept {
+		auto* device = LAPP.GetAppModel()->getDevice();
+		device->updateAsyncTextureLoad(m_AsyncLoadBudget);
+		uint64_t id = 0;
+		Core::ScopeObject<Core::Graphics::ITexture2D> p_texture;
+		while (device->popAsyncTextureLoadResult(&id, ~p_texture)) {
+			auto it = m_AsyncTextureLoad.find(id);
+			if (it == m_AsyncTextureLoad.end())
+				continue;
+			AsyncTextureLoad const& v = it->second;
+			ResourcePool* pool = GetResourcePool(v.pool);
+			bool success = false;
+			if (!p_texture) {
+				spdlog::error("[luastg] Failed to create texture '{}' from '{}'", v.name, v.path);
+			}
+			else if (pool->m_ClearCount != v.pool_clear_count) {
+				// 资源池在加载期间被清空，丢弃
+				success = true;
+			}
+			else if (pool->insertTexture(v.name.c_str(), p_texture.get())) {
+				success = true;
+				if (ResourceMgr::GetResourceLoadingLog()) {
+					spdlog::info("[luastg] LoadTexture: path '{}', name '{}' ({})", v.path, v.name, pool->getResourcePoolTypeName());
+				}
+			}
+			m_AsyncLoadDone += 1;
+			if (!success)
+				m_AsyncLoadFailed += 1;
+			m_AsyncTextureLoad.erase(it);
+		}
+	}
+
+	void ResourceMgr::GetAsyncLoadProgress(uint32_t& done, uint32_t& total, uint32_t& failed) const noexcept {
+		done = m_AsyncLoadDone;
+		total = m_AsyncLoadTotal;
+		failed = m_AsyncLoadFailed;
+	}
+
 	ResourcePoolType ResourceMgr::GetActivedPoolType() noexcept {
 		return m_ActivedPool;
 	}
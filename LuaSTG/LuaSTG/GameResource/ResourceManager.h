@@ -8,6 +8,8 @@
 #include "GameResource/ResourceFont.hpp"
 #include "GameResource/ResourcePostEffectShader.hpp"
 #include "GameResource/ResourceModel.hpp"
+#include "GameResource/TextureAtlas.hpp"
+#include "GameResource/RenderTargetPool.hpp"
 #include "lua.hpp"
 #include "xxhash.h"
 
@@ -86,8 +88,12 @@ namespace LuaSTGPlus
         dictionary_t<Core::ScopeObject<IResourceFont>> m_TTFFontPool;
         dictionary_t<Core::ScopeObject<IResourcePostEffectShader>> m_FXPool;
         dictionary_t<Core::ScopeObject<IResourceModel>> m_ModelPool;
+        TextureAtlas m_TextureAtlas;
+        uint32_t m_ClearCount = 0; // 异步加载完成时用来判断资源池是否已经被清空过
     private:
         const char* getResourcePoolTypeName();
+        void packTexture(IResourceTexture* p_res) noexcept;
+        bool insertTexture(const char* name, Core::Graphics::ITexture2D* p_texture) noexcept;
     public:
         void Clear() noexcept;
         void RemoveResource(ResourceType t, const char* name) noexcept;
@@ -97,9 +103,11 @@ namespace LuaSTGPlus
         // 纹理
         bool LoadTexture(const char* name, const char* path, bool mipmaps = true) noexcept;
         bool LoadTextureBin(const char* name, std::vector<uint8_t> data, bool mipmaps = true) noexcept;
+        // 异步加载：解码完成并创建纹理后才会出现在资源池中，见 ResourceMgr::GetAsyncLoadProgress
+        bool LoadTextureAsync(const char* name, const char* path, bool mipmaps = true) noexcept;
         bool CreateTexture(const char* name, int width, int height) noexcept;
         // 渲染目标
-        bool CreateRenderTarget(const char* name, int width = 0, int height = 0, bool depth_buffer = false) noexcept;
+        bool CreateRenderTarget(const char* name, int width = 0, int height = 0, bool depth_buffer = false, bool transient = false) noexcept;
         // 图片精灵
         bool CreateSprite(const char* name, const char* texname,
                           double x, double y, double w, double h,
@@ -154,6 +162,7 @@ namespace LuaSTGPlus
     {
     private:
         ResourcePoolType m_ActivedPool = ResourcePoolType::Global;
+        RenderTargetPool m_RenderTargetPool; // 在资源池之后析构，临时渲染目标析构时会归还渲染目标
         ResourcePool m_GlobalResourcePool;
         ResourcePool m_StageResourcePool;
     public:
@@ -161,7 +170,30 @@ namespace LuaSTGPlus
         void SetActivedPoolType(ResourcePoolType t) noexcept;
         ResourcePool* GetActivedPool() noexcept;
         ResourcePool* GetResourcePool(ResourcePoolType t) noexcept;
+        RenderTargetPool& GetRenderTargetPool() noexcept { return m_RenderTargetPool; }
         void ClearAllResource() noexcept;
+    private:
+        struct AsyncTextureLoad
+        {
+            ResourcePoolType pool;
+            uint32_t pool_clear_count;
+            std::string name;
+            std::string path;
+        };
+        std::unordered_map<uint64_t, AsyncTextureLoad> m_AsyncTextureLoad;
+        uint32_t m_AsyncLoadTotal = 0;
+        uint32_t m_AsyncLoadDone = 0;
+        uint32_t m_AsyncLoadFailed = 0;
+        double m_AsyncLoadBudget = 0.004;
+    public:
+        // 异步加载
+        bool AddAsyncTextureLoad(ResourcePoolType t, uint64_t id, const char* name, const char* path) noexcept;
+        bool IsAsyncTextureLoadPending(ResourcePoolType t, std::string_view name) const noexcept;
+        // 每帧调用，在预算时间内创建解码完成的纹理
+        void UpdateAsyncLoad() noexcept;
+        // 上次所有异步加载完成以来的进度，done 包含失败的数量
+        void GetAsyncLoadProgress(uint32_t& done, uint32_t& total, uint32_t& failed) const noexcept;
+        void SetAsyncLoadBudget(double seconds) noexcept { m_AsyncLoadBudget = seconds; }
 
         Core::ScopeObject<IResourceTexture> FindTexture(const char* name) noexcept;
         Core::ScopeObject<IResourceSprite> FindSprite(const char* name) noexcept;
@@ -180,11 +212,17 @@ namespace LuaSTGPlus
     private:
         static bool g_ResourceLoadingLog;
         float m_GlobalImageScaleFactor = 1.0f;
+        bool m_TextureAtlasEnable = false;
+        uint32_t m_TextureAtlasMaxSize = 256;
     public:
         static void SetResourceLoadingLog(bool b);
         static bool GetResourceLoadingLog();
         float GetGlobalImageScaleFactor() const noexcept { return m_GlobalImageScaleFactor; }
         void SetGlobalImageScaleFactor(float s) noexcept { m_GlobalImageScaleFactor = s; }
+        // 纹理图集：之后加载的、宽高都不超过 max_size 的纹理会被打包到共享页面上
+        bool GetTextureAtlasEnable() const noexcept { return m_TextureAtlasEnable; }
+        uint32_t GetTextureAtlasMaxSize() const noexcept { return m_TextureAtlasMaxSize; }
+        void SetTextureAtlas(bool enable, uint32_t max_size) noexcept { m_TextureAtlasEnable = enable; m_TextureAtlasMaxSize = max_size; }
         void ShowResourceManagerDebugWindow(bool* p_open = nullptr);
     public:
         ResourceMgr();
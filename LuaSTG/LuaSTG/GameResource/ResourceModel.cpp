@@ -1,15 +1,17 @@
 #include "GameResource/ResourceModel.hpp"
+#include <cmath>
 
 namespace LuaSTGPlus
 {
     bool Mesh::resize(uint32_t const vertex_count, uint32_t const index_count) noexcept
     {
-        if (vertex_count > 32768 || index_count > 32768)
+        if (vertex_count > Core::Graphics::IRenderer::max_draw_vertex_count)
             return false;
         try
         {
             vertex_.resize(vertex_count);
             index_.resize(index_count);
+            dirty_ = true;
         }
         catch (std::bad_alloc const&)
         {
@@ -29,10 +31,12 @@ namespace LuaSTGPlus
     {
         uint32_t const c = color.color();
         for (auto& v : vertex_) v.color = c;
+        dirty_ = true;
     }
     void Mesh::setIndex(uint32_t const index, Core::Graphics::IRenderer::DrawIndex const value) noexcept
     {
         index_[index] = value;
+        dirty_ = true;
     }
     void Mesh::setVertex(uint32_t const index, float const x, float const y, float const z, float const u, float const v, Core::Color4B const color) noexcept
     {
@@ -42,28 +46,97 @@ namespace LuaSTGPlus
         vertex_[index].color = color.color();
         vertex_[index].u = u;
         vertex_[index].v = v;
+        dirty_ = true;
     }
     void Mesh::setVertexPosition(uint32_t const index, float const x, float const y, float const z) noexcept
     {
         vertex_[index].x = x;
         vertex_[index].y = y;
         vertex_[index].z = z;
+        dirty_ = true;
     }
     void Mesh::setVertexCoords(uint32_t const index, float const u, float const v) noexcept
     {
         vertex_[index].u = u;
         vertex_[index].v = v;
+        dirty_ = true;
     }
     void Mesh::setVertexColor(uint32_t const index, Core::Color4B const color) noexcept
     {
         vertex_[index].color = color.color();
+        dirty_ = true;
+    }
+    void Mesh::setStatic(bool const enable) noexcept
+    {
+        static_ = enable;
+        if (!static_)
+        {
+            buffer_.reset(); // 不再需要显存副本
+        }
+        dirty_ = true;
+    }
+    void Mesh::setTransform(Core::Vector3F const& position, float const roll, float const pitch, float const yaw, Core::Vector3F const& scale) noexcept
+    {
+        position_ = position;
+        rotation_ = Core::Vector3F(roll, pitch, yaw);
+        scale_ = scale;
+        transform_ = position_ != Core::Vector3F() || rotation_ != Core::Vector3F() || scale_ != Core::Vector3F(1.0f, 1.0f, 1.0f);
     }
 
     bool Mesh::draw(Core::Graphics::IRenderer* p_renderer)
     {
-        return p_renderer->drawRaw(
-                vertex_.data(), (uint16_t)vertex_.size(),
-                index_.data(), (uint16_t)index_.size());
+        if (static_)
+        {
+            if (!buffer_)
+            {
+                if (!p_renderer->createMeshBuffer(~buffer_))
+                    return false;
+                dirty_ = true;
+            }
+            if (dirty_)
+            {
+                if (!buffer_->setData(vertex_.data(), (uint32_t)vertex_.size(), index_.data(), (uint32_t)index_.size()))
+                    return false;
+                dirty_ = false;
+            }
+            buffer_->setScaling(scale_);
+            buffer_->setRotationRollPitchYaw(rotation_.x, rotation_.y, rotation_.z);
+            buffer_->setPosition(position_);
+            return p_renderer->drawMeshBuffer(buffer_.get());
+        }
+        if (!transform_)
+        {
+            return p_renderer->drawRaw(
+                    vertex_.data(), (uint32_t)vertex_.size(),
+                    index_.data(), (uint32_t)index_.size());
+        }
+        // 动态网格在 CPU 上变换，与静态网格的顺序相同：缩放，绕 Z、Y、X 轴旋转，平移
+        Core::Graphics::IRenderer::DrawVertex* p_vert = nullptr;
+        Core::Graphics::IRenderer::DrawIndex* p_idx = nullptr;
+        Core::Graphics::IRenderer::DrawIndex vert_offset = 0;
+        if (!p_renderer->drawRequest((uint32_t)vertex_.size(), (uint32_t)index_.size(), &p_vert, &p_idx, &vert_offset))
+            return false;
+        float const sin_r = std::sin(rotation_.x), cos_r = std::cos(rotation_.x);
+        float const sin_p = std::sin(rotation_.y), cos_p = std::cos(rotation_.y);
+        float const sin_y = std::sin(rotation_.z), cos_y = std::cos(rotation_.z);
+        for (size_t i = 0; i < vertex_.size(); i += 1)
+        {
+            float x = vertex_[i].x * scale_.x;
+            float y = vertex_[i].y * scale_.y;
+            float z = vertex_[i].z * scale_.z;
+            float t = x * cos_r - y * sin_r; y = x * sin_r + y * cos_r; x = t; // roll
+            t = x * cos_y + z * sin_y; z = z * cos_y - x * sin_y; x = t; // yaw
+            t = y * cos_p - z * sin_p; z = y * sin_p + z * cos_p; y = t; // pitch
+            p_vert[i] = vertex_[i];
+            p_vert[i].x = x + position_.x;
+            p_vert[i].y = y + position_.y;
+            p_vert[i].z = z + position_.z;
+        }
+        for (size_t i = 0; i < index_.size(); i += 1)
+        {
+            p_idx[i] = (Core::Graphics::IRenderer::DrawIndex)(vert_offset + index_[i]);
+        }
+        return true;
     }
     bool Mesh::draw(Core::Graphics::IRenderer* p_renderer, Core::Graphics::ITexture2D* p_texture)
     {
@@ -71,8 +144,8 @@ namespace LuaSTGPlus
         float const v_scale = 1.0f / (float)p_texture->getSize().y;
         Core::Graphics::IRenderer::DrawVertex* p_vert = nullptr;
         Core::Graphics::IRenderer::DrawIndex* p_idx = nullptr;
-        uint16_t vert_offset = 0;
-        if (!p_renderer->drawRequest((uint16_t)vertex_.size(), (uint16_t)index_.size(), &p_vert, &p_idx, &vert_offset))
+        Core::Graphics::IRenderer::DrawIndex vert_offset = 0;
+        if (!p_renderer->drawRequest((uint32_t)vertex_.size(), (uint32_t)index_.size(), &p_vert, &p_idx, &vert_offset))
             return false;
         for (size_t i = 0; i < vertex_.size(); i += 1)
         {
@@ -81,7 +154,7 @@ namespace LuaSTGPlus
         }
         for (size_t i = 0; i < index_.size(); i += 1)
         {
-            p_idx[i] = vert_offset + index_[i];
+            p_idx[i] = (Core::Graphics::IRenderer::DrawIndex)(vert_offset + index_[i]);
         }
         return true;
     }
@@ -14,9 +14,18 @@ namespace LuaSTGPlus
 	private:
 		std::vector<Core::Graphics::IRenderer::DrawVertex> vertex_;
 		std::vector<Core::Graphics::IRenderer::DrawIndex> index_;
+		// 静态网格：顶点和索引保存在显存里，只在修改后重新上传
+		Core::ScopeObject<Core::Graphics::IMeshBuffer> buffer_;
+		Core::Vector3F position_;
+		Core::Vector3F rotation_; // roll pitch yaw，弧度
+		Core::Vector3F scale_{ 1.0f, 1.0f, 1.0f };
+		bool static_ = false;
+		bool dirty_ = true;
+		bool transform_ = false;
 	public:
-		Core::Graphics::IRenderer::DrawVertex* getVertexPointer() noexcept { return vertex_.data(); }
-		Core::Graphics::IRenderer::DrawIndex* getIndexPointer() noexcept { return index_.data(); }
+		// 调用者可能直接写入数据，视为已修改
+		Core::Graphics::IRenderer::DrawVertex* getVertexPointer() noexcept { dirty_ = true; return vertex_.data(); }
+		Core::Graphics::IRenderer::DrawIndex* getIndexPointer() noexcept { dirty_ = true; return index_.data(); }
 	public:
 		bool resize(uint32_t vertex_count, uint32_t index_count) noexcept;
 		uint32_t getVertexCount() const noexcept;
@@ -27,6 +36,9 @@ namespace LuaSTGPlus
 		void setVertexPosition(uint32_t index, float x, float y, float z) noexcept;
 		void setVertexCoords(uint32_t index, float u, float v) noexcept;
 		void setVertexColor(uint32_t index, Core::Color4B color) noexcept;
+		void setStatic(bool enable) noexcept;
+		bool isStatic() const noexcept { return static_; }
+		void setTransform(Core::Vector3F const& position, float roll, float pitch, float yaw, Core::Vector3F const& scale) noexcept;
 	public:
 		bool draw(Core::Graphics::IRenderer* p_renderer);
 		bool draw(Core::Graphics::IRenderer* p_renderer, Core::Graphics::ITexture2D* p_texture);
@@ -33,6 +33,8 @@ namespace LuaSTGPlus
         m_TTFFontPool.clear();
         m_FXPool.clear();
         m_ModelPool.clear();
+        m_TextureAtlas.Clear();
+        m_ClearCount += 1;
         spdlog::info("[luastg] '{}' pools cleared", getResourcePoolTypeName());
     }
 
@@ -192,6 +194,46 @@ namespace LuaSTGPlus
         return 1;
     }
 
+    void ResourcePool::packTexture(IResourceTexture* p_res) noexcept
+    {
+        if (!m_pMgr->GetTextureAtlasEnable())
+        {
+            return;
+        }
+        auto const size = p_res->GetTexture()->getSize();
+        if (size.x > m_pMgr->GetTextureAtlasMaxSize() || size.y > m_pMgr->GetTextureAtlasMaxSize())
+        {
+            return;
+        }
+        // the original texture is kept for APIs that sample it directly
+        if (m_TextureAtlas.Insert(p_res) && ResourceMgr::GetResourceLoadingLog())
+        {
+            auto const offset = p_res->GetAtlasOffset();
+            spdlog::info("[luastg] LoadTexture: Texture '{}' packed into atlas at ({}, {})", p_res->GetResName(), offset.x, offset.y);
+        }
+    }
+
+    bool ResourcePool::insertTexture(const char* name, Core::Graphics::ITexture2D* p_texture) noexcept
+    {
+        try
+        {
+            Core::ScopeObject<IResourceTexture> tRes;
+            tRes.attach(new ResourceTextureImpl(name, p_texture));
+            if (!m_TexturePool.emplace(name, tRes).second)
+            {
+                spdlog::error("[luastg] LoadTexture: Texture '{}' already exists", name);
+                return false;
+            }
+            packTexture(tRes.get());
+        }
+        catch (std::exception const& e)
+        {
+            spdlog::error("[luastg] LoadTexture: Failed to load texture '{}' ({})", name, e.what());
+            return false;
+        }
+        return true;
+    }
+
     // 加载纹理
 
     bool ResourcePool::LoadTexture(const char* name, const char* path, bool mipmaps) noexcept
@@ -204,6 +246,12 @@ namespace LuaSTGPlus
             }
             return true;
         }
+        if (m_pMgr->IsAsyncTextureLoadPending(m_iType, name))
+        {
+            // 异步加载完成时同名纹理已存在会被丢弃，不能让同步加载抢先
+            spdlog::error("[luastg] LoadTexture: Texture '{}' is still loading asynchronously", name);
+            return false;
+        }
     
         Core::ScopeObject<Core::Graphics::ITexture2D> p_texture;
         // spdlog::debug("tex_ptr: {}", (size_t)&p_texture); // 140737488345752 140737488345752
@@ -213,15 +261,8 @@ namespace LuaSTGPlus
             return false;
         }
 
-        try
-        {
-            Core::ScopeObject<IResourceTexture> tRes;
-            tRes.attach(new ResourceTextureImpl(name, p_texture.get()));
-            m_TexturePool.emplace(name, tRes);
-        }
-        catch (std::exception const& e)
+        if (!insertTexture(name, p_texture.get()))
         {
-            spdlog::error("[luastg] LoadTexture: Failed to load texture '{}' ({})", name, e.what());
             return false;
         }
     
@@ -233,6 +274,26 @@ namespace LuaSTGPlus
         return true;
     }
 
+    bool ResourcePool::LoadTextureAsync(const char* name, const char* path, bool mipmaps) noexcept
+    {
+        if (m_TexturePool.find(std::string_view(name)) != m_TexturePool.end() || m_pMgr->IsAsyncTextureLoadPending(m_iType, name))
+        {
+            if (ResourceMgr::GetResourceLoadingLog())
+            {
+                spdlog::warn("[luastg] LoadTexture: Texture '{}' already exists, loading cancelled.", name);
+            }
+            return true;
+        }
+
+        uint64_t id = 0;
+        if (!LAPP.GetAppModel()->getDevice()->createTextureFromFileAsync(path, mipmaps, &id))
+        {
+            spdlog::error("[luastg] Failed to create texture '{}' from '{}'", name, path);
+            return false;
+        }
+        return m_pMgr->AddAsyncTextureLoad(m_iType, id, name, path);
+    }
+
     bool ResourcePool::LoadTextureBin(const char* name, std::vector<uint8_t> data, bool mipmaps) noexcept
     {
         if (m_TexturePool.find(std::string_view(name)) != m_TexturePool.end())
@@ -243,6 +304,11 @@ namespace LuaSTGPlus
             }
             return true;
         }
+        if (m_pMgr->IsAsyncTextureLoadPending(m_iType, name))
+        {
+            spdlog::error("[luastg] LoadTexture: Texture '{}' is still loading asynchronously", name);
+            return false;
+        }
     
         Core::ScopeObject<Core::Graphics::ITexture2D> p_texture;
         if (!LAPP.GetAppModel()->getDevice()->createTextureFromMemory(data.data(), data.size(), mipmaps, ~p_texture))
@@ -251,15 +317,8 @@ namespace LuaSTGPlus
             return false;
         }
 
-        try
+        if (!insertTexture(name, p_texture.get()))
         {
-            Core::ScopeObject<IResourceTexture> tRes;
-            tRes.attach(new ResourceTextureImpl(name, p_texture.get()));
-            m_TexturePool.emplace(name, tRes);
-        }
-        catch (std::exception const& e)
-        {
-            spdlog::error("[luastg] LoadTexture: Failed to load texture '{}' ({})", name, e.what());
             return false;
         }
     
@@ -311,7 +370,7 @@ namespace LuaSTGPlus
 
     // Creating render targets
 
-    bool ResourcePool::CreateRenderTarget(const char* name, int width, int height, bool depth_buffer) noexcept
+    bool ResourcePool::CreateRenderTarget(const char* name, int width, int height, bool depth_buffer, bool transient) noexcept
     {
         if (m_TexturePool.find(std::string_view(name)) != m_TexturePool.end())
         {
@@ -322,12 +381,17 @@ namespace LuaSTGPlus
             return true;
         }
     
-        std::string_view ds_info(" with depth buffer");
+        std::string_view ds_info(transient ? " (transient) with depth buffer" : " with depth buffer");
 
         try
         {
             Core::ScopeObject<IResourceTexture> tRes;
-            if (width <= 0 || height <= 0)
+            if (transient)
+            {
+                // 不创建纹理，使用时从渲染目标池取得
+                tRes.attach(new ResourceTextureImpl(name, width, height, true));
+            }
+            else if (width <= 0 || height <= 0)
             {
                 tRes.attach(new ResourceTextureImpl(name));
             }
@@ -379,19 +443,28 @@ namespace LuaSTGPlus
             spdlog::error("[luastg] CreateSprite: Unable to create sprite '{}', can't find texture '{}'", name, texname);
             return false;
         }
+        if (pTex->IsTransient())
+        {
+            // 临时渲染目标的纹理每帧都会归还到池中，精灵保存的纹理之后会属于其他渲染目标
+            spdlog::error("[luastg] CreateSprite: Unable to create sprite '{}', '{}' is a transient render target", name, texname);
+            return false;
+        }
     
+        Core::RectF rc((float)x, (float)y, (float)(x + w), (float)(y + h));
+        Core::Graphics::ITexture2D* p_texture = TextureAtlas::MapTextureRect(pTex.get(), rc);
+
         Core::ScopeObject<Core::Graphics::ISprite> p_sprite;
         if (!Core::Graphics::ISprite::create(
             LAPP.GetAppModel()->getRenderer(),
-            pTex->GetTexture(),
+            p_texture,
             ~p_sprite
         ))
         {
             spdlog::error("[luastg] Failed to create image sprite '{}' from texture '{}'", texname, name);
             return false;
         }
-        p_sprite->setTextureRect(Core::RectF((float)x, (float)y, (float)(x + w), (float)(y + h)));
-        p_sprite->setTextureCenter(Core::Vector2F((float)(x + w * 0.5), (float)(y + h * 0.5)));
+        p_sprite->setTextureRect(rc);
+        p_sprite->setTextureCenter(Core::Vector2F((rc.a.x + rc.b.x) * 0.5f, (rc.a.y + rc.b.y) * 0.5f));
 
         try
         {
@@ -434,6 +507,11 @@ namespace LuaSTGPlus
             spdlog::error("[luastg] CreateAnimation: Unable to create animation '{}', can't find texture '{}'", name, texname);
             return false;
         }
+        if (pTex->IsTransient())
+        {
+            spdlog::error("[luastg] CreateAnimation: Unable to create animation '{}', '{}' is a transient render target", name, texname);
+            return false;
+        }
 
         try {
             Core::ScopeObject<IResourceAnimation> tRes;
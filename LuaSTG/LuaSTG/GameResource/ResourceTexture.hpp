@@ -12,5 +12,17 @@ namespace LuaSTGPlus
 		virtual Core::Graphics::IRenderTarget* GetRenderTarget() = 0;
 		virtual bool IsRenderTarget() = 0;
 		virtual bool HasDepthStencilBuffer() = 0;
+		// 跟随画布大小的渲染目标，动态分辨率下按渲染缩放分配
+		virtual bool IsAutoResize() = 0;
+
+		// 临时渲染目标，使用时才从渲染目标池取得纹理，ReleaseTransient 或一帧结束时归还，内容不会保留到下一帧
+		virtual bool IsTransient() = 0;
+		virtual bool IsTransientAcquired() = 0;
+		virtual void ReleaseTransient() = 0;
+
+		// Shared atlas page holding a copy of this texture, nullptr if it was not packed
+		virtual Core::Graphics::ITexture2D* GetAtlasTexture() = 0;
+		virtual Core::Vector2U GetAtlasOffset() = 0;
+		virtual void SetAtlasRegion(Core::Graphics::ITexture2D* p_page, Core::Vector2U offset) = 0;
 	};
 };
@@ -0,0 +1,207 @@
+#include "GameResource/TextureAtlas.hpp"
+#include "AppFrame.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstdint>
+
+namespace LuaSTGPlus
+{
+	// Skyline bottom-left: place the rect where its top edge ends up lowest
+
+	bool TextureAtlas::findPosition(Page const& page, uint32_t w, uint32_t h, uint32_t& x, uint32_t& y, size_t& index) noexcept
+	{
+		uint32_t best_bottom = UINT32_MAX;
+		uint32_t best_width = UINT32_MAX;
+		for (size_t i = 0; i < page.skyline.size(); i += 1)
+		{
+			SkylineNode const& node = page.skyline[i];
+			if (node.x + w > page_size)
+			{
+				break; // the following nodes are further to the right
+			}
+			// the rect rests on the highest node it spans
+			uint32_t top = node.y;
+			uint32_t width_left = w;
+			for (size_t j = i; width_left > 0; j += 1)
+			{
+				top = std::max(top, page.skyline[j].y);
+				width_left -= std::min(width_left, page.skyline[j].width);
+			}
+			if (top + h > page_size)
+			{
+				continue;
+			}
+			if (top + h < best_bottom || (top + h == best_bottom && node.width < best_width))
+			{
+				best_bottom = top + h;
+				best_width = node.width;
+				x = node.x;
+				y = top;
+				index = i;
+			}
+		}
+		return best_bottom != UINT32_MAX;
+	}
+	void TextureAtlas::addSkylineLevel(Page& page, size_t index, uint32_t x, uint32_t y, uint32_t w, uint32_t h)
+	{
+		page.skyline.insert(page.skyline.begin() + index, SkylineNode{ x, y + h, w });
+		// shrink or remove the nodes now covered by the new one
+		for (size_t i = index + 1; i < page.skyline.size();)
+		{
+			SkylineNode& node = page.skyline[i];
+			SkylineNode const& prev = page.skyline[i - 1];
+			if (node.x >= prev.x + prev.width)
+			{
+				break;
+			}
+			uint32_t const shrink = prev.x + prev.width - node.x;
+			if (node.width <= shrink)
+			{
+				page.skyline.erase(page.skyline.begin() + i);
+				continue;
+			}
+			node.x += shrink;
+			node.width -= shrink;
+			break;
+		}
+		// merge neighbours at the same height
+		for (size_t i = 0; i + 1 < page.skyline.size();)
+		{
+			if (page.skyline[i].y == page.skyline[i + 1].y)
+			{
+				page.skyline[i].width += page.skyline[i + 1].width;
+				page.skyline.erase(page.skyline.begin() + i + 1);
+			}
+			else
+			{
+				i += 1;
+			}
+		}
+	}
+	bool TextureAtlas::copyWithPadding(Core::Graphics::ITexture2D* p_page, Core::Graphics::ITexture2D* p_source, Core::Vector2U pos) noexcept
+	{
+		auto const size = p_source->getSize();
+		uint32_t const r = size.x - 1;
+		uint32_t const b = size.y - 1;
+		bool result = p_page->copyPixelData(p_source, Core::RectU(0, 0, size.x, size.y), pos);
+		// extrude the edge pixels into the padding
+		result = result && p_page->copyPixelData(p_source, Core::RectU(0, 0, size.x, 1), Core::Vector2U(pos.x, pos.y - 1));
+		result = result && p_page->copyPixelData(p_source, Core::RectU(0, b, size.x, size.y), Core::Vector2U(pos.x, pos.y + size.y));
+		result = result && p_page->copyPixelData(p_source, Core::RectU(0, 0, 1, size.y), Core::Vector2U(pos.x - 1, pos.y));
+		result = result && p_page->copyPixelData(p_source, Core::RectU(r, 0, size.x, size.y), Core::Vector2U(pos.x + size.x, pos.y));
+		result = result && p_page->copyPixelData(p_source, Core::RectU(0, 0, 1, 1), Core::Vector2U(pos.x - 1, pos.y - 1));
+		result = result && p_page->copyPixelData(p_source, Core::RectU(r, 0, size.x, 1), Core::Vector2U(pos.x + size.x, pos.y - 1));
+		result = result && p_page->copyPixelData(p_source, Core::RectU(0, b, 1, size.y), Core::Vector2U(pos.x - 1, pos.y + size.y));
+		result = result && p_page->copyPixelData(p_source, Core::RectU(r, b, size.x, size.y), Core::Vector2U(pos.x + size.x, pos.y + size.y));
+		return result;
+	}
+
+	bool TextureAtlas::Insert(IResourceTexture* p_res) noexcept
+	{
+		Core::Graphics::ITexture2D* p_source = p_res->GetTexture();
+		auto const size = p_source->getSize();
+		uint32_t const w = size.x + 2 * padding;
+		uint32_t const h = size.y + 2 * padding;
+		if (size.x == 0 || size.y == 0 || w > page_size || h > page_size)
+		{
+			return false;
+		}
+
+		try
+		{
+			Page* p_page = nullptr;
+			uint32_t x = 0, y = 0;
+			size_t index = 0;
+			for (auto& page : m_pages)
+			{
+				if (findPosition(page, w, h, x, y, index))
+				{
+					p_page = &page;
+					break;
+				}
+			}
+			if (!p_page)
+			{
+				Page page;
+				if (!LAPP.GetAppModel()->getDevice()->createTexture(Core::Vector2U(page_size, page_size), ~page.texture))
+				{
+					spdlog::error("[luastg] TextureAtlas: Failed to create atlas page ({}x{})", page_size, page_size);
+					return false;
+				}
+				page.skyline.push_back(SkylineNode{ 0, 0, page_size });
+				m_pages.emplace_back(std::move(page));
+				p_page = &m_pages.back();
+				findPosition(*p_page, w, h, x, y, index);
+			}
+
+			Core::Vector2U const pos(x + padding, y + padding);
+			if (!copyWithPadding(p_page->texture.get(), p_source, pos))
+			{
+				spdlog::error("[luastg] TextureAtlas: Failed to copy texture '{}' into atlas page", p_res->GetResName());
+				return false;
+			}
+			addSkylineLevel(*p_page, index, x, y, w, h);
+			p_page->entries.push_back(Entry{ p_source, pos });
+			p_page->used_area += (uint64_t)w * (uint64_t)h;
+			p_page->texture_count += 1;
+			p_res->SetAtlasRegion(p_page->texture.get(), pos);
+			// re-added to the end, so the source and page textures are recreated before onDeviceCreate copies
+			LAPP.GetAppModel()->getDevice()->addEventListener(this);
+		}
+		catch (std::exception const& e)
+		{
+			spdlog::error("[luastg] TextureAtlas: Failed to pack texture '{}' ({})", p_res->GetResName(), e.what());
+			return false;
+		}
+		return true;
+	}
+	void TextureAtlas::Clear() noexcept
+	{
+		if (!m_pages.empty())
+		{
+			LAPP.GetAppModel()->getDevice()->removeEventListener(this);
+		}
+		m_pages.clear();
+	}
+
+	void TextureAtlas::onDeviceCreate()
+	{
+		for (auto& page : m_pages)
+		{
+			for (auto const& entry : page.entries)
+			{
+				if (!copyWithPadding(page.texture.get(), entry.source.get(), entry.pos))
+				{
+					spdlog::error("[luastg] TextureAtlas: Failed to restore atlas page after device creation");
+					break;
+				}
+			}
+		}
+	}
+	void TextureAtlas::onDeviceDestroy()
+	{
+		// the page textures release their own resources
+	}
+
+	Core::Graphics::ITexture2D* TextureAtlas::MapTextureRect(IResourceTexture* p_res, Core::RectF& rc) noexcept
+	{
+		Core::Graphics::ITexture2D* p_texture = p_res->GetTexture();
+		Core::Graphics::ITexture2D* p_page = p_res->GetAtlasTexture();
+		if (!p_page)
+		{
+			return p_texture;
+		}
+		// wrapping or custom sampling only works on the original texture
+		auto const size = p_texture->getSize();
+		if (std::min(rc.a.x, rc.b.x) < 0.0f || std::min(rc.a.y, rc.b.y) < 0.0f
+			|| std::max(rc.a.x, rc.b.x) > (float)size.x || std::max(rc.a.y, rc.b.y) > (float)size.y
+			|| p_texture->getSamplerState().has_value()
+			|| p_texture->isPremultipliedAlpha() != p_page->isPremultipliedAlpha())
+		{
+			return p_texture;
+		}
+		auto const offset = p_res->GetAtlasOffset();
+		rc = rc + Core::Vector2F((float)offset.x, (float)offset.y);
+		return p_page;
+	}
+}
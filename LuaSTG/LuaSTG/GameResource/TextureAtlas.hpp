@@ -0,0 +1,52 @@
+#pragma once
+#include "GameResource/ResourceTexture.hpp"
+#include <vector>
+
+namespace LuaSTGPlus
+{
+	// 运行时纹理图集，把加载的小纹理拷贝到共享的页面上，使不同纹理的精灵可以合批
+	// 页面是动态纹理，设备重建后内容为空，需要从保留的原纹理重新拷贝
+	class TextureAtlas : public Core::Graphics::IDeviceEventListener
+	{
+	public:
+		static constexpr uint32_t page_size = 2048;
+		static constexpr uint32_t padding = 1; // 边缘外扩，避免线性过滤采样到相邻纹理
+
+		struct SkylineNode
+		{
+			uint32_t x;
+			uint32_t y;
+			uint32_t width;
+		};
+		struct Entry
+		{
+			Core::ScopeObject<Core::Graphics::ITexture2D> source;
+			Core::Vector2U pos;
+		};
+		struct Page
+		{
+			Core::ScopeObject<Core::Graphics::ITexture2D> texture;
+			std::vector<SkylineNode> skyline;
+			std::vector<Entry> entries;
+			uint64_t used_area{ 0 };
+			uint32_t texture_count{ 0 };
+		};
+	private:
+		std::vector<Page> m_pages;
+	private:
+		static bool findPosition(Page const& page, uint32_t w, uint32_t h, uint32_t& x, uint32_t& y, size_t& index) noexcept;
+		static void addSkylineLevel(Page& page, size_t index, uint32_t x, uint32_t y, uint32_t w, uint32_t h);
+		static bool copyWithPadding(Core::Graphics::ITexture2D* p_page, Core::Graphics::ITexture2D* p_source, Core::Vector2U pos) noexcept;
+	public:
+		void onDeviceCreate() override;
+		void onDeviceDestroy() override;
+
+		// 打包纹理，成功时设置纹理资源的图集区域
+		bool Insert(IResourceTexture* p_res) noexcept;
+		void Clear() noexcept;
+		std::vector<Page> const& GetPages() const noexcept { return m_pages; }
+
+		// 把原纹理上的区域映射到图集页面上，区域超出原纹理或者纹理有独立的采样状态时返回原纹理
+		static Core::Graphics::ITexture2D* MapTextureRect(IResourceTexture* p_res, Core::RectF& rc) noexcept;
+	};
+}
@@ -113,6 +113,33 @@ namespace LuaSTGPlus::LuaWrapper
                 self->setVertexColor(index, color);
                 return 0;
             }
+            static int setStatic(lua_State* L)
+            {
+                Mesh* self = Cast(L, 1);
+                self->setStatic(lua_toboolean(L, 2));
+                return 0;
+            }
+            static int isStatic(lua_State* L)
+            {
+                Mesh* self = Cast(L, 1);
+                lua_pushboolean(L, self->isStatic());
+                return 1;
+            }
+            static int setTransform(lua_State* L)
+            {
+                Mesh* self = Cast(L, 1);
+                float const x = luaL_check_float(L, 2);
+                float const y = luaL_check_float(L, 3);
+                float const z = luaL_check_float(L, 4);
+                float const roll  = (float)(L_DEG_TO_RAD * luaL_optnumber(L, 5, 0.0));
+                float const pitch = (float)(L_DEG_TO_RAD * luaL_optnumber(L, 6, 0.0));
+                float const yaw   = (float)(L_DEG_TO_RAD * luaL_optnumber(L, 7, 0.0));
+                float const sx = (float)luaL_optnumber(L, 8, 1.0);
+                float const sy = (float)luaL_optnumber(L, 9, 1.0);
+                float const sz = (float)luaL_optnumber(L, 10, 1.0);
+                self->setTransform(Core::Vector3F(x, y, z), roll, pitch, yaw, Core::Vector3F(sx, sy, sz));
+                return 0;
+            }
 
             static int __gc(lua_State* L)
             {
@@ -149,6 +176,9 @@ namespace LuaSTGPlus::LuaWrapper
             { "setVertexPosition", &Binding::setVertexPosition },
             { "setVertexCoords", &Binding::setVertexCoords },
             { "setVertexColor", &Binding::setVertexColor },
+            { "setStatic", &Binding::setStatic },
+            { "isStatic", &Binding::isStatic },
+            { "setTransform", &Binding::setTransform },
             { NULL, NULL },
         };
 
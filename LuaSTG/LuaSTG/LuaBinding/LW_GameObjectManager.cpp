@@ -135,6 +135,17 @@ void LuaSTGPlus::LuaWrapper::GameObjectManagerWrapper::Register(lua_State* L) no
 		{
 			return LPOOL.PushCurrentObject(L);
 		}
+		// 图层内按渲染状态排序
+		static int SetLayerStateSorting(lua_State* L)
+		{
+			LPOOL.SetLayerStateSorting(luaL_checknumber(L, 1), lua_toboolean(L, 2));
+			return 0;
+		}
+		static int GetLayerStateSorting(lua_State* L)
+		{
+			lua_pushboolean(L, LPOOL.GetLayerStateSorting(luaL_checknumber(L, 1)));
+			return 1;
+		}
 	};
 
 	luaL_Reg const lib[] = {
@@ -189,6 +200,8 @@ void LuaSTGPlus::LuaWrapper::GameObjectManagerWrapper::Register(lua_State* L) no
 		{ "IsSameWorld", &Wrapper::CheckWorlds },
 		{ "ActiveWorlds", &Wrapper::ActiveWorlds },
 		{ "GetCurrentObject", &Wrapper::GetCurrentObject },
+		{ "SetLayerStateSorting", &Wrapper::SetLayerStateSorting },
+		{ "GetLayerStateSorting", &Wrapper::GetLayerStateSorting },
 		{ NULL, NULL },
 	};
 
@@ -60,6 +60,80 @@ void LuaSTGPlus::BuiltInFunctionWrapper::Register(lua_State* L)noexcept
 			LAPP.SetVsync(lua_toboolean(L, 1));
 			return 0;
 		}
+		static int SetPipelinedPresent(lua_State* L)
+		{
+			lua_pushboolean(L, LAPP.GetAppModel()->getSwapChain()->setPipelinedPresent(lua_toboolean(L, 1)));
+			return 1;
+		}
+		static int GetGpuFrameStatistics(lua_State* L)
+		{
+			auto* renderer = LAPP.GetAppModel()->getRenderer();
+			auto const& zones = renderer->getGpuZones();
+			lua_createtable(L, 0, 2);													// t
+			lua_pushnumber(L, renderer->getGpuFrameTime() * 1000.0);					// t ms
+			lua_setfield(L, -2, "frame_time");											// t
+			lua_createtable(L, (int)zones.size(), 0);									// t zones
+			for (size_t i = 0; i < zones.size(); i += 1)
+			{
+				lua_createtable(L, 0, 3);												// t zones zone
+				lua_pushlstring(L, zones[i].name.data(), zones[i].name.size());			// t zones zone name
+				lua_setfield(L, -2, "name");											// t zones zone
+				lua_pushnumber(L, zones[i].time * 1000.0);								// t zones zone ms
+				lua_setfield(L, -2, "time");											// t zones zone
+				lua_pushinteger(L, (lua_Integer)zones[i].depth);						// t zones zone depth
+				lua_setfield(L, -2, "depth");											// t zones zone
+				lua_rawseti(L, -2, (int)(i + 1));										// t zones
+			}
+			lua_setfield(L, -2, "zones");												// t
+			return 1;
+		}
+		static int GetRendererStatistics(lua_State* L)
+		{
+			using FlushCause = Core::Graphics::RendererFrameStatistics::FlushCause;
+			auto const info = LAPP.GetAppModel()->getRenderer()->getFrameStatistics();
+			auto const flush_count = [&info](FlushCause cause) -> lua_Number
+			{
+				return (lua_Number)info.flush[(size_t)cause];
+			};
+			lua_createtable(L, 0, 9);													// t
+			lua_createtable(L, 0, 4);													// t flush
+			lua_pushnumber(L, flush_count(FlushCause::BufferFull));
+			lua_setfield(L, -2, "buffer_full");
+			lua_pushnumber(L, flush_count(FlushCause::StateChange));
+			lua_setfield(L, -2, "state_change");
+			lua_pushnumber(L, flush_count(FlushCause::RenderTarget));
+			lua_setfield(L, -2, "render_target");
+			lua_pushnumber(L, flush_count(FlushCause::Explicit));
+			lua_setfield(L, -2, "explicit");
+			lua_setfield(L, -2, "flush");												// t
+			lua_pushnumber(L, (lua_Number)info.draw);
+			lua_setfield(L, -2, "draw");
+			lua_pushnumber(L, (lua_Number)info.vertex);
+			lua_setfield(L, -2, "vertex");
+			lua_pushnumber(L, (lua_Number)info.index);
+			lua_setfield(L, -2, "index");
+			lua_pushnumber(L, (lua_Number)info.texture_bind);
+			lua_setfield(L, -2, "texture_bind");
+			lua_pushnumber(L, (lua_Number)info.sampler_bind);
+			lua_setfield(L, -2, "sampler_bind");
+			lua_pushnumber(L, (lua_Number)info.program_switch);
+			lua_setfield(L, -2, "program_switch");
+			lua_pushnumber(L, (lua_Number)info.post_effect);
+			lua_setfield(L, -2, "post_effect");
+			lua_createtable(L, 0, 5);													// t skipped
+			lua_pushnumber(L, (lua_Number)info.texture_bind_skipped);
+			lua_setfield(L, -2, "texture_bind");
+			lua_pushnumber(L, (lua_Number)info.sampler_bind_skipped);
+			lua_setfield(L, -2, "sampler_bind");
+			lua_pushnumber(L, (lua_Number)info.program_switch_skipped);
+			lua_setfield(L, -2, "program_switch");
+			lua_pushnumber(L, (lua_Number)info.vertex_array_bind_skipped);
+			lua_setfield(L, -2, "vertex_array_bind");
+			lua_pushnumber(L, (lua_Number)info.blend_state_skipped);
+			lua_setfield(L, -2, "blend_state");
+			lua_setfield(L, -2, "skipped");												// t
+			return 1;
+		}
 		static int SetResolution(lua_State* L)
 		{
 			LAPP.SetResolution(
@@ -81,6 +155,45 @@ void LuaSTGPlus::BuiltInFunctionWrapper::Register(lua_State* L)noexcept
 			lua_pushnumber(L, LAPP.GetFPS());
 			return 1;
 		}
+		static int SetFramePacingMode(lua_State* L)
+		{
+			std::string_view const mode = luaL_check_string_view(L, 1);
+			auto* frc = LAPP.GetAppModel()->getFrameRateController();
+			if (mode == "sleep")
+				frc->setFramePacingMode(Core::FramePacingMode::Sleep);
+			else if (mode == "hybrid")
+				frc->setFramePacingMode(Core::FramePacingMode::Hybrid);
+			else
+				return luaL_error(L, "invalid frame pacing mode '%s'", mode.data());
+			return 0;
+		}
+		static int GetFrameTimeStatistics(lua_State* L)
+		{
+			auto const info = LAPP.GetAppModel()->getFrameRateController()->getFrameTimeStatistics();
+			lua_createtable(L, 0, 4);													// t
+			lua_pushnumber(L, info.p50 * 1000.0);										// t ms
+			lua_setfield(L, -2, "p50");													// t
+			lua_pushnumber(L, info.p99 * 1000.0);
+			lua_setfield(L, -2, "p99");
+			lua_pushnumber(L, info.max * 1000.0);
+			lua_setfield(L, -2, "max");
+			lua_pushnumber(L, info.spin_budget * 1000.0);
+			lua_setfield(L, -2, "spin_budget");
+			return 1;
+		}
+		static int SetDynamicResolution(lua_State* L)
+		{
+			bool const enable = lua_toboolean(L, 1);
+			float const min_scale = (float)luaL_optnumber(L, 2, 0.5);
+			float const max_scale = (float)luaL_optnumber(L, 3, 1.0);
+			LAPP.SetDynamicResolution(enable, min_scale, max_scale);
+			return 0;
+		}
+		static int GetRenderScale(lua_State* L)
+		{
+			lua_pushnumber(L, LAPP.GetRenderScale());
+			return 1;
+		}
 		static int Log(lua_State* L)
 		{
 			lua_Integer const level = luaL_checkinteger(L, 1);
@@ -256,7 +369,14 @@ void LuaSTGPlus::BuiltInFunctionWrapper::Register(lua_State* L)noexcept
 		{ "SetWindowed", &WrapperImplement::SetWindowed },
 		{ "SetFPS", &WrapperImplement::SetFPS },
 		{ "GetFPS", &WrapperImplement::GetFPS },
+		{ "SetFramePacingMode", &WrapperImplement::SetFramePacingMode },
+		{ "GetFrameTimeStatistics", &WrapperImplement::GetFrameTimeStatistics },
+		{ "SetDynamicResolution", &WrapperImplement::SetDynamicResolution },
+		{ "GetRenderScale", &WrapperImplement::GetRenderScale },
 		{ "SetVsync", &WrapperImplement::SetVsync },
+		{ "SetPipelinedPresent", &WrapperImplement::SetPipelinedPresent },
+		{ "GetGpuFrameStatistics", &WrapperImplement::GetGpuFrameStatistics },
+		{ "GetRendererStatistics", &WrapperImplement::GetRendererStatistics },
 		{ "SetResolution", &WrapperImplement::SetResolution },
 		{ "Log", &WrapperImplement::Log },
 		{ "DoFile", &WrapperImplement::DoFile },
@@ -1,4 +1,5 @@
 #include "LuaBinding/LuaWrapper.hpp"
+#include "LuaBinding/lua_utility.hpp"
 #include "AppFrame.h"
 
 void LuaSTGPlus::LuaWrapper::RenderWrapper::Register(lua_State* L) noexcept
@@ -47,16 +48,59 @@ void LuaSTGPlus::LuaWrapper::RenderWrapper::Register(lua_State* L) noexcept
         static int Snapshot(lua_State* L)
         {
             const char* path = luaL_checkstring(L, 1);
-            LAPP.SnapShot(path);
-            return 0;
+            if (lua_isnoneornil(L, 2))
+            {
+                LAPP.SnapShot(path);
+                return 0;
+            }
+            // Asynchronous, callback(success, path) is called a few frames later
+            luaL_checktype(L, 2, LUA_TFUNCTION);
+            lua_pushvalue(L, 2);
+            lua_pushboolean(L, LAPP.SnapShotAsync(path, luaL_ref(L, LUA_REGISTRYINDEX)));
+            return 1;
         }
         static int SaveTexture(lua_State* L)
         {
             const char* tex_name = luaL_checkstring(L, 1);
             const char* path = luaL_checkstring(L, 2);
-            LAPP.SaveTexture(tex_name, path);
+            if (lua_isnoneornil(L, 3))
+            {
+                LAPP.SaveTexture(tex_name, path);
+                return 0;
+            }
+            luaL_checktype(L, 3, LUA_TFUNCTION);
+            lua_pushvalue(L, 3);
+            lua_pushboolean(L, LAPP.SaveTextureAsync(tex_name, path, luaL_ref(L, LUA_REGISTRYINDEX)));
+            return 1;
+        }
+        static int BeginFrameCapture(lua_State* L)
+        {
+            // Every presented frame until EndFrameCapture, at the canvas size. For faster than
+            // real time recording, turn vsync off and raise the target FPS
+            std::string_view const format = luaL_check_string_view(L, 1);
+            std::string_view const target = luaL_check_string_view(L, 2);
+            Core::Graphics::FrameCaptureFormat capture_format;
+            if (format == "png")
+                capture_format = Core::Graphics::FrameCaptureFormat::PNG;
+            else if (format == "qoi")
+                capture_format = Core::Graphics::FrameCaptureFormat::QOI;
+            else if (format == "pipe")
+                capture_format = Core::Graphics::FrameCaptureFormat::Pipe;
+            else
+                return luaL_error(L, "invalid frame capture format '%s'", format.data());
+            lua_pushboolean(L, LAPP.GetAppModel()->getSwapChain()->beginFrameCapture(capture_format, target));
+            return 1;
+        }
+        static int EndFrameCapture(lua_State*)
+        {
+            LAPP.GetAppModel()->getSwapChain()->endFrameCapture();
             return 0;
         }
+        static int IsFrameCapturing(lua_State* L)
+        {
+            lua_pushboolean(L, LAPP.GetAppModel()->getSwapChain()->isFrameCapturing());
+            return 1;
+        }
         //EX+
         static int DrawCollider(lua_State*)
         {
@@ -86,6 +130,9 @@ void LuaSTGPlus::LuaWrapper::RenderWrapper::Register(lua_State* L) noexcept
         //EX
         { "Snapshot", &Wrapper::Snapshot },
         { "SaveTexture", &Wrapper::SaveTexture },
+        { "BeginFrameCapture", &Wrapper::BeginFrameCapture },
+        { "EndFrameCapture", &Wrapper::EndFrameCapture },
+        { "IsFrameCapturing", &Wrapper::IsFrameCapturing },
         // END
         { NULL, NULL },
     };
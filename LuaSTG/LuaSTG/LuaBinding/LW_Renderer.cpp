@@ -403,6 +403,16 @@ static int lib_setTexture(lua_State* L)
     LR2D()->setTexture(p->GetTexture());
     return 0;
 }
+static int lib_setTextureBatching(lua_State* L)
+{
+    LR2D()->setTextureBatching(lua_toboolean(L, 1));
+    return 0;
+}
+static int lib_getTextureBatching(lua_State* L)
+{
+    lua_pushboolean(L, LR2D()->getTextureBatching());
+    return 1;
+}
 
 static int lib_drawTriangle(lua_State* L)
 {
@@ -838,6 +848,8 @@ static luaL_Reg const lib_func[] = {
     MKFUNC(setDepthState),
     MKFUNC(setBlendState),
     MKFUNC(setTexture),
+    MKFUNC(setTextureBatching),
+    MKFUNC(getTextureBatching),
 
     MKFUNC(drawTriangle),
     MKFUNC(drawQuad),
@@ -960,6 +972,20 @@ static int compat_PopRenderTarget(lua_State* L)
     LR2D()->setViewportAndScissorRect();
     return 0;
 }
+static int compat_ReleaseRenderTarget(lua_State* L)
+{
+    Core::ScopeObject<LuaSTGPlus::IResourceTexture> p = LRES.FindTexture(luaL_checkstring(L, 1));
+    if (!p)
+        return luaL_error(L, "rendertarget '%s' not found.", luaL_checkstring(L, 1));
+    if (!p->IsTransient())
+        return luaL_error(L, "'%s' is not a transient rendertarget.", luaL_checkstring(L, 1));
+    if (LAPP.GetRenderTargetManager()->CheckRenderTargetInUse(p.get()))
+        return luaL_error(L, "rendertarget '%s' is in use.", luaL_checkstring(L, 1));
+    // Draws already recorded keep a reference to the texture, flush them before it can be handed out again
+    LR2D()->flush();
+    p->ReleaseTransient();
+    return 0;
+}
 static int compat_PostEffect(lua_State* L)
 {
     validate_render_scope();
@@ -996,8 +1022,10 @@ static int compat_PostEffect(lua_State* L)
         auto const rt_size = prt->GetTexture()->getSize();
         p_effect->setFloat4("screen_texture_size", Core::Vector4F(float(rt_size.x), float(rt_size.y), 0.0f, 0.0f));
 
+        // In pixels of the render target, same as screen_texture_size
         auto const vp = LR2D()->getViewport();
-        p_effect->setFloat4("viewport", Core::Vector4F(vp.a.x, vp.a.y, vp.b.x, vp.b.y));
+        float const vp_scale = LR2D()->getViewportScale();
+        p_effect->setFloat4("viewport", Core::Vector4F(vp.a.x * vp_scale, vp.a.y * vp_scale, vp.b.x * vp_scale, vp.b.y * vp_scale));
 
         if (lua_istable(L, 4))
         {
@@ -1130,6 +1158,7 @@ static luaL_Reg const lib_compat[] = {
     { "ClearZBuffer", &compat_ClearZBuffer },
     { "PushRenderTarget", &compat_PushRenderTarget },
     { "PopRenderTarget", &compat_PopRenderTarget },
+    { "ReleaseRenderTarget", &compat_ReleaseRenderTarget },
     { "PostEffect", &compat_PostEffect },
     { NULL, NULL },
 };
@@ -70,6 +70,34 @@ void LuaSTGPlus::LuaWrapper::ResourceMgrWrapper::Register(lua_State* L) noexcept
                 return luaL_error(L, "can't load texture '%s' from binary data.", name);
             return 0;
         }
+        static int LoadTextureAsync(lua_State* L)
+        {
+            const char* name = luaL_checkstring(L, 1);
+            const char* path = luaL_checkstring(L, 2);
+
+            ResourcePool* pActivedPool = LRES.GetActivedPool();
+            if (!pActivedPool)
+                return luaL_error(L, "can't load resource at this time.");
+            if (!pActivedPool->LoadTextureAsync(name, path, lua_toboolean(L, 3) == 0 ? false : true))
+                return luaL_error(L, "can't load texture from file '%s'.", path);
+            return 0;
+        }
+        static int GetAsyncLoadProgress(lua_State* L)
+        {
+            uint32_t done = 0, total = 0, failed = 0;
+            LRES.GetAsyncLoadProgress(done, total, failed);
+            lua_pushinteger(L, (lua_Integer)done);
+            lua_pushinteger(L, (lua_Integer)total);
+            lua_pushinteger(L, (lua_Integer)failed);
+            return 3;
+        }
+        static int SetAsyncLoadBudget(lua_State* L)
+        {
+            // 毫秒
+            lua_Number const ms = luaL_checknumber(L, 1);
+            LRES.SetAsyncLoadBudget(ms > 0.0 ? ms / 1000.0 : 0.0);
+            return 0;
+        }
         static int LoadSprite(lua_State* L)
         {
             const char* name = luaL_checkstring(L, 1);
@@ -382,6 +410,28 @@ void LuaSTGPlus::LuaWrapper::ResourceMgrWrapper::Register(lua_State* L) noexcept
             
             return 0;
         }
+        static int CreateTransientRenderTarget(lua_State* L)
+        {
+            const char* name = luaL_checkstring(L, 1);
+
+            ResourcePool* pActivedPool = LRES.GetActivedPool();
+            if (!pActivedPool)
+                return luaL_error(L, "can't load resource at this time.");
+
+            int width = 0;
+            int height = 0;
+            if (lua_gettop(L) >= 3)
+            {
+                width = (int)luaL_checkinteger(L, 2);
+                height = (int)luaL_checkinteger(L, 3);
+                if (width < 1 || height < 1)
+                    return luaL_error(L, "invalid render target size (%dx%d).", width, height);
+            }
+            if (!pActivedPool->CreateRenderTarget(name, width, height, true, true))
+                return luaL_error(L, "can't create render target with name '%s'.", name);
+
+            return 0;
+        }
         static int IsRenderTarget(lua_State* L)
         {
             Core::ScopeObject<IResourceTexture> p = LRES.FindTexture(luaL_checkstring(L, 1));
@@ -395,6 +445,9 @@ void LuaSTGPlus::LuaWrapper::ResourceMgrWrapper::Register(lua_State* L) noexcept
             Core::ScopeObject<IResourceTexture> p = LRES.FindTexture(luaL_checkstring(L, 1));
             if (p)
             {
+                // 临时渲染目标共用池中的纹理，修改会影响其他临时渲染目标
+                if (p->IsTransient())
+                    return luaL_error(L, "can't set the premultiplied alpha state of transient render target '%s'.", luaL_checkstring(L, 1));
                 p->GetTexture()->setPremultipliedAlpha(lua_toboolean(L, 2));
                 return 0;
             }
@@ -412,6 +465,11 @@ void LuaSTGPlus::LuaWrapper::ResourceMgrWrapper::Register(lua_State* L) noexcept
                     spdlog::error("[luastg] lstg.SetTextureSamplerState failed: can't find texture '{}'", tex_name);
                     return luaL_error(L, "can't find texture '%s'", tex_name.data());
                 }
+                if (p->IsTransient())
+                {
+                    spdlog::error("[luastg] lstg.SetTextureSamplerState failed: '{}' is a transient render target", tex_name);
+                    return luaL_error(L, "can't set the sampler state of transient render target '%s'", tex_name.data());
+                }
 
                 // 映射
                 Core::Graphics::IRenderer::SamplerState state = Core::Graphics::IRenderer::SamplerState::LinearClamp;
@@ -432,6 +490,14 @@ void LuaSTGPlus::LuaWrapper::ResourceMgrWrapper::Register(lua_State* L) noexcept
                 return luaL_error(L, "unsupported deprecated usage");
             }
         }
+        static int SetTextureAtlas(lua_State* L)
+        {
+            lua_Integer const max_size = luaL_optinteger(L, 2, (lua_Integer)LRES.GetTextureAtlasMaxSize());
+            if (max_size <= 0)
+                return luaL_error(L, "invalid argument #2 for 'SetTextureAtlas', requires a positive size.");
+            LRES.SetTextureAtlas(lua_toboolean(L, 1), (uint32_t)max_size);
+            return 0;
+        }
         static int GetTextureSize(lua_State* L)
         {
             const char* name = luaL_checkstring(L, 1);
@@ -670,6 +736,9 @@ void LuaSTGPlus::LuaWrapper::ResourceMgrWrapper::Register(lua_State* L) noexcept
         { "GetResourceStatus", &Wrapper::GetResourceStatus },
         { "LoadTexture", &Wrapper::LoadTexture },
         { "LoadTextureBin", &Wrapper::LoadTextureBin },
+        { "LoadTextureAsync", &Wrapper::LoadTextureAsync },
+        { "GetAsyncLoadProgress", &Wrapper::GetAsyncLoadProgress },
+        { "SetAsyncLoadBudget", &Wrapper::SetAsyncLoadBudget },
         { "LoadImage", &Wrapper::LoadSprite },
         { "LoadAnimation", &Wrapper::LoadAnimation },
         { "LoadPS", &Wrapper::LoadPS },
@@ -681,9 +750,11 @@ void LuaSTGPlus::LuaWrapper::ResourceMgrWrapper::Register(lua_State* L) noexcept
         { "LoadFX", &Wrapper::LoadFX },
         { "LoadModel", &Wrapper::LoadModel },
         { "CreateRenderTarget", &Wrapper::CreateRenderTarget },
+        { "CreateTransientRenderTarget", &Wrapper::CreateTransientRenderTarget },
         { "IsRenderTarget", &Wrapper::IsRenderTarget },
         { "SetTexturePreMulAlphaState", &Wrapper::SetTexturePreMulAlphaState },
         { "SetTextureSamplerState", &Wrapper::SetTextureSamplerState },
+        { "SetTextureAtlas", &Wrapper::SetTextureAtlas },
         { "GetTextureSize", &Wrapper::GetTextureSize },
         { "RemoveResource", &Wrapper::RemoveResource },
         { "CheckRes", &Wrapper::CheckRes },
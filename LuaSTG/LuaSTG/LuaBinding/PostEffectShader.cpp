@@ -113,6 +113,25 @@ namespace LuaSTG::LuaBinding
 				Create(L, shader.get());
 				return 1;
 			}
+			static int CreatePostEffectChain(lua_State* L)
+			{
+				lua::stack_t S(L);
+				int const count = lua_gettop(L);
+				luaL_argcheck(L, count > 0, 1, "at least one post effect stage is required");
+				std::vector<std::string_view> paths;
+				paths.reserve((size_t)count);
+				for (int i = 1; i <= count; i += 1)
+				{
+					paths.emplace_back(S.get_value<std::string_view>(i));
+				}
+				Core::ScopeObject<Core::Graphics::IPostEffectShader> shader;
+				if (!LAPP.GetRenderer2D()->createPostEffectChain(paths.data(), paths.size(), ~shader))
+				{
+					return luaL_error(L, "lstg.CreatePostEffectChain failed, see 'engine.log' for more detail");
+				}
+				Create(L, shader.get());
+				return 1;
+			}
 		};
 
 		luaL_Reg const lib[] = {
@@ -132,6 +151,7 @@ namespace LuaSTG::LuaBinding
 
 		luaL_Reg const fun[] = {
 			{ "CreatePostEffectShader", &Class::CreatePostEffectShader },
+			{ "CreatePostEffectChain", &Class::CreatePostEffectChain },
 			{ NULL, NULL },
 		};
 
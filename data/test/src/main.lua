@@ -117,6 +117,7 @@ require("test_ttf")
 require("test_object_resource")
 require("test_random")
 require("test_se")
+require("test_renderer_statistics")
 
 function GameInit()
     window:init()
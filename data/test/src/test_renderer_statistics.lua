@@ -0,0 +1,136 @@
+local test = require("test")
+
+-- Draws the same scene on every backend and compares the renderer statistics:
+-- the first run writes them to renderer_statistics.txt, a run on the other backend
+-- (config.json "target_graphics_device", "null" selects the null renderer) compares against it.
+-- The OpenGL build only counts with LUASTG_RENDERER_STATISTICS, delete the file to record again.
+
+local record_path = "renderer_statistics.txt"
+local sample_frame = 10
+
+local textures = { "block.png", "white.png", "image_1.png" }
+
+local function load_texture(f)
+    lstg.LoadTexture("tex:" .. f, "res/" .. f, false)
+    local w, h = lstg.GetTextureSize("tex:" .. f)
+    lstg.LoadImage("img:" .. f, "tex:" .. f, 0, 0, w, h)
+end
+local function unload_texture(f)
+    lstg.RemoveResource("global", 2, "img:" .. f)
+    lstg.RemoveResource("global", 1, "tex:" .. f)
+end
+
+---@param stat table
+---@return string[]
+local function format_statistics(stat)
+    return {
+        string.format("flush.buffer_full=%d", stat.flush.buffer_full),
+        string.format("flush.state_change=%d", stat.flush.state_change),
+        string.format("flush.render_target=%d", stat.flush.render_target),
+        string.format("flush.explicit=%d", stat.flush.explicit),
+        string.format("texture_bind=%d", stat.texture_bind),
+    }
+end
+
+---@param lines string[]
+local function write_record(lines)
+    local f = assert(io.open(record_path, "wb"))
+    f:write(table.concat(lines, "\n"), "\n")
+    f:close()
+end
+
+---@return string[]?
+local function read_record()
+    local f = io.open(record_path, "rb")
+    if not f then
+        return nil
+    end
+    local lines = {}
+    for line in f:lines() do
+        table.insert(lines, line)
+    end
+    f:close()
+    return lines
+end
+
+---@class test.Module.RendererStatistics : test.Base
+local M = {}
+
+function M:onCreate()
+    local old_pool = lstg.GetResourceStatus()
+    lstg.SetResourceStatus("global")
+    for _, f in ipairs(textures) do
+        load_texture(f)
+    end
+    lstg.CreateRenderTarget("rt:statistics")
+    lstg.SetResourceStatus(old_pool)
+    self.frame = 0
+end
+
+function M:onDestroy()
+    for _, f in ipairs(textures) do
+        lstg.SetImageState("img:" .. f, "", lstg.Color(255, 255, 255, 255))
+        unload_texture(f)
+    end
+    lstg.RemoveResource("global", 1, "rt:statistics")
+end
+
+function M:onUpdate()
+    self.frame = self.frame + 1
+    if self.frame ~= sample_frame then
+        return
+    end
+    -- statistics of the previous frame, the scene is the same every frame
+    local current = format_statistics(lstg.GetRendererStatistics())
+    local record = read_record()
+    if not record then
+        write_record(current)
+        lstg.Log(2, string.format("renderer statistics recorded to %s, run again on the other backend to compare", record_path))
+        return
+    end
+    local mismatch = 0
+    for i, line in ipairs(current) do
+        if record[i] ~= line then
+            lstg.Log(4, string.format("renderer statistics mismatch: expected '%s', got '%s'", tostring(record[i]), line))
+            mismatch = mismatch + 1
+        end
+    end
+    if mismatch == 0 then
+        lstg.Log(2, "renderer statistics match the recorded backend")
+    end
+end
+
+function M:onRender()
+    window:applyCameraV()
+    local scale = 0.25
+
+    -- texture switches inside one blend state
+    for i = 1, 12 do
+        local f = textures[(i - 1) % #textures + 1]
+        lstg.Render("img:" .. f, 80 * i, window.height / 4 * 3, 0, scale)
+    end
+
+    -- blend state changes
+    for i, f in ipairs(textures) do
+        lstg.SetImageState("img:" .. f, (i % 2 == 0) and "mul+add" or "", lstg.Color(255, 255, 255, 255))
+        lstg.Render("img:" .. f, 160 * i, window.height / 2, 0, scale)
+        lstg.SetImageState("img:" .. f, "", lstg.Color(255, 255, 255, 255))
+    end
+
+    -- render target switch
+    lstg.PushRenderTarget("rt:statistics")
+    lstg.RenderClear(lstg.Color(0, 0, 0, 0))
+    window:applyCameraV()
+    lstg.Render("img:block.png", window.width / 2, window.height / 2, 0, scale)
+    lstg.PopRenderTarget()
+    window:applyCameraV()
+    local w, h = lstg.GetTextureSize("rt:statistics")
+    local c = lstg.Color(255, 255, 255, 255)
+    lstg.RenderTexture("rt:statistics", "",
+        { 0, 0, 0.5, 0, h, c },
+        { window.width / 4, 0, 0.5, w, h, c },
+        { window.width / 4, window.height / 4, 0.5, w, 0, c },
+        { 0, window.height / 4, 0.5, 0, 0, c })
+end
+
+test.registerTest("test.Module.RendererStatistics", M)